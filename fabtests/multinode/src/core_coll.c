@@ -275,6 +275,62 @@ static int sum_all_reduce_test_run(enum fi_collective_op coll_op, enum fi_op op,
 	return -FI_ENOEQ;
 }
 
+/*
+ * Large enough to use the long message allreduce algorithms, and not a
+ * multiple of the rank count so that the blocks are uneven.
+ */
+static int sum_all_reduce_vector_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t *result, *data;
+	size_t count = 8192 + pm_job.num_ranks + 1;
+	uint64_t i, expect;
+	int err;
+
+	assert(coll_op == FI_ALLREDUCE);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	result = calloc(count, sizeof(*result));
+	data = malloc(count * sizeof(*data));
+	if (!result || !data) {
+		err = -FI_ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < count; i++)
+		data[i] = i * pm_job.num_ranks + pm_job.my_rank;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_allreduce(ep, data, count, NULL, result, NULL, coll_addr,
+		FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective allreduce failed - fi_allreduce", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		expect = i * pm_job.num_ranks * pm_job.num_ranks +
+			 pm_job.num_ranks * (pm_job.num_ranks - 1) / 2;
+		if (result[i] != expect) {
+			FT_DEBUG("allreduce failed at %ld; expect: %ld, "
+				 "actual: %ld\n", i, expect, result[i]);
+			err = -FI_ENOEQ;
+			goto out;
+		}
+	}
+
+out:
+	free(data);
+	free(result);
+	return err;
+}
+
 static int all_gather_test_run(enum fi_collective_op coll_op, enum fi_op op,
 		enum fi_datatype datatype)
 {
@@ -449,6 +505,204 @@ out:
 	return err;
 }
 
+static int sum_reduce_scatter_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t *data;
+	uint64_t result[2];
+	uint64_t expect;
+	uint64_t n = pm_job.num_ranks;
+	size_t count = 2;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_REDUCE_SCATTER);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	data = malloc(n * count * sizeof(*data));
+	if (!data)
+		return -FI_ENOMEM;
+
+	for (i = 0; i < n * count; i++)
+		data[i] = i * n + pm_job.my_rank;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_reduce_scatter(ep, data, count, NULL, result, NULL, coll_addr,
+				FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective reduce_scatter failed:", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		expect = (pm_job.my_rank * count + i) * n * n +
+			 n * (n - 1) / 2;
+		if (result[i] != expect) {
+			FT_DEBUG("reduce_scatter failed; expect[%ld]: %ld, "
+				 "actual[%ld]: %ld\n", i, expect, i, result[i]);
+			err = -1;
+			goto out;
+		}
+	}
+
+	err = FI_SUCCESS;
+
+out:
+	free(data);
+	return err;
+}
+
+static int alltoall_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t *data, *result;
+	uint64_t n = pm_job.num_ranks;
+	size_t count = 2;
+	uint64_t i, j, expect;
+	int err;
+
+	assert(coll_op == FI_ALLTOALL);
+	assert(datatype == FI_UINT64);
+
+	data = malloc(n * count * sizeof(*data));
+	if (!data)
+		return -FI_ENOMEM;
+
+	result = malloc(n * count * sizeof(*result));
+	if (!result) {
+		free(data);
+		return -FI_ENOMEM;
+	}
+
+	for (i = 0; i < n * count; i++)
+		data[i] = pm_job.my_rank * n * count + i;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_alltoall(ep, data, count, NULL, result, NULL, coll_addr,
+			  FI_UINT64, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective alltoall failed:", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < count; j++) {
+			expect = i * n * count + pm_job.my_rank * count + j;
+			if (result[i * count + j] != expect) {
+				FT_DEBUG("alltoall failed; expect: %ld, "
+					 "actual: %ld\n", expect,
+					 result[i * count + j]);
+				err = -1;
+				goto out;
+			}
+		}
+	}
+
+	err = FI_SUCCESS;
+
+out:
+	free(result);
+	free(data);
+	return err;
+}
+
+static int gather_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t *result = NULL;
+	uint64_t data = pm_job.my_rank;
+	fi_addr_t root = pm_job.num_ranks - 1;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_GATHER);
+	assert(datatype == FI_UINT64);
+
+	if (pm_job.my_rank == root) {
+		result = malloc(pm_job.num_ranks * sizeof(*result));
+		if (!result)
+			return -FI_ENOMEM;
+	}
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_gather(ep, &data, 1, NULL, result, NULL, coll_addr, root,
+			FI_UINT64, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective gather failed:", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err || pm_job.my_rank != root)
+		goto out;
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		if (result[i] != i) {
+			FT_DEBUG("gather failed; expect[%ld]: %ld, "
+				 "actual[%ld]: %ld\n", i, i, i, result[i]);
+			err = -1;
+			goto out;
+		}
+	}
+
+	err = FI_SUCCESS;
+
+out:
+	free(result);
+	return err;
+}
+
+static int sum_reduce_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t result = 0;
+	uint64_t expect_result = 0;
+	uint64_t data = pm_job.my_rank;
+	fi_addr_t root = pm_job.num_ranks / 2;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_REDUCE);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	for (i = 0; i < pm_job.num_ranks; i++)
+		expect_result += i;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_reduce(ep, &data, 1, NULL, &result, NULL, coll_addr, root,
+			FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective reduce failed:", err);
+		return err;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err || pm_job.my_rank != root)
+		return err;
+
+	if (result != expect_result) {
+		FT_DEBUG("reduce failed; expect: %ld, actual: %ld\n",
+			 expect_result, result);
+		return -1;
+	}
+
+	return FI_SUCCESS;
+}
+
 struct coll_test tests[] = {
 	{
 		.name = "join_test",
@@ -486,6 +740,15 @@ struct coll_test tests[] = {
 		.op = FI_SUM,
 		.datatype = FI_UINT64,
 	},
+	{
+		.name = "sum_all_reduce_vector_test",
+		.setup = coll_setup,
+		.run = sum_all_reduce_vector_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_ALLREDUCE,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
 	{
 		.name = "all_gather_test",
 		.setup = coll_setup,
@@ -513,6 +776,42 @@ struct coll_test tests[] = {
 		.op = FI_NOOP,
 		.datatype = FI_UINT64
 	},
+	{
+		.name = "sum_reduce_scatter_test",
+		.setup = coll_setup,
+		.run = sum_reduce_scatter_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_REDUCE_SCATTER,
+		.op = FI_SUM,
+		.datatype = FI_UINT64
+	},
+	{
+		.name = "alltoall_test",
+		.setup = coll_setup,
+		.run = alltoall_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_ALLTOALL,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64
+	},
+	{
+		.name = "gather_test",
+		.setup = coll_setup,
+		.run = gather_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_GATHER,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64
+	},
+	{
+		.name = "sum_reduce_test",
+		.setup = coll_setup,
+		.run = sum_reduce_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_REDUCE,
+		.op = FI_SUM,
+		.datatype = FI_UINT64
+	},
 	{
 		.name = "empty_test_to_stop_the_sequence_of_execution",
 		.run = NULL,
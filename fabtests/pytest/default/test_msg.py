@@ -42,3 +42,18 @@ def test_msg_bw(cmdline_args, iteration_type, datacheck_type):
     test = ClientServerTest(cmdline_args, "fi_msg_bw", iteration_type,
                             datacheck_type=datacheck_type)
     test.run()
+
+# Completions of sharded tcp endpoints are reported by the shard progress
+# threads, which must wake up a thread blocked in fi_cntr_wait.
+@pytest.mark.functional
+def test_msg_pingpong_cntr_sread(cmdline_args):
+    import copy
+    from common import ClientServerTest
+    if cmdline_args.provider != "tcp":
+        pytest.skip("tcp progress threads only")
+
+    cmdline_args_copy = copy.copy(cmdline_args)
+    cmdline_args_copy.append_environ("FI_TCP_PROGRESS_THREADS=2")
+    test = ClientServerTest(cmdline_args_copy,
+                            "fi_msg_pingpong -t counter -c sread -I 100")
+    test.run()
@@ -24,3 +24,20 @@ def test_multinode_coll(cmdline_args):
     test = MultinodeTest(cmdline_args, server_base_command, client_base_command,
                          client_hostname_list, run_client_asynchronously=True)
     test.run()
+
+# Treat every two ranks as one node, so that allreduce and barrier run
+# the hierarchical algorithms even when all ranks share a host.
+@pytest.mark.multinode
+def test_multinode_coll_hier(cmdline_args):
+    import copy
+
+    numproc = 3
+    cmdline_args_copy = copy.copy(cmdline_args)
+    cmdline_args_copy.append_environ("FI_OFF_COLL_RANKS_PER_NODE=2")
+    client_hostname_list = [cmdline_args.client_id, ] * (numproc - 1)
+    client_base_command = "fi_multinode_coll"
+    server_base_command = client_base_command
+    test = MultinodeTest(cmdline_args_copy, server_base_command,
+                         client_base_command, client_hostname_list,
+                         run_client_asynchronously=True)
+    test.run()
@@ -39,6 +39,7 @@
 #include <limits.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <rdma/fi_ext.h>
 
 #include "unit_common.h"
 #include "shared.h"
@@ -729,12 +730,136 @@ static int mr_cache_rocr_test(void)
 	return ret;
 }
 
+static size_t env_to_size(const char *name, size_t def)
+{
+	char *val = getenv(name);
+
+	return val ? strtoul(val, NULL, 10) : def;
+}
+
+/* Verify the MR cache reclaim thread prunes the cache once it fills. Each
+ * region is registered and closed in turn so that it moves to the LRU list.
+ * The cache never evicts inline when reclaim is enabled, so the cached count
+ * dropping below the limit shows that the background thread freed entries.
+ */
+static int mr_cache_reclaim_test(void)
+{
+	struct fi_mr_cache_stats stats = { 0 };
+	struct fi_fid_var var = {
+		.name = FI_MR_CACHE_STATS,
+		.val = &stats,
+	};
+	struct fid *cache_fid = NULL;
+	struct fid_mr *mr;
+	char *buf = MAP_FAILED;
+	char *reclaim;
+	size_t max_cnt, len = 0, i;
+	int64_t elapsed;
+	int testret = FAIL;
+	int ret;
+
+	reclaim = getenv("FI_MR_CACHE_RECLAIM");
+	if (!reclaim || !(!strcmp(reclaim, "1") ||
+			  !strcasecmp(reclaim, "yes") ||
+			  !strcasecmp(reclaim, "true") ||
+			  !strcasecmp(reclaim, "on"))) {
+		sprintf(err_buf, "FI_MR_CACHE_RECLAIM not enabled");
+		return SKIPPED;
+	}
+
+	max_cnt = env_to_size("FI_MR_CACHE_MAX_COUNT", 1024);
+	if (!max_cnt) {
+		sprintf(err_buf, "MR cache disabled");
+		return SKIPPED;
+	}
+
+	/* Reallocate the domain to reset the MR cache. */
+	ret = fi_close(&domain->fid);
+	if (ret) {
+		FT_UNIT_STRERR(err_buf, "Failed to close the domain", ret);
+		domain = NULL;
+		goto cleanup;
+	}
+
+	ret = fi_domain(fabric, fi, &domain, NULL);
+	if (ret) {
+		FT_UNIT_STRERR(err_buf, "fi_domain failed", ret);
+		domain = NULL;
+		goto cleanup;
+	}
+
+	ret = fi_open(FT_FIVERSION, "mr_cache", NULL, 0, 0, &cache_fid, NULL);
+	if (ret) {
+		FT_UNIT_STRERR(err_buf, "fi_open mr_cache failed", ret);
+		goto cleanup;
+	}
+
+	/* Leave a gap between regions so the cache cannot merge them. */
+	len = mr_buf_size * 2 * (max_cnt + 1);
+	buf = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED) {
+		ret = -errno;
+		FT_UNIT_STRERR(err_buf, "mmap failed", ret);
+		goto cleanup;
+	}
+
+	for (i = 0; i <= max_cnt; i++) {
+		ret = mr_register(buf + i * mr_buf_size * 2, &mr, &elapsed,
+				  FI_HMEM_SYSTEM);
+		if (ret) {
+			FT_UNIT_STRERR(err_buf, "mr_register failed", ret);
+			goto cleanup;
+		}
+		fi_close(&mr->fid);
+	}
+
+	for (i = 0; i < 500; i++) {
+		ret = fi_control(cache_fid, FI_GET_VAL, &var);
+		if (ret) {
+			FT_UNIT_STRERR(err_buf, "FI_MR_CACHE_STATS failed", ret);
+			goto cleanup;
+		}
+
+		if (!stats.searches) {
+			ret = -FI_ENOSYS;
+			sprintf(err_buf, "Provider does not use the MR cache");
+			goto cleanup;
+		}
+
+		if (stats.evictions && stats.cached_cnt < max_cnt)
+			break;
+		usleep(10000);
+	}
+
+	FT_DEBUG("Evictions: %" PRIu64 " cached: %" PRIu64,
+		 stats.evictions, stats.cached_cnt);
+
+	if (i == 500) {
+		ret = -FI_ETIMEDOUT;
+		FT_UNIT_STRERR(err_buf,
+			       "MR cache not reclaimed below its limit", ret);
+	} else {
+		testret = PASS;
+	}
+
+cleanup:
+	if (buf != MAP_FAILED)
+		munmap(buf, len);
+
+	if (cache_fid)
+		fi_close(cache_fid);
+
+	return TEST_RET_VAL(ret, testret);
+}
+
 struct test_entry test_array[] = {
 	TEST_ENTRY(mr_cache_mmap_test, "MR cache eviction test using MMAP"),
 	TEST_ENTRY(mr_cache_brk_test, "MR cache eviction test using BRK"),
 	TEST_ENTRY(mr_cache_sbrk_test, "MR cache eviction test using SBRK"),
 	TEST_ENTRY(mr_cache_cuda_test, "MR cache eviction test using CUDA"),
 	TEST_ENTRY(mr_cache_rocr_test, "MR cache eviction test using ROCR"),
+	TEST_ENTRY(mr_cache_reclaim_test, "MR cache background reclaim test"),
 	{ NULL, "" }
 };
 
@@ -744,7 +869,8 @@ static void usage(char *name)
 		"Test a provider's ability to evict MR cache entries.\n"
 		"Evictions are verified using MMAP, BRK, SBRK, CUDA and ROCR\n"
 		"allocations. FI_HMEM support must be enabled to run CUDA and\n"
-		"ROCR tests.\n\n"
+		"ROCR tests. The background reclaim test runs when\n"
+		"FI_MR_CACHE_RECLAIM is enabled.\n\n"
 		"With debug enabled, when running as root, the physical \n"
 		"address of the first page of the MMAP, BRK, and SBRK \n"
 		"allocation is returned. This can be used to verify the \n"
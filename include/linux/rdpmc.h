@@ -19,6 +19,7 @@
 
 #if HAVE_LINUX_PERF_RDPMC
 
+#include <stdbool.h>
 #include <linux/perf_event.h>
 #include <ofi_perf.h>
 
@@ -37,6 +38,7 @@ unsigned long long rdpmc_read(struct rdpmc_ctx *ctx);
 
 struct ofi_perf_ctx {
 	struct rdpmc_ctx ctx;
+	bool tsc;
 };
 
 
@@ -220,6 +220,9 @@ enum {
 };
 
 int ofi_cpu_supports(unsigned func, unsigned reg, unsigned bit);
+/* Also checks that the OS saves the vector state */
+bool ofi_cpu_has_avx2(void);
+bool ofi_cpu_has_avx512(void);
 
 
 enum ofi_prov_type {
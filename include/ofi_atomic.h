@@ -78,14 +78,31 @@ extern void (*ofi_atomic_swap_handlers[OFI_SWAP_OP_CNT][OFI_DATATYPE_CNT])
 			(void *dst, const void *src, const void *cmp,
 			 void *res, size_t cnt);
 
+extern void (*ofi_atomic_reduce_handlers[OFI_WRITE_OP_CNT][OFI_DATATYPE_CNT])
+			(void *dst, const void *src, size_t cnt);
+
+/*
+ * The reduce handlers are vectorized where possible, but not atomic per
+ * element.  Use them for buffers owned by the caller.  Without built-in
+ * atomics the write handlers are not atomic either, so they map onto the
+ * faster kernels.
+ */
+#define ofi_atomic_reduce_handler(op, datatype, dst, src, cnt) \
+	ofi_atomic_reduce_handlers[op][datatype](dst, src, cnt)
+#ifdef HAVE_BUILTIN_MM_ATOMICS
 #define ofi_atomic_write_handler(op, datatype, dst, src, cnt) \
 	ofi_atomic_write_handlers[op][datatype](dst, src, cnt)
+#else
+#define ofi_atomic_write_handler(op, datatype, dst, src, cnt) \
+	ofi_atomic_reduce_handler(op, datatype, dst, src, cnt)
+#endif
 #define ofi_atomic_readwrite_handler(op, datatype, dst, src, res, cnt) \
 	ofi_atomic_readwrite_handlers[op][datatype](dst, src, res, cnt)
 #define ofi_atomic_swap_handler(op, datatype, dst, src, cmp, res, cnt) \
 	ofi_atomic_swap_handlers[op - OFI_SWAP_OP_START][datatype](dst, src, \
 								cmp, res, cnt)
 
+void ofi_atomic_init(void);
 int ofi_atomic_valid(const struct fi_provider *prov,
 		     enum fi_datatype datatype, enum fi_op op, uint64_t flags);
 
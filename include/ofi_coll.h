@@ -50,6 +50,10 @@ enum util_coll_op_type {
 	UTIL_COLL_BROADCAST_OP,
 	UTIL_COLL_ALLGATHER_OP,
 	UTIL_COLL_SCATTER_OP,
+	UTIL_COLL_REDUCE_SCATTER_OP,
+	UTIL_COLL_ALLTOALL_OP,
+	UTIL_COLL_GATHER_OP,
+	UTIL_COLL_REDUCE_OP,
 };
 
 static const char * const log_util_coll_op_type[] = {
@@ -58,7 +62,11 @@ static const char * const log_util_coll_op_type[] = {
 	[UTIL_COLL_ALLREDUCE_OP] = "COLL_ALLREDUCE",
 	[UTIL_COLL_BROADCAST_OP] = "COLL_BROADCAST",
 	[UTIL_COLL_ALLGATHER_OP] = "COLL_ALLGATHER",
-	[UTIL_COLL_SCATTER_OP] = "COLL_SCATTER"
+	[UTIL_COLL_SCATTER_OP] = "COLL_SCATTER",
+	[UTIL_COLL_REDUCE_SCATTER_OP] = "COLL_REDUCE_SCATTER",
+	[UTIL_COLL_ALLTOALL_OP] = "COLL_ALLTOALL",
+	[UTIL_COLL_GATHER_OP] = "COLL_GATHER",
+	[UTIL_COLL_REDUCE_OP] = "COLL_REDUCE",
 };
 
 enum coll_work_type {
@@ -90,6 +98,9 @@ struct util_coll_work_item {
 	enum coll_work_type		type;
 	enum coll_state			state;
 	int				fence;
+	/* position in the schedule, and an earlier item to wait for */
+	uint64_t			id;
+	uint64_t			dep;
 };
 
 struct util_coll_xfer_item {
@@ -126,7 +137,7 @@ struct join_data {
 
 struct barrier_data {
 	uint64_t data;
-	uint64_t tmp;
+	uint64_t tmp[2];
 };
 
 struct allreduce_data {
@@ -140,6 +151,28 @@ struct broadcast_data {
 	void	*scatter;
 };
 
+/*
+ * The ranks of a multicast group an algorithm runs over.  ranks maps
+ * group positions to mc ranks, NULL meaning all of mc in order.
+ */
+struct util_coll_group {
+	uint64_t	*ranks;
+	uint64_t	size;
+	uint64_t	rank;
+};
+
+/*
+ * Ranks on the local node and the lowest rank of every node, used to
+ * split collectives into intra-node and inter-node phases.  The local
+ * rank is UTIL_COLL_NO_RANK in leaders unless it leads its node.
+ */
+#define UTIL_COLL_NO_RANK UINT64_MAX
+
+struct util_coll_topo {
+	struct util_coll_group	node;
+	struct util_coll_group	leaders;
+};
+
 struct util_coll_operation;
 
 typedef void (*util_coll_comp_fn_t)(struct util_coll_operation *coll_op);
@@ -150,6 +183,8 @@ struct util_coll_operation {
 	struct fid_ep			*ep;
 	struct util_coll_mc		*mc;
 	struct dlist_entry		work_queue;
+	uint64_t			last_id;
+	struct util_coll_group		group;
 
 	union {
 		struct join_data	join;
@@ -157,6 +192,10 @@ struct util_coll_operation {
 		struct allreduce_data	allreduce;
 		void			*scatter;
 		struct broadcast_data	broadcast;
+		void			*reduce_scatter;
+		void			*alltoall;
+		void			*gather;
+		void			*reduce;
 	} data;
 	util_coll_comp_fn_t		comp_fn;
 	uint64_t			flags;
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _OFI_COPY_H_
+#define _OFI_COPY_H_
+
+#include "config.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Host memory copy kernels
+ *
+ * Copies of at least ofi_copy_threshold bytes go through the kernel
+ * selected by ofi_copy_init(), normally one that uses non-temporal
+ * stores so that large buffers, which are only read again by another
+ * process, do not evict the caller's working set.  Smaller copies use
+ * memcpy, which already picks rep movsb or vector moves for cached data.
+ */
+typedef void *(*ofi_copy_fn)(void *dest, const void *src, size_t len);
+
+extern size_t ofi_copy_threshold;
+extern ofi_copy_fn ofi_copy_kernel;
+extern const char *ofi_copy_kernel_name;
+
+/* kernel may be NULL or "auto", threshold 0 selects a cache based default */
+int ofi_copy_init(const char *kernel, size_t threshold);
+
+static inline void *ofi_copy(void *dest, const void *src, size_t len)
+{
+	if (len >= ofi_copy_threshold)
+		return ofi_copy_kernel(dest, src, len);
+	return memcpy(dest, src, len);
+}
+
+#endif /* _OFI_COPY_H_ */
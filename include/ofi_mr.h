@@ -306,6 +306,9 @@ int ofi_mr_verify(struct ofi_mr_map *map, ssize_t len,
 struct ofi_mr_cache_params {
 	size_t				max_cnt;
 	size_t				max_size;
+	size_t				shard_cnt;
+	int				reclaim;
+	int				reclaim_watermark;
 	char *				monitor;
 	int				cuda_monitor_enabled;
 	int				rocr_monitor_enabled;
@@ -316,16 +319,34 @@ extern struct ofi_mr_cache_params	cache_params;
 
 #define OFI_HMEM_MAX 6
 
-struct ofi_mr_cache {
-	struct util_domain		*domain;
-	struct ofi_mem_monitor		*monitors[OFI_HMEM_MAX];
-	struct dlist_entry		notify_entries[OFI_HMEM_MAX];
-	size_t				entry_data_size;
+#define OFI_MR_CACHE_MAX_SHARDS		64
+#define OFI_MR_CACHE_SHARD_SHIFT	24
+
+struct ofi_mr_cache_stats {
+	size_t				cached_cnt;
+	size_t				cached_size;
+	size_t				uncached_cnt;
+	size_t				uncached_size;
+	size_t				search_cnt;
+	size_t				delete_cnt;
+	size_t				hit_cnt;
+	size_t				notify_cnt;
+	size_t				evict_cnt;
+	size_t				deferred_free_cnt;
+};
 
+/* Regions are assigned to a shard based on their starting address, with
+ * each shard covering interleaved OFI_MR_CACHE_SHARD_SHIFT sized slices
+ * of the address space.  The shard lock protects the tree, lists and
+ * counters of the shard and nests inside mm_lock.  Regions cached in
+ * different shards may overlap.  Each shard is limited to its share of
+ * the cache_params max_cnt and max_size limits.
+ */
+struct ofi_mr_cache_shard {
 	struct ofi_rbmap		tree;
 	struct dlist_entry		lru_list;
 	struct dlist_entry		dead_region_list;
-	pthread_mutex_t 		lock;
+	pthread_mutex_t			lock;
 
 	size_t				cached_cnt;
 	size_t				cached_size;
@@ -334,9 +355,42 @@ struct ofi_mr_cache {
 	size_t				search_cnt;
 	size_t				delete_cnt;
 	size_t				hit_cnt;
+	size_t				evict_cnt;
+} __attribute__((aligned(64)));
+
+struct ofi_mr_cache {
+	struct util_domain		*domain;
+	struct ofi_mem_monitor		*monitors[OFI_HMEM_MAX];
+	struct dlist_entry		notify_entries[OFI_HMEM_MAX];
+	size_t				entry_data_size;
+
+	struct ofi_mr_cache_shard	*shards;
+	size_t				shard_cnt;
+	size_t				shard_max_cnt;
+	size_t				shard_max_size;
+	pthread_mutex_t 		lock;
+
+	/* protected by mm_lock */
 	size_t				notify_cnt;
 	struct ofi_bufpool		*entry_pool;
 
+	/* Background reclaim of dead and LRU regions, see FI_MR_CACHE_RECLAIM.
+	 * When enabled, the LRU of each shard is trimmed to the low watermark
+	 * and freed regions are deregistered by the reclaim thread.
+	 */
+	bool				reclaim;
+	bool				reclaim_stop;
+	ofi_atomic32_t			reclaim_pending;
+	pthread_t			reclaim_thread;
+	pthread_mutex_t			reclaim_lock;
+	pthread_cond_t			reclaim_cond;
+	size_t				shard_low_cnt;
+	size_t				shard_low_size;
+	/* protected by reclaim_lock */
+	size_t				deferred_free_cnt;
+
+	struct dlist_entry		list_entry;
+
 	int				(*add_region)(struct ofi_mr_cache *cache,
 						      struct ofi_mr_entry *entry);
 	void				(*delete_region)(struct ofi_mr_cache *cache,
@@ -349,6 +403,8 @@ int ofi_mr_cache_init(struct util_domain *domain,
 void ofi_mr_cache_cleanup(struct ofi_mr_cache *cache);
 
 void ofi_mr_cache_notify(struct ofi_mr_cache *cache, const void *addr, size_t len);
+void ofi_mr_cache_get_stats(struct ofi_mr_cache *cache,
+			    struct ofi_mr_cache_stats *stats);
 
 int ofi_ipc_cache_open(struct ofi_mr_cache **cache,
 			struct util_domain *domain);
@@ -357,10 +413,25 @@ int  ofi_ipc_cache_search(struct ofi_mr_cache *cache, uint64_t peer_id,
 			  struct ipc_info *ipc_info,
 			  struct ofi_mr_entry **mr_entry);
 
-static inline bool ofi_mr_cache_full(struct ofi_mr_cache *cache)
+static inline struct ofi_mr_cache_shard *
+ofi_mr_cache_shard(struct ofi_mr_cache *cache, const void *addr)
+{
+	return &cache->shards[((uintptr_t) addr >> OFI_MR_CACHE_SHARD_SHIFT) %
+			      cache->shard_cnt];
+}
+
+static inline bool ofi_mr_cache_full(struct ofi_mr_cache *cache,
+				     struct ofi_mr_cache_shard *shard)
+{
+	return (shard->cached_cnt >= cache->shard_max_cnt) ||
+	       (shard->cached_size >= cache->shard_max_size);
+}
+
+static inline bool ofi_mr_cache_above_low(struct ofi_mr_cache *cache,
+					  struct ofi_mr_cache_shard *shard)
 {
-	return (cache->cached_cnt >= cache_params.max_cnt) ||
-	       (cache->cached_size >= cache_params.max_size);
+	return (shard->cached_cnt > cache->shard_low_cnt) ||
+	       (shard->cached_size > cache->shard_low_size);
 }
 
 bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru);
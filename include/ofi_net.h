@@ -152,13 +152,45 @@ typedef struct {
 struct ofi_sockctx {
 	void *context;
 	bool uring_sqe_inuse;
+#ifdef HAVE_LIBURING
+	/* Must remain valid until a sendmsg SQE is submitted */
+	struct msghdr uring_msg;
+#endif
 };
 
+/* Sockets may be registered with the ring as fixed files, with a staging
+ * buffer registered as a fixed buffer.  Both tables are indexed by the
+ * socket, which avoids a separate lookup when preparing SQEs.
+ */
 struct ofi_sockapi_uring {
 	ofi_io_uring_t *io_uring;
 	uint64_t credits;
+	unsigned int fixed_cnt;
+	uint8_t *fixed_files;
+	struct iovec *fixed_bufs;
+	bool send_zc;
+};
+
+/* Ring of receive buffers registered with the kernel.  Multishot receives
+ * select a buffer from the ring, and the buffer id is reported in the
+ * completion flags.  Buffers must be returned to the ring once consumed.
+ */
+struct ofi_uring_buf_ring {
+	void *ring;
+	uint8_t *bufs;
+	size_t buf_size;
+	unsigned int count;
+	unsigned int mask;
+	uint16_t bgid;
 };
 
+static inline void *
+ofi_uring_buf_ring_buf(struct ofi_uring_buf_ring *buf_ring, unsigned int bid)
+{
+	assert(bid < buf_ring->count);
+	return buf_ring->bufs + (size_t) bid * buf_ring->buf_size;
+}
+
 struct ofi_sockapi {
 	struct ofi_sockapi_uring tx_uring;
 	struct ofi_sockapi_uring rx_uring;
@@ -321,9 +353,29 @@ int ofi_sockctx_uring_cancel(struct ofi_sockapi_uring *uring,
 int ofi_sockctx_uring_poll_add(struct ofi_sockapi_uring *uring,
 			       int fd, short poll_mask, bool multishot,
 			       struct ofi_sockctx *ctx);
+int ofi_sockctx_uring_recv_multishot(struct ofi_sockapi_uring *uring, int fd,
+				     struct ofi_uring_buf_ring *buf_ring,
+				     struct ofi_sockctx *ctx);
 
 int ofi_uring_init(ofi_io_uring_t *io_uring, size_t entries);
 int ofi_uring_destroy(ofi_io_uring_t *io_uring);
+bool ofi_uring_send_zc_supported(ofi_io_uring_t *io_uring);
+
+int ofi_sockapi_uring_init_fixed(struct ofi_sockapi_uring *uring,
+				 unsigned int count);
+void ofi_sockapi_uring_cleanup_fixed(struct ofi_sockapi_uring *uring);
+int ofi_sockapi_uring_register(struct ofi_sockapi_uring *uring, SOCKET sock,
+			       void *buf, size_t len);
+void ofi_sockapi_uring_unregister(struct ofi_sockapi_uring *uring,
+				  SOCKET sock);
+
+int ofi_uring_buf_ring_init(ofi_io_uring_t *io_uring,
+			    struct ofi_uring_buf_ring *buf_ring, uint16_t bgid,
+			    unsigned int count, size_t buf_size);
+void ofi_uring_buf_ring_destroy(ofi_io_uring_t *io_uring,
+				struct ofi_uring_buf_ring *buf_ring);
+void ofi_uring_buf_ring_recycle(struct ofi_uring_buf_ring *buf_ring,
+				unsigned int bid);
 
 static inline int ofi_uring_get_fd(ofi_io_uring_t *io_uring)
 {
@@ -361,8 +413,15 @@ static inline void ofi_uring_cq_advance(ofi_io_uring_t *io_uring, unsigned int c
 {
 	io_uring_cq_advance(io_uring, count);
 }
+
+#ifndef IORING_CQE_F_NOTIF
+#define IORING_CQE_F_NOTIF	(1U << 3)
+#endif
 #else
+#define IORING_CQE_F_BUFFER	(1U << 0)
 #define IORING_CQE_F_MORE	(1U << 1)
+#define IORING_CQE_F_NOTIF	(1U << 3)
+#define IORING_CQE_BUFFER_SHIFT	16
 
 static inline int
 ofi_sockapi_connect_uring(struct ofi_sockapi *sockapi, SOCKET sock,
@@ -427,6 +486,31 @@ ofi_sockctx_uring_poll_add(struct ofi_sockapi_uring *uring,
 	return -FI_ENOSYS;
 }
 
+static inline int
+ofi_sockctx_uring_recv_multishot(struct ofi_sockapi_uring *uring, int fd,
+				 struct ofi_uring_buf_ring *buf_ring,
+				 struct ofi_sockctx *ctx)
+{
+	return -FI_ENOSYS;
+}
+
+#define ofi_uring_send_zc_supported(io_uring) false
+#define ofi_sockapi_uring_init_fixed(uring, count) -FI_ENOSYS
+#define ofi_sockapi_uring_cleanup_fixed(uring) do {} while(0)
+static inline int
+ofi_sockapi_uring_register(struct ofi_sockapi_uring *uring, SOCKET sock,
+			   void *buf, size_t len)
+{
+	return -FI_ENOSYS;
+}
+static inline void
+ofi_sockapi_uring_unregister(struct ofi_sockapi_uring *uring, SOCKET sock)
+{
+}
+#define ofi_uring_buf_ring_init(io_uring, buf_ring, bgid, count, buf_size) \
+	-FI_ENOSYS
+#define ofi_uring_buf_ring_destroy(io_uring, buf_ring) do {} while(0)
+#define ofi_uring_buf_ring_recycle(buf_ring, bid) do {} while(0)
 #define ofi_uring_init(io_uring, entries) -FI_ENOSYS
 #define ofi_uring_destroy(io_uring) -FI_ENOSYS
 #define ofi_uring_get_fd(io_uring) INVALID_SOCKET
@@ -542,6 +626,11 @@ struct ofi_bsock {
 	uint32_t async_index;
 	uint32_t done_index;
 	bool async_prefetch;
+	/* Received data is only delivered to rq through a multishot
+	 * receive, see ofi_bsock_prefetch_write().  The socket is never
+	 * read directly.
+	 */
+	bool multishot;
 };
 
 static inline void
@@ -557,6 +646,7 @@ ofi_bsock_init(struct ofi_bsock *bsock, struct ofi_sockapi *sockapi,
 	ofi_byteq_init(&bsock->rq, rbuf_size);
 	bsock->zerocopy_size = SIZE_MAX;
 	bsock->async_prefetch = false;
+	bsock->multishot = false;
 
 	/* first async op will wrap back to 0 as the starting index */
 	bsock->async_index = UINT32_MAX;
@@ -610,6 +700,29 @@ uint32_t ofi_bsock_async_done(const struct fi_provider *prov,
 			      struct ofi_bsock *bsock);
 void ofi_bsock_prefetch_done(struct ofi_bsock *bsock, size_t len);
 
+/* Copy data received outside of the socket APIs, such as into an io_uring
+ * provided buffer, into the prefetch buffer.  Returns the number of bytes
+ * copied, which is less than len if the prefetch buffer is full.
+ */
+static inline size_t
+ofi_bsock_prefetch_write(struct ofi_bsock *bsock, const void *buf, size_t len)
+{
+	struct ofi_byteq *rq = &bsock->rq;
+	size_t avail;
+
+	avail = ofi_byteq_readable(rq);
+	if (ofi_byteq_writeable(rq) < len && rq->head) {
+		memmove(rq->data, &rq->data[rq->head], avail);
+		rq->head = 0;
+		rq->tail = (unsigned) avail;
+	}
+
+	len = MIN(len, ofi_byteq_writeable(rq));
+	if (len)
+		ofi_byteq_write(rq, buf, len);
+	return len;
+}
+
 
 /*
  * Address utility functions
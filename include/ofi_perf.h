@@ -62,6 +62,7 @@ enum {
 enum {
 	OFI_PMC_CPU_CYCLES,
 	OFI_PMC_CPU_INSTR,
+	OFI_PMC_CPU_TSC,
 };
 
 enum {
@@ -83,11 +84,41 @@ struct ofi_perf_data {
 	uint64_t	events;
 };
 
+/*
+ * Log-linear histogram: values below 2^OFI_PERF_HIST_SUB_BITS have a
+ * bucket each, and every power of two range above that is split into
+ * 2^OFI_PERF_HIST_SUB_BITS linear buckets, bounding the relative error
+ * of a reported percentile to 1/8.
+ */
+#define OFI_PERF_HIST_SUB_BITS	3
+#define OFI_PERF_HIST_SIZE	((64 - OFI_PERF_HIST_SUB_BITS + 1) << \
+				 OFI_PERF_HIST_SUB_BITS)
+
+enum ofi_perf_hist_mode {
+	OFI_PERF_HIST_NONE,
+	OFI_PERF_HIST_OP,	/* one histogram per counter */
+	OFI_PERF_HIST_SIZE_BUCKET, /* split by transfer size */
+};
+
+enum ofi_perf_size {
+	OFI_PERF_SIZE_0_64,
+	OFI_PERF_SIZE_64_512,
+	OFI_PERF_SIZE_512_1K,
+	OFI_PERF_SIZE_1K_4K,
+	OFI_PERF_SIZE_4K_64K,
+	OFI_PERF_SIZE_64K_256K,
+	OFI_PERF_SIZE_256K_1M,
+	OFI_PERF_SIZE_1M_4M,
+	OFI_PERF_SIZE_4M_UP,
+	OFI_PERF_SIZE_MAX
+};
 
 void ofi_perf_init(void);
 extern enum ofi_perf_domain	perf_domain;
 extern uint32_t			perf_cntr;
 extern uint32_t			perf_flags;
+extern enum ofi_perf_hist_mode	perf_hist;
+extern int			perf_dump_signal;
 
 
 /*
@@ -133,6 +164,44 @@ static inline void ofi_pmu_close(struct ofi_perf_ctx *ctx)
 #endif /* HAVE_LINUX_PERF_RDPMC */
 
 
+static inline size_t ofi_perf_hist_index(uint64_t value)
+{
+	int msb;
+
+	if (value < (1 << OFI_PERF_HIST_SUB_BITS))
+		return (size_t) value;
+
+	msb = 63 - __builtin_clzll(value);
+	return ((size_t) (msb - OFI_PERF_HIST_SUB_BITS + 1) <<
+		OFI_PERF_HIST_SUB_BITS) +
+	       ((value >> (msb - OFI_PERF_HIST_SUB_BITS)) &
+		((1 << OFI_PERF_HIST_SUB_BITS) - 1));
+}
+
+uint64_t ofi_perf_hist_percentile(const uint64_t *hist, uint64_t events,
+				  double pct);
+
+static inline enum ofi_perf_size ofi_perf_size_bucket(size_t len)
+{
+	if (len <= 64)
+		return OFI_PERF_SIZE_0_64;
+	if (len <= 512)
+		return OFI_PERF_SIZE_64_512;
+	if (len <= 1024)
+		return OFI_PERF_SIZE_512_1K;
+	if (len <= 4096)
+		return OFI_PERF_SIZE_1K_4K;
+	if (len <= 65536)
+		return OFI_PERF_SIZE_4K_64K;
+	if (len <= 262144)
+		return OFI_PERF_SIZE_64K_256K;
+	if (len <= 1048576)
+		return OFI_PERF_SIZE_256K_1M;
+	if (len <= 4194304)
+		return OFI_PERF_SIZE_1M_4M;
+	return OFI_PERF_SIZE_4M_UP;
+}
+
 static inline void ofi_perf_reset(struct ofi_perf_data *data)
 {
 	memset(data, 0, sizeof *data);
@@ -144,11 +213,15 @@ static inline void ofi_perf_start(struct ofi_perf_ctx *ctx,
 	data->start = ofi_pmu_read(ctx);
 }
 
-static inline void ofi_perf_end(struct ofi_perf_ctx *ctx,
-				struct ofi_perf_data *data)
+static inline uint64_t ofi_perf_end(struct ofi_perf_ctx *ctx,
+				    struct ofi_perf_data *data)
 {
-	data->sum += ofi_pmu_read(ctx) - data->start;
+	uint64_t delta;
+
+	delta = ofi_pmu_read(ctx) - data->start;
+	data->sum += delta;
 	data->events++;
+	return delta;
 }
 
 
@@ -157,6 +230,10 @@ struct ofi_perfset {
 	size_t			size;
 	struct ofi_perf_ctx	*ctx;
 	struct ofi_perf_data	*data;
+
+	/* size * hist_slots histograms of OFI_PERF_HIST_SIZE buckets */
+	size_t			hist_slots;
+	uint64_t		*hist;
 };
 
 int ofi_perfset_create(const struct fi_provider *prov,
@@ -173,10 +250,38 @@ static inline void ofi_perfset_start(struct ofi_perfset *set, size_t index)
 	ofi_perf_start(set->ctx, &set->data[index]);
 }
 
+static inline uint64_t *
+ofi_perfset_hist(struct ofi_perfset *set, size_t index, size_t slot)
+{
+	return &set->hist[(index * set->hist_slots + slot) *
+			  OFI_PERF_HIST_SIZE];
+}
+
 static inline void ofi_perfset_end(struct ofi_perfset *set, size_t index)
 {
+	uint64_t delta;
+
+	assert(index < set->size);
+	delta = ofi_perf_end(set->ctx, &set->data[index]);
+	if (set->hist) {
+		ofi_perfset_hist(set, index, set->hist_slots - 1)
+			[ofi_perf_hist_index(delta)]++;
+	}
+}
+
+/* Records the histogram sample by transfer size, if enabled */
+static inline void ofi_perfset_end_size(struct ofi_perfset *set, size_t index,
+					size_t len)
+{
+	uint64_t delta;
+	size_t slot;
+
 	assert(index < set->size);
-	ofi_perf_end(set->ctx, &set->data[index]);
+	delta = ofi_perf_end(set->ctx, &set->data[index]);
+	if (set->hist) {
+		slot = set->hist_slots > 1 ? ofi_perf_size_bucket(len) : 0;
+		ofi_perfset_hist(set, index, slot)[ofi_perf_hist_index(delta)]++;
+	}
 }
 
 
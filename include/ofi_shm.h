@@ -54,7 +54,7 @@ extern "C" {
 #endif
 
 
-#define SMR_VERSION	4
+#define SMR_VERSION	6
 
 #define SMR_FLAG_ATOMIC	(1 << 0)
 #define SMR_FLAG_DEBUG	(1 << 1)
@@ -83,6 +83,7 @@ enum {
 #define SMR_TX_COMPLETION	(1 << 2)
 #define SMR_RX_COMPLETION	(1 << 3)
 #define SMR_MULTI_RECV		(1 << 4)
+#define SMR_SAR_PIPELINE	(1 << 5)
 
 /* CMA capability */
 enum {
@@ -173,8 +174,12 @@ struct smr_addr {
 	int64_t		id;
 };
 
+/*
+ * Per-peer state kept in the shared region, indexed by the local map id.
+ * Kept small, since the region reserves a slot for every possible peer.
+ */
 struct smr_peer_data {
-	struct smr_addr		addr;
+	int64_t			id;
 	uint32_t		sar_status;
 	uint32_t		name_sent;
 };
@@ -205,7 +210,18 @@ struct smr_peer {
 	struct smr_region	*region;
 };
 
-#define SMR_MAX_PEERS	256
+#define SMR_MAX_PEERS		4096
+#define SMR_SAR_BUF_CNT		256
+
+/*
+ * The peer table is allocated in chunks as ids are handed out, so that
+ * the map size follows the number of peers actually contacted.  Chunks
+ * are not freed until the map is destroyed, which lets the data path
+ * look up peers without taking the map lock.
+ */
+#define SMR_PEER_CHUNK_SHIFT	6
+#define SMR_PEER_CHUNK_SIZE	(1 << SMR_PEER_CHUNK_SHIFT)
+#define SMR_PEER_CHUNK_CNT	(SMR_MAX_PEERS / SMR_PEER_CHUNK_SIZE)
 
 struct smr_map {
 	ofi_spin_t		lock;
@@ -213,9 +229,17 @@ struct smr_map {
 	int 			num_peers;
 	uint16_t		flags;
 	struct ofi_rbmap	rbmap;
-	struct smr_peer		peers[SMR_MAX_PEERS];
+	struct smr_peer		*peers[SMR_PEER_CHUNK_CNT];
 };
 
+static inline struct smr_peer *smr_map_peer(struct smr_map *map, int64_t id)
+{
+	assert(id >= 0 && id < SMR_MAX_PEERS);
+	assert(map->peers[id >> SMR_PEER_CHUNK_SHIFT]);
+	return &map->peers[id >> SMR_PEER_CHUNK_SHIFT]
+			  [id & (SMR_PEER_CHUNK_SIZE - 1)];
+}
+
 struct smr_region {
 	uint8_t		version;
 	uint8_t		resv;
@@ -245,9 +269,18 @@ struct smr_region {
 	size_t		sock_name_offset;
 };
 
+/*
+ * For SMR_SAR_PIPELINE transfers the SAR buffers are used as a ring:
+ * segment n of the message lives in sar[n % buf_batch_size].  The
+ * producer publishes sar_filled and the consumer sar_drained, both
+ * counted in SMR_SAR_SIZE segments, so each side can work on one part
+ * of the ring while the other side works on the rest.
+ */
 struct smr_resp {
-	uint64_t	msg_id;
-	uint64_t	status;
+	uint64_t		msg_id;
+	uint64_t		status;
+	volatile uint32_t	sar_filled;
+	volatile uint32_t	sar_drained;
 };
 
 struct smr_inject_buf {
@@ -291,7 +324,7 @@ OFI_DECLARE_ATOMIC_Q(struct smr_cmd_entry, smr_cmd_queue);
 
 static inline struct smr_region *smr_peer_region(struct smr_region *smr, int i)
 {
-	return smr->map->peers[i].region;
+	return smr_map_peer(smr->map, i)->region;
 }
 static inline struct smr_cmd_queue *smr_cmd_queue(struct smr_region *smr)
 {
@@ -328,6 +361,16 @@ static inline void smr_set_map(struct smr_region *smr, struct smr_map *map)
 	smr->map = map;
 }
 
+/* Share the SAR pool evenly, but keep at least one buffer per peer */
+static inline void smr_update_sar_per_peer(struct smr_region *smr)
+{
+	if (smr->map->num_peers > 0)
+		smr->max_sar_buf_per_peer = MAX(1, SMR_SAR_BUF_CNT /
+						   smr->map->num_peers);
+	else
+		smr->max_sar_buf_per_peer = SMR_BUF_BATCH_MAX;
+}
+
 struct smr_attr {
 	const char	*name;
 	size_t		rx_count;
@@ -342,8 +385,8 @@ size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
 				  size_t *sock_offset);
 void	smr_cma_check(struct smr_region *region, struct smr_region *peer_region);
 void	smr_cleanup(void);
-int	smr_map_create(const struct fi_provider *prov, int peer_count,
-		       uint16_t caps, struct smr_map **map);
+int	smr_map_create(const struct fi_provider *prov, uint16_t caps,
+		       struct smr_map **map);
 int	smr_map_to_region(const struct fi_provider *prov, struct smr_map *map,
 			  int64_t id);
 void	smr_map_to_endpoint(struct smr_region *region, int64_t id);
@@ -86,6 +86,14 @@ struct ofi_rbnode *ofi_rbmap_get_root(struct ofi_rbmap *map);
 struct ofi_rbnode *ofi_rbmap_find(struct ofi_rbmap *map, void *key);
 struct ofi_rbnode *ofi_rbmap_search(struct ofi_rbmap *map, void *key,
 		int (*compare)(struct ofi_rbmap *map, void *key, void *data));
+/* Returns the leftmost node matching key.  All nodes matching key must
+ * be adjacent in the tree's ordering, which holds for range searches.
+ */
+struct ofi_rbnode *ofi_rbmap_search_first(struct ofi_rbmap *map, void *key,
+		int (*compare)(struct ofi_rbmap *map, void *key, void *data));
+/* In-order successor.  Deleting a node does not invalidate its successor. */
+struct ofi_rbnode *ofi_rbmap_next(struct ofi_rbmap *map,
+		struct ofi_rbnode *node);
 int ofi_rbmap_insert(struct ofi_rbmap *map, void *key, void *data,
 		struct ofi_rbnode **node);
 void ofi_rbmap_delete(struct ofi_rbmap *map, struct ofi_rbnode *node);
@@ -67,6 +67,7 @@
 #include <ofi_epoll.h>
 #include <ofi_proto.h>
 #include <ofi_bitmask.h>
+#include <ofi_atomic_queue.h>
 
 #include "rbtree.h"
 #include "uthash.h"
@@ -503,6 +504,19 @@ struct util_cq_aux_entry {
 
 OFI_DECLARE_CIRQUE(struct fi_cq_tagged_entry, util_comp_cirq);
 
+/* FI_THREAD_SAFE CQs stage successful completions in a lock-free ring,
+ * so that multiple progress threads can write completions without
+ * contending on the CQ lock.  Any thread holding the CQ lock drains the
+ * ring into the cirq before accessing it, which keeps completions from
+ * a single writer in order.
+ */
+struct util_cq_mpsc_entry {
+	struct fi_cq_tagged_entry	comp;
+	fi_addr_t			src;
+};
+
+OFI_DECLARE_ATOMIC_Q(struct util_cq_mpsc_entry, util_cq_mpscq);
+
 typedef void (*ofi_cq_progress_func)(struct util_cq *cq);
 
 struct util_cq {
@@ -526,6 +540,7 @@ struct util_cq {
 	fi_addr_t		*src;
 	struct slist		aux_queue;
 	fi_cq_read_func		read_entry;
+	struct util_cq_mpscq	*mpscq;
 };
 
 int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
@@ -553,6 +568,14 @@ const char *ofi_cq_strerror(struct fid_cq *cq, int prov_errno,
 int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
 			  size_t len, void *buf, uint64_t data, uint64_t tag,
 			  fi_addr_t src);
+void ofi_cq_drain_mpsc(struct util_cq *cq);
+
+static inline void ofi_cq_drain(struct util_cq *cq)
+{
+	assert(ofi_genlock_held(&cq->cq_lock));
+	if (cq->mpscq)
+		ofi_cq_drain_mpsc(cq);
+}
 
 static inline
 ssize_t ofi_cq_read_entries(struct util_cq *cq, void *buf, size_t count,
@@ -563,6 +586,7 @@ ssize_t ofi_cq_read_entries(struct util_cq *cq, void *buf, size_t count,
 	ssize_t i;
 
 	ofi_genlock_lock(&cq->cq_lock);
+	ofi_cq_drain(cq);
 	if (ofi_cirque_isempty(cq->cirq)) {
 		i = -FI_EAGAIN;
 		goto out;
@@ -635,13 +659,84 @@ ofi_cq_write_src_entry(struct util_cq *cq, void *context, uint64_t flags,
 	ofi_cq_write_entry(cq, context, flags, len, buf, data, tag);
 }
 
+/* Free cirq entries, less the completions staged in the lock-free ring
+ * that will be moved into the cirq once it is drained.
+ */
+static inline size_t ofi_cq_freecnt(struct util_cq *cq)
+{
+	size_t free_cnt, staged;
+
+	free_cnt = ofi_cirque_freecnt(cq->cirq);
+	if (!cq->mpscq)
+		return free_cnt;
+
+	staged = (size_t) (ofi_atomic_load_explicit64(&cq->mpscq->write_pos,
+						      memory_order_acquire) -
+			   ofi_atomic_load_explicit64(&cq->mpscq->read_pos,
+						      memory_order_acquire));
+	return free_cnt > staged ? free_cnt - staged : 0;
+}
+
+static inline bool ofi_cq_isfull(struct util_cq *cq)
+{
+	return !ofi_cq_freecnt(cq);
+}
+
+/* For providers that hold the CQ lock while generating completions.
+ * Staged completions are drained first to keep them in order.
+ */
+static inline int
+ofi_cq_write_locked(struct util_cq *cq, void *context, uint64_t flags,
+		    size_t len, void *buf, uint64_t data, uint64_t tag,
+		    fi_addr_t src)
+{
+	assert(ofi_genlock_held(&cq->cq_lock));
+	ofi_cq_drain(cq);
+	if (ofi_cirque_freecnt(cq->cirq) > 1) {
+		if (cq->src)
+			cq->src[ofi_cirque_windex(cq->cirq)] = src;
+		ofi_cq_write_entry(cq, context, flags, len, buf, data, tag);
+		return 0;
+	}
+	return ofi_cq_write_overflow(cq, context, flags, len, buf, data,
+				     tag, src);
+}
+
+/* Returns -FI_EAGAIN if the lock-free ring is full */
+static inline int
+ofi_cq_write_mpsc(struct util_cq *cq, void *context, uint64_t flags,
+		  size_t len, void *buf, uint64_t data, uint64_t tag,
+		  fi_addr_t src)
+{
+	struct util_cq_mpsc_entry *entry;
+	int64_t pos;
+
+	if (util_cq_mpscq_next(cq->mpscq, &entry, &pos))
+		return -FI_EAGAIN;
+
+	entry->comp.op_context = context;
+	entry->comp.flags = flags;
+	entry->comp.len = len;
+	entry->comp.buf = buf;
+	entry->comp.data = data;
+	entry->comp.tag = tag;
+	entry->src = src;
+	util_cq_mpscq_commit(entry, pos);
+	return 0;
+}
+
 static inline int
 ofi_cq_write(struct util_cq *cq, void *context, uint64_t flags, size_t len,
 	     void *buf, uint64_t data, uint64_t tag)
 {
 	int ret;
 
+	if (cq->mpscq && !ofi_cq_write_mpsc(cq, context, flags, len, buf,
+					    data, tag, FI_ADDR_NOTAVAIL))
+		return 0;
+
 	ofi_genlock_lock(&cq->cq_lock);
+	ofi_cq_drain(cq);
 	if (ofi_cirque_freecnt(cq->cirq) > 1) {
 		ofi_cq_write_entry(cq, context, flags, len, buf, data, tag);
 		ret = 0;
@@ -659,7 +754,12 @@ ofi_cq_write_src(struct util_cq *cq, void *context, uint64_t flags, size_t len,
 {
 	int ret;
 
+	if (cq->mpscq && !ofi_cq_write_mpsc(cq, context, flags, len, buf,
+					    data, tag, src))
+		return 0;
+
 	ofi_genlock_lock(&cq->cq_lock);
+	ofi_cq_drain(cq);
 	if (ofi_cirque_freecnt(cq->cirq) > 1) {
 		ofi_cq_write_src_entry(cq, context, flags, len, buf, data,
 				       tag, src);
@@ -696,6 +796,100 @@ static inline int ofi_peer_cq_write_error(struct util_cq *cq,
 int ofi_peer_cq_write_error_peek(struct util_cq *cq, uint64_t tag,
 				 void *context);
 
+/* Writes count completions with a single acquisition of the CQ lock and
+ * signals the CQ's wait object once.  src may be NULL.
+ */
+ssize_t ofi_cq_write_batch(struct util_cq *cq,
+			   const struct fi_cq_tagged_entry *comp,
+			   const fi_addr_t *src, size_t count);
+
+static inline int
+ofi_peer_cq_write_batch(struct util_cq *cq,
+			const struct fi_cq_tagged_entry *comp,
+			const fi_addr_t *src, size_t count)
+{
+	struct fi_ops_cq_owner *ops = cq->peer_cq->owner_ops;
+	size_t i;
+	int ret;
+
+	if (FI_CHECK_OP(ops, struct fi_ops_cq_owner, writebatch))
+		return (int) ops->writebatch(cq->peer_cq, comp, src, count);
+
+	for (i = 0; i < count; i++) {
+		ret = (int) ops->write(cq->peer_cq, comp[i].op_context,
+				       comp[i].flags, comp[i].len, comp[i].buf,
+				       comp[i].data, comp[i].tag,
+				       src ? src[i] : FI_ADDR_NOTAVAIL);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+/*
+ * Completions generated while a progress loop runs may be staged in a
+ * batch and written to the CQ together.  The batch is flushed when it is
+ * full or when a completion targets a different CQ, so completions
+ * written to a CQ remain in order.  The owner of the batch must flush it
+ * before writing completions to the CQ through any other path.
+ */
+#define OFI_CQ_BATCH_SIZE 64
+
+struct ofi_cq_batch {
+	struct util_cq			*cq;
+	size_t				count;
+	struct fi_cq_tagged_entry	comp[OFI_CQ_BATCH_SIZE];
+	fi_addr_t			src[OFI_CQ_BATCH_SIZE];
+};
+
+static inline void ofi_cq_batch_init(struct ofi_cq_batch *batch)
+{
+	batch->cq = NULL;
+	batch->count = 0;
+}
+
+static inline int ofi_cq_batch_flush(struct ofi_cq_batch *batch)
+{
+	int ret;
+
+	if (!batch->count)
+		return 0;
+
+	/* Imported CQs belong to the owner, which may not support batches */
+	if (batch->cq->flags & FI_PEER)
+		ret = ofi_peer_cq_write_batch(batch->cq, batch->comp,
+					      batch->src, batch->count);
+	else
+		ret = (int) ofi_cq_write_batch(batch->cq, batch->comp,
+					       batch->src, batch->count);
+	batch->count = 0;
+	return ret;
+}
+
+static inline int
+ofi_cq_batch_write(struct ofi_cq_batch *batch, struct util_cq *cq,
+		   void *context, uint64_t flags, size_t len, void *buf,
+		   uint64_t data, uint64_t tag, fi_addr_t src)
+{
+	struct fi_cq_tagged_entry *comp;
+	int ret = 0;
+
+	if (batch->cq != cq || batch->count == OFI_CQ_BATCH_SIZE) {
+		ret = ofi_cq_batch_flush(batch);
+		batch->cq = cq;
+	}
+
+	comp = &batch->comp[batch->count];
+	comp->op_context = context;
+	comp->flags = flags;
+	comp->len = len;
+	comp->buf = buf;
+	comp->data = data;
+	comp->tag = tag;
+	batch->src[batch->count++] = src;
+	return ret;
+}
+
 int ofi_peer_cq_write_error_trunc(struct util_cq *cq, void *context,
 				  uint64_t flags, size_t len, void *buf,
 				  uint64_t data, uint64_t tag, size_t olen);
@@ -776,6 +970,8 @@ struct util_av;
 struct util_av_set;
 struct util_peer_addr;
 
+struct util_coll_topo;
+
 struct util_coll_mc {
 	struct fid_mc		mc_fid;
 	struct util_av_set	*av_set;
@@ -783,6 +979,7 @@ struct util_coll_mc {
 	uint16_t		group_id;
 	uint16_t		seq;
 	ofi_atomic32_t		ref;
+	struct util_coll_topo	*topo;
 };
 
 struct util_av_set {
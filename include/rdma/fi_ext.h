@@ -134,6 +134,24 @@ struct fid_mem_monitor {
 	struct fi_ops_mem_notify *import_ops;
 };
 
+/*
+ * MR cache statistics extension:
+ * To use, open mr_cache fid and call fi_get_val() with FI_MR_CACHE_STATS.
+ * Counts are totals for all registration caches in the process.
+ */
+#define FI_MR_CACHE_STATS	1
+
+struct fi_mr_cache_stats {
+	uint64_t	searches;
+	uint64_t	hits;
+	uint64_t	misses;
+	uint64_t	evictions;
+	uint64_t	deferred_frees;
+	uint64_t	notifications;
+	uint64_t	cached_cnt;
+	uint64_t	cached_size;
+};
+
 
 /*
  * System logging import extension:
@@ -56,6 +56,8 @@ struct fi_ops_av_owner {
 	size_t	size;
 	int	(*query)(struct fid_peer_av *av, struct fi_av_attr *attr);
 	fi_addr_t (*ep_addr)(struct fid_peer_av *av, struct fid_ep *ep);
+	int	(*lookup)(struct fid_peer_av *av, fi_addr_t fi_addr,
+			  void *addr, size_t *addrlen);
 };
 
 struct fid_peer_av {
@@ -103,6 +105,9 @@ struct fi_ops_cq_owner {
 			fi_addr_t src);
 	ssize_t	(*writeerr)(struct fid_peer_cq *cq,
 			const struct fi_cq_err_entry *err_entry);
+	ssize_t	(*writebatch)(struct fid_peer_cq *cq,
+			const struct fi_cq_tagged_entry *comp,
+			const fi_addr_t *src, size_t count);
 };
 
 struct fid_peer_cq {
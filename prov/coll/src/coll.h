@@ -115,6 +115,30 @@ coll_mr_desc_to_hmem_iface_dev(void **desc, size_t count, uint64_t *device)
 	return ((struct coll_mr *) desc[0])->iface;
 }
 
+enum coll_alltoall_algo {
+	COLL_ALLTOALL_AUTO,
+	COLL_ALLTOALL_PAIRWISE,
+	COLL_ALLTOALL_BRUCK,
+};
+
+enum coll_allreduce_algo {
+	COLL_ALLREDUCE_AUTO,
+	COLL_ALLREDUCE_RECURSIVE_DOUBLING,
+	COLL_ALLREDUCE_RING,
+	COLL_ALLREDUCE_RABENSEIFNER,
+};
+
+struct coll_env {
+	enum coll_allreduce_algo allreduce_algo;
+	size_t allreduce_short_size;
+	size_t segment_size;
+	enum coll_alltoall_algo alltoall_algo;
+	int hierarchical;
+	size_t ranks_per_node;
+};
+
+extern struct coll_env coll_env;
+
 extern struct fi_provider coll_prov;
 extern struct util_prov coll_util_prov;
 extern struct fi_fabric_attr coll_fabric_attr;
@@ -165,6 +189,28 @@ ssize_t coll_ep_allgather(struct fid_ep *ep, const void *buf, size_t count,
 			  fi_addr_t coll_addr, enum fi_datatype datatype,
 			  uint64_t flags, void *context);
 
+ssize_t coll_ep_reduce_scatter(struct fid_ep *ep, const void *buf, size_t count,
+			       void *desc, void *result, void *result_desc,
+			       fi_addr_t coll_addr, enum fi_datatype datatype,
+			       enum fi_op op, uint64_t flags, void *context);
+
+ssize_t coll_ep_alltoall(struct fid_ep *ep, const void *buf, size_t count,
+			 void *desc, void *result, void *result_desc,
+			 fi_addr_t coll_addr, enum fi_datatype datatype,
+			 uint64_t flags, void *context);
+
+ssize_t coll_ep_gather(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, uint64_t flags,
+		       void *context);
+
+ssize_t coll_ep_reduce(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, enum fi_op op,
+		       uint64_t flags, void *context);
+
 ssize_t coll_ep_scatter(struct fid_ep *ep, const void *buf, size_t count,
 			void *desc, void *result, void *result_desc,
 			fi_addr_t coll_addr, fi_addr_t root_addr,
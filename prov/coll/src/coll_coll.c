@@ -68,6 +68,8 @@ coll_create_op(struct fid_ep *ep, struct util_coll_mc *coll_mc,
 	coll_op->flags = flags;
 	coll_op->context = context;
 	coll_op->comp_fn = comp_fn;
+	coll_op->group.size = coll_mc->av_set->fi_addr_count;
+	coll_op->group.rank = coll_mc->local_rank;
 	dlist_init(&coll_op->work_queue);
 
 	return coll_op;
@@ -149,6 +151,32 @@ static void coll_log_work(struct util_coll_operation *coll_op)
 #endif
 }
 
+static bool coll_is_xfer(struct util_coll_work_item *item)
+{
+	return item->type == UTIL_COLL_SEND || item->type == UTIL_COLL_RECV;
+}
+
+/* Checks whether the item that cur_item depends on has completed */
+static bool coll_dep_done(struct util_coll_work_item *cur_item)
+{
+	struct util_coll_work_item *item;
+	struct dlist_entry *entry;
+
+	if (!cur_item->dep)
+		return true;
+
+	/* ids increase along the queue, completed items may be gone */
+	for (entry = cur_item->waiting_entry.prev;
+	     entry != &cur_item->coll_op->work_queue; entry = entry->prev) {
+		item = container_of(entry, struct util_coll_work_item,
+				    waiting_entry);
+		if (item->id <= cur_item->dep)
+			return item->id != cur_item->dep ||
+			       item->state == UTIL_COLL_COMPLETE;
+	}
+	return true;
+}
+
 static void coll_progress_work(struct util_ep *util_ep,
 		   	       struct util_coll_operation *coll_op)
 {
@@ -157,6 +185,7 @@ static void coll_progress_work(struct util_ep *util_ep,
 	struct util_coll_work_item *prev_item = NULL;
 	struct dlist_entry *tmp = NULL;
 	int previous_is_head;
+	bool xfer_blocked = false;
 
 	/* clean up any completed items while searching for the next ready */
 	dlist_foreach_container_safe(&coll_op->work_queue,
@@ -210,6 +239,23 @@ static void coll_progress_work(struct util_ep *util_ep,
 			continue;
 		}
 
+		/*
+		 * All transfers of an operation between two ranks use the
+		 * same tag, so they are posted in schedule order.  Other
+		 * items may start ahead of a transfer that is still waiting.
+		 */
+		if (coll_is_xfer(cur_item) && xfer_blocked)
+			continue;
+
+		if (!coll_dep_done(cur_item)) {
+			FI_DBG(coll_op->mc->av_set->av->prov, FI_LOG_CQ,
+			       "%p waiting for item %ld\n", cur_item,
+			       cur_item->dep);
+			if (coll_is_xfer(cur_item))
+				xfer_blocked = true;
+			continue;
+		}
+
 		FI_DBG(coll_op->mc->av_set->av->prov, FI_LOG_CQ,
 		       "Ready item: %p \n", cur_item);
 		next_ready = cur_item;
@@ -229,15 +275,60 @@ static void coll_bind_work(struct util_coll_operation *coll_op,
 			   struct util_coll_work_item *item)
 {
 	item->coll_op = coll_op;
+	item->id = ++coll_op->last_id;
 	dlist_insert_tail(&item->waiting_entry, &coll_op->work_queue);
 }
 
+/* Makes the most recently scheduled item wait for item id to complete */
+static void coll_sched_depend(struct util_coll_operation *coll_op,
+			      uint64_t id)
+{
+	struct util_coll_work_item *item;
+
+	item = container_of(coll_op->work_queue.prev,
+			    struct util_coll_work_item, waiting_entry);
+	item->dep = id;
+}
+
+/* Holds back later items until all scheduled work has completed */
+static void coll_sched_fence(struct util_coll_operation *coll_op)
+{
+	struct util_coll_work_item *item;
+
+	if (dlist_empty(&coll_op->work_queue))
+		return;
+
+	item = container_of(coll_op->work_queue.prev,
+			    struct util_coll_work_item, waiting_entry);
+	item->fence = 1;
+}
+
+/* Schedules the following work over group, or all of mc if NULL */
+static void coll_set_group(struct util_coll_operation *coll_op,
+			   const struct util_coll_group *group)
+{
+	if (group) {
+		coll_op->group = *group;
+	} else {
+		coll_op->group.ranks = NULL;
+		coll_op->group.size = coll_op->mc->av_set->fi_addr_count;
+		coll_op->group.rank = coll_op->mc->local_rank;
+	}
+}
+
+static uint64_t coll_group_rank(struct util_coll_operation *coll_op,
+				uint64_t rank)
+{
+	return coll_op->group.ranks ? coll_op->group.ranks[rank] : rank;
+}
+
 static int coll_sched_send(struct util_coll_operation *coll_op,
 			   uint64_t dest, void *buf, size_t count,
 			   enum fi_datatype datatype, int fence)
 {
 	struct util_coll_xfer_item *xfer_item;
 
+	dest = coll_group_rank(coll_op, dest);
 	xfer_item = calloc(1, sizeof(*xfer_item));
 	if (!xfer_item)
 		return -FI_ENOMEM;
@@ -262,6 +353,7 @@ static int coll_sched_recv(struct util_coll_operation *coll_op,
 {
 	struct util_coll_xfer_item *xfer_item;
 
+	src = coll_group_rank(coll_op, src);
 	xfer_item = calloc(1, sizeof(*xfer_item));
 	if (!xfer_item)
 		return -FI_ENOMEM;
@@ -355,12 +447,13 @@ static int coll_do_allreduce(struct util_coll_operation *coll_op,
 	int ret;
 	uint64_t mask = 1;
 
-	pof2 = rounddown_power_of_two(coll_op->mc->av_set->fi_addr_count);
-	rem = coll_op->mc->av_set->fi_addr_count - pof2;
-	local = coll_op->mc->local_rank;
+	pof2 = rounddown_power_of_two(coll_op->group.size);
+	rem = coll_op->group.size - pof2;
+	local = coll_op->group.rank;
 
 	/* copy initial send data to result */
-	memcpy(result, send_buf, count * ofi_datatype_size(datatype));
+	if (result != send_buf)
+		memcpy(result, send_buf, count * ofi_datatype_size(datatype));
 
 	if (local < 2 * rem) {
 		if (local % 2 == 0) {
@@ -447,26 +540,456 @@ static int coll_do_allreduce(struct util_coll_operation *coll_op,
 	return FI_SUCCESS;
 }
 
-/* allgather implemented using ring algorithm */
+/*
+ * The long message allreduce algorithms split the count into nblocks
+ * blocks, the first count % nblocks of which hold one extra element.
+ * Returns the element offset of block idx, so that block idx spans
+ * [coll_block_disp(idx), coll_block_disp(idx + 1)).
+ */
+static uint64_t coll_block_disp(uint64_t count, uint64_t nblocks,
+				uint64_t idx)
+{
+	return idx * (count / nblocks) + MIN(idx, count % nblocks);
+}
+
+/*
+ * Segment size in elements for a transfer of count elements, the whole
+ * transfer if segmentation is disabled.
+ */
+static uint64_t coll_seg_cnt(enum fi_datatype datatype, uint64_t count)
+{
+	if (!coll_env.segment_size)
+		return MAX(count, 1);
+	return MAX(coll_env.segment_size / ofi_datatype_size(datatype), 1);
+}
+
+static uint64_t coll_nsegs(uint64_t count, uint64_t seg_cnt)
+{
+	return (count + seg_cnt - 1) / seg_cnt;
+}
+
+/*
+ * Element range of segment seg of block blk, see coll_block_disp.
+ * Returns false if the block has no such segment.
+ */
+static bool coll_block_seg(uint64_t count, uint64_t nblocks, uint64_t blk,
+			   uint64_t seg_cnt, uint64_t seg, uint64_t *start,
+			   uint64_t *cnt)
+{
+	uint64_t end;
+
+	*start = coll_block_disp(count, nblocks, blk);
+	end = coll_block_disp(count, nblocks, blk + 1);
+	if (seg * seg_cnt >= end - *start)
+		return false;
+
+	*start += seg * seg_cnt;
+	*cnt = MIN(seg_cnt, end - *start);
+	return true;
+}
+
+/*
+ * Sends a region to send_rank while receiving one from recv_rank, in
+ * segments, reducing each received segment into inout_buf while the
+ * following ones are in flight.  The exchange is fenced, as the next
+ * step reuses tmp_buf.
+ */
+static int coll_sched_exchange_reduce(struct util_coll_operation *coll_op,
+				      uint64_t send_rank, void *send_buf,
+				      uint64_t send_cnt, uint64_t recv_rank,
+				      void *tmp_buf, void *inout_buf,
+				      uint64_t recv_cnt,
+				      enum fi_datatype datatype, enum fi_op op,
+				      uint64_t seg_cnt)
+{
+	size_t dtsize = ofi_datatype_size(datatype);
+	uint64_t off, recv_id = 0;
+	int ret;
+
+	for (off = 0; off < MAX(send_cnt, recv_cnt); off += seg_cnt) {
+		if (off < recv_cnt) {
+			ret = coll_sched_recv(coll_op, recv_rank,
+					      (char *) tmp_buf + off * dtsize,
+					      MIN(seg_cnt, recv_cnt - off),
+					      datatype, 0);
+			if (ret)
+				return ret;
+			recv_id = coll_op->last_id;
+		}
+
+		if (off < send_cnt) {
+			ret = coll_sched_send(coll_op, send_rank,
+					      (char *) send_buf + off * dtsize,
+					      MIN(seg_cnt, send_cnt - off),
+					      datatype, 0);
+			if (ret)
+				return ret;
+		}
+
+		if (off < recv_cnt) {
+			ret = coll_sched_reduce(coll_op,
+						(char *) tmp_buf + off * dtsize,
+						(char *) inout_buf + off * dtsize,
+						MIN(seg_cnt, recv_cnt - off),
+						datatype, op, 0);
+			if (ret)
+				return ret;
+			coll_sched_depend(coll_op, recv_id);
+		}
+	}
+
+	coll_sched_fence(coll_op);
+	return FI_SUCCESS;
+}
+
+/*
+ * Ring allreduce: a reduce-scatter around the ring leaves each rank with
+ * one fully reduced block, and an allgather around the ring distributes
+ * them.  Every rank sends 2 * (numranks - 1) / numranks of the buffer,
+ * independent of the number of ranks.  Requires count >= numranks.
+ *
+ * Blocks move in segments, and each segment is forwarded as soon as it
+ * has been reduced or received in the previous step, so the steps
+ * pipeline around the ring.
+ */
+static int coll_do_allreduce_ring(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void *tmp_buf, uint64_t count,
+				  enum fi_datatype datatype, enum fi_op op)
+{
+	uint64_t numranks, local, left, right, step, rblk, sblk;
+	uint64_t seg, seg_cnt, nsegs, start, cnt, recv_id;
+	uint64_t *ids, *prev_ids, *swap;
+	size_t dtsize;
+	int ret;
+
+	numranks = coll_op->group.size;
+	local = coll_op->group.rank;
+	left = (local + numranks - 1) % numranks;
+	right = (local + 1) % numranks;
+	dtsize = ofi_datatype_size(datatype);
+	seg_cnt = coll_seg_cnt(datatype, count);
+	/* block 0 is the largest */
+	nsegs = coll_nsegs(coll_block_disp(count, numranks, 1), seg_cnt);
+
+	ids = calloc(nsegs, sizeof(*ids));
+	prev_ids = calloc(nsegs, sizeof(*prev_ids));
+	if (!ids || !prev_ids) {
+		ret = -FI_ENOMEM;
+		goto out;
+	}
+
+	if (result != send_buf)
+		memcpy(result, send_buf, count * dtsize);
+
+	/* reduce-scatter: afterwards block local + 1 is fully reduced */
+	for (step = 0; step < numranks - 1; step++) {
+		rblk = (local + numranks - step - 1) % numranks;
+		sblk = (local + numranks - step) % numranks;
+		for (seg = 0; seg < nsegs; seg++) {
+			recv_id = 0;
+			if (coll_block_seg(count, numranks, rblk, seg_cnt, seg,
+					   &start, &cnt)) {
+				ret = coll_sched_recv(coll_op, left,
+					(char *) tmp_buf + start * dtsize,
+					cnt, datatype, 0);
+				if (ret)
+					goto out;
+				recv_id = coll_op->last_id;
+			}
+
+			if (coll_block_seg(count, numranks, sblk, seg_cnt, seg,
+					   &start, &cnt)) {
+				ret = coll_sched_send(coll_op, right,
+					(char *) result + start * dtsize,
+					cnt, datatype, 0);
+				if (ret)
+					goto out;
+				/* wait for our contribution to the segment */
+				if (step)
+					coll_sched_depend(coll_op,
+							  prev_ids[seg]);
+			}
+
+			if (recv_id) {
+				coll_block_seg(count, numranks, rblk, seg_cnt,
+					       seg, &start, &cnt);
+				ret = coll_sched_reduce(coll_op,
+					(char *) tmp_buf + start * dtsize,
+					(char *) result + start * dtsize,
+					cnt, datatype, op, 0);
+				if (ret)
+					goto out;
+				coll_sched_depend(coll_op, recv_id);
+				ids[seg] = coll_op->last_id;
+			}
+		}
+		swap = prev_ids;
+		prev_ids = ids;
+		ids = swap;
+	}
+
+	/* the allgather overwrites blocks that may still be in flight */
+	coll_sched_fence(coll_op);
+
+	/* allgather: pass the reduced blocks around the ring */
+	for (step = 0; step < numranks - 1; step++) {
+		rblk = (local + numranks - step) % numranks;
+		sblk = (local + 1 + numranks - step) % numranks;
+		for (seg = 0; seg < nsegs; seg++) {
+			if (coll_block_seg(count, numranks, rblk, seg_cnt, seg,
+					   &start, &cnt)) {
+				ret = coll_sched_recv(coll_op, left,
+					(char *) result + start * dtsize,
+					cnt, datatype, 0);
+				if (ret)
+					goto out;
+				ids[seg] = coll_op->last_id;
+			}
+
+			if (coll_block_seg(count, numranks, sblk, seg_cnt, seg,
+					   &start, &cnt)) {
+				ret = coll_sched_send(coll_op, right,
+					(char *) result + start * dtsize,
+					cnt, datatype, 0);
+				if (ret)
+					goto out;
+				/* forward what arrived in the last step */
+				if (step)
+					coll_sched_depend(coll_op,
+							  prev_ids[seg]);
+			}
+		}
+		swap = prev_ids;
+		prev_ids = ids;
+		ids = swap;
+	}
+
+	coll_sched_fence(coll_op);
+	ret = FI_SUCCESS;
+out:
+	free(prev_ids);
+	free(ids);
+	return ret;
+}
+
+/*
+ * Rabenseifner's allreduce: a reduce-scatter by recursive halving
+ * followed by an allgather by recursive doubling over the largest power
+ * of two ranks.  The remaining ranks fold their data into a neighbor
+ * first and receive the result from it at the end, as in
+ * coll_do_allreduce.  Requires count >= the power of two rank count.
+ *
+ * The reductions are done per segment as the data arrives.
+ */
+static int coll_do_allreduce_rabenseifner(struct util_coll_operation *coll_op,
+					  const void *send_buf, void *result,
+					  void *tmp_buf, uint64_t count,
+					  enum fi_datatype datatype,
+					  enum fi_op op)
+{
+	uint64_t rem, pof2, my_new_id, local, remote, next_remote, mask;
+	uint64_t send_idx, recv_idx, last_idx, send_off, recv_off;
+	uint64_t send_cnt, recv_cnt, seg_cnt;
+	size_t dtsize;
+	int ret;
+
+	pof2 = rounddown_power_of_two(coll_op->group.size);
+	rem = coll_op->group.size - pof2;
+	local = coll_op->group.rank;
+	dtsize = ofi_datatype_size(datatype);
+	seg_cnt = coll_seg_cnt(datatype, count);
+
+	if (result != send_buf)
+		memcpy(result, send_buf, count * dtsize);
+
+	if (local < 2 * rem) {
+		if (local % 2 == 0) {
+			ret = coll_sched_exchange_reduce(coll_op, local + 1,
+							 result, count, 0,
+							 NULL, NULL, 0,
+							 datatype, op, seg_cnt);
+			if (ret)
+				return ret;
+
+			my_new_id = (uint64_t) -1;
+		} else {
+			ret = coll_sched_exchange_reduce(coll_op, 0, NULL, 0,
+							 local - 1, tmp_buf,
+							 result, count,
+							 datatype, op, seg_cnt);
+			if (ret)
+				return ret;
+
+			my_new_id = local / 2;
+		}
+	} else {
+		my_new_id = local - rem;
+	}
+
+	if (my_new_id == (uint64_t) -1)
+		goto out;
+
+	/* reduce-scatter by recursive halving of [send_idx, last_idx) */
+	send_idx = recv_idx = 0;
+	last_idx = pof2;
+	for (mask = 1; mask < pof2; mask <<= 1) {
+		next_remote = my_new_id ^ mask;
+		remote = (next_remote < rem) ? next_remote * 2 + 1 :
+			next_remote + rem;
+
+		if (my_new_id < next_remote) {
+			send_idx = recv_idx + pof2 / (mask * 2);
+			send_off = coll_block_disp(count, pof2, send_idx);
+			send_cnt = coll_block_disp(count, pof2, last_idx) -
+				   send_off;
+			recv_off = coll_block_disp(count, pof2, recv_idx);
+			recv_cnt = send_off - recv_off;
+		} else {
+			recv_idx = send_idx + pof2 / (mask * 2);
+			send_off = coll_block_disp(count, pof2, send_idx);
+			recv_off = coll_block_disp(count, pof2, recv_idx);
+			send_cnt = recv_off - send_off;
+			recv_cnt = coll_block_disp(count, pof2, last_idx) -
+				   recv_off;
+		}
+
+		ret = coll_sched_exchange_reduce(coll_op, remote,
+				(char *) result + send_off * dtsize, send_cnt,
+				remote, (char *) tmp_buf + recv_off * dtsize,
+				(char *) result + recv_off * dtsize, recv_cnt,
+				datatype, op, seg_cnt);
+		if (ret)
+			return ret;
+
+		send_idx = recv_idx;
+		if (mask * 2 < pof2)
+			last_idx = recv_idx + pof2 / (mask * 2);
+	}
+
+	/* allgather by recursive doubling, retracing the halving steps */
+	for (mask = pof2 >> 1; mask > 0; mask >>= 1) {
+		next_remote = my_new_id ^ mask;
+		remote = (next_remote < rem) ? next_remote * 2 + 1 :
+			next_remote + rem;
+
+		if (my_new_id < next_remote) {
+			if (mask != pof2 / 2)
+				last_idx += pof2 / (mask * 2);
+			recv_idx = send_idx + pof2 / (mask * 2);
+			send_off = coll_block_disp(count, pof2, send_idx);
+			recv_off = coll_block_disp(count, pof2, recv_idx);
+			send_cnt = recv_off - send_off;
+			recv_cnt = coll_block_disp(count, pof2, last_idx) -
+				   recv_off;
+		} else {
+			recv_idx = send_idx - pof2 / (mask * 2);
+			send_off = coll_block_disp(count, pof2, send_idx);
+			recv_off = coll_block_disp(count, pof2, recv_idx);
+			send_cnt = coll_block_disp(count, pof2, last_idx) -
+				   send_off;
+			recv_cnt = send_off - recv_off;
+		}
+
+		ret = coll_sched_recv(coll_op, remote,
+				      (char *) result + recv_off * dtsize,
+				      recv_cnt, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, remote,
+				      (char *) result + send_off * dtsize,
+				      send_cnt, datatype, 1);
+		if (ret)
+			return ret;
+
+		if (my_new_id > next_remote)
+			send_idx = recv_idx;
+	}
+
+out:
+	if (local < 2 * rem) {
+		if (local % 2) {
+			ret = coll_sched_send(coll_op, local - 1, result,
+					      count, datatype, 1);
+			if (ret)
+				return ret;
+		} else {
+			ret = coll_sched_recv(coll_op, local + 1, result,
+					      count, datatype, 1);
+			if (ret)
+				return ret;
+		}
+	}
+	return FI_SUCCESS;
+}
+
+static enum coll_allreduce_algo
+coll_select_allreduce(struct util_coll_operation *coll_op, uint64_t count,
+		      enum fi_datatype datatype)
+{
+	uint64_t numranks = coll_op->group.size;
+	enum coll_allreduce_algo algo = coll_env.allreduce_algo;
+
+	/* the block based algorithms need at least one element per block */
+	if (algo == COLL_ALLREDUCE_RING && count < numranks)
+		algo = COLL_ALLREDUCE_RECURSIVE_DOUBLING;
+	else if (algo == COLL_ALLREDUCE_RABENSEIFNER &&
+		 count < rounddown_power_of_two(numranks))
+		algo = COLL_ALLREDUCE_RECURSIVE_DOUBLING;
+
+	if (algo != COLL_ALLREDUCE_AUTO)
+		return algo;
+
+	if (numranks < 2 || count < numranks ||
+	    count * ofi_datatype_size(datatype) <=
+	    coll_env.allreduce_short_size)
+		return COLL_ALLREDUCE_RECURSIVE_DOUBLING;
+
+	/*
+	 * Both move 2 * (n - 1) / n of the buffer per rank.  Rabenseifner
+	 * needs 2 * log2(n) steps instead of 2 * (n - 1), but for other
+	 * rank counts the fold into the power of two set sends the whole
+	 * buffer twice more, which the ring avoids.
+	 */
+	if (rounddown_power_of_two(numranks) == numranks)
+		return COLL_ALLREDUCE_RABENSEIFNER;
+	return COLL_ALLREDUCE_RING;
+}
+
+/*
+ * allgather implemented using ring algorithm, each segment is forwarded
+ * as soon as it arrives from the left
+ */
 static int coll_do_allgather(struct util_coll_operation *coll_op,
 			     const void *send_buf, void *result, size_t count,
 			     enum fi_datatype datatype)
 {
-	uint64_t i, cur_offset, next_offset;
+	uint64_t i, cur_offset, next_offset, seg, seg_cnt, nsegs, start, cnt;
+	uint64_t *ids, *prev_ids, *swap;
 	int ret;
-	size_t nbytes, numranks;
+	size_t dtsize, numranks;
 	uint64_t local_rank, left_rank, right_rank;
 
-	local_rank = coll_op->mc->local_rank;
-	nbytes = ofi_datatype_size(datatype) * count;
-	numranks = coll_op->mc->av_set->fi_addr_count;
+	local_rank = coll_op->group.rank;
+	dtsize = ofi_datatype_size(datatype);
+	numranks = coll_op->group.size;
+	seg_cnt = coll_seg_cnt(datatype, count);
+	nsegs = coll_nsegs(count, seg_cnt);
+
+	ids = calloc(nsegs + 1, sizeof(*ids));
+	prev_ids = calloc(nsegs + 1, sizeof(*prev_ids));
+	if (!ids || !prev_ids) {
+		ret = -FI_ENOMEM;
+		goto out;
+	}
 
 	/* copy the local value to the appropriate place in result buffer */
 	ret = coll_sched_copy(coll_op, (void *) send_buf,
-			      (char *) result + (local_rank * nbytes),
+			      (char *) result + (local_rank * count * dtsize),
 			      count, datatype, 1);
 	if (ret)
-		return ret;
+		goto out;
 
 	/* send to right, recv from left */
 	left_rank = (numranks + local_rank - 1) % numranks;
@@ -477,23 +1000,44 @@ static int coll_do_allgather(struct util_coll_operation *coll_op,
 
 	/* fill in result with data going right to left */
 	for (i = 1; i < numranks; i++) {
-		ret = coll_sched_send(coll_op, right_rank,
-				      (char *) result + (cur_offset * nbytes),
-				      count, datatype, 0);
-		if (ret)
-			return ret;
+		for (seg = 0; seg < nsegs; seg++) {
+			if (coll_block_seg(count * numranks, numranks,
+					   cur_offset, seg_cnt, seg,
+					   &start, &cnt)) {
+				ret = coll_sched_send(coll_op, right_rank,
+					(char *) result + start * dtsize,
+					cnt, datatype, 0);
+				if (ret)
+					goto out;
+				if (i > 1)
+					coll_sched_depend(coll_op,
+							  prev_ids[seg]);
+			}
 
-		ret = coll_sched_recv(coll_op, left_rank,
-				      (char *) result + (next_offset * nbytes),
-				      count, datatype, 1);
-		if (ret)
-			return ret;
+			if (coll_block_seg(count * numranks, numranks,
+					   next_offset, seg_cnt, seg,
+					   &start, &cnt)) {
+				ret = coll_sched_recv(coll_op, left_rank,
+					(char *) result + start * dtsize,
+					cnt, datatype, 0);
+				if (ret)
+					goto out;
+				ids[seg] = coll_op->last_id;
+			}
+		}
+		swap = prev_ids;
+		prev_ids = ids;
+		ids = swap;
 
 		cur_offset = next_offset;
 		next_offset = (numranks + next_offset - 1) % numranks;
 	}
 
-	return FI_SUCCESS;
+	coll_sched_fence(coll_op);
+out:
+	free(prev_ids);
+	free(ids);
+	return ret;
 }
 
 static size_t util_binomial_tree_values_to_recv(uint64_t rank, size_t numranks)
@@ -517,8 +1061,8 @@ static int coll_do_scatter(struct util_coll_operation *coll_op,
 	int ret;
 	void *send_data;
 
-	local_rank = coll_op->mc->local_rank;
-	numranks = coll_op->mc->av_set->fi_addr_count;
+	local_rank = coll_op->group.rank;
+	numranks = coll_op->group.size;
 	relative_rank = (local_rank >= root) ?
 			local_rank - root : local_rank - root + numranks;
 	nbytes = count * ofi_datatype_size(datatype);
@@ -553,96 +1097,506 @@ static int coll_do_scatter(struct util_coll_operation *coll_op,
 			if (!*temp)
 				return -FI_ENOMEM;
 
-			ret = coll_sched_copy(coll_op,
-					      (char *) data + nbytes * local_rank,
-					      *temp,
-					      (numranks - local_rank) * count,
-					      datatype, 1);
-			if (ret)
-				return ret;
+			ret = coll_sched_copy(coll_op,
+					      (char *) data + nbytes * local_rank,
+					      *temp,
+					      (numranks - local_rank) * count,
+					      datatype, 1);
+			if (ret)
+				return ret;
+
+			ret = coll_sched_copy(coll_op, (char *) data,
+					      (char *) *temp + (numranks - local_rank) * nbytes,
+					      local_rank * count, datatype, 1);
+			if (ret)
+				return ret;
+		}
+	}
+
+	/* set up all receives */
+	mask = 0x1;
+	while (mask < numranks) {
+		if (relative_rank & mask) {
+			remote_rank = local_rank - mask;
+			if (remote_rank < 0)
+				remote_rank += numranks;
+
+			if (relative_rank % 2) {
+				/* leaf node, receive our data */
+				ret = coll_sched_recv(coll_op, remote_rank,
+						      result, count, datatype,
+						      1);
+				if (ret)
+					return ret;
+			} else {
+				/* branch node, receive data to forward */
+				ret = coll_sched_recv(coll_op, remote_rank,
+						      *temp, cur_cnt, datatype,
+						      1);
+				if (ret)
+					return ret;
+			}
+			break;
+		}
+		mask <<= 1;
+	}
+
+	/* set up all sends */
+	send_data = root == local_rank && root == 0 ? (void *) data : *temp;
+	mask >>= 1;
+	while (mask > 0) {
+		if (relative_rank + mask < numranks) {
+			/*
+			 * To this point, cur_cnt has represented the number of
+			 * values to expect to store in our data buf.  From here
+			 * on, cur_cnt is the number of values we have left to
+			 * forward from the data buf.
+			 */
+			send_cnt = cur_cnt - count * mask;
+
+			remote_rank = local_rank + mask;
+			if ((uint64_t) remote_rank >= numranks)
+				remote_rank -= numranks;
+
+			FI_DBG(coll_op->mc->av_set->av->prov, FI_LOG_CQ,
+			       "MASK: 0x%0lx CUR_CNT: %ld SENDING: %ld TO: %ld\n",
+			       mask, cur_cnt, send_cnt, remote_rank);
+
+			assert(send_cnt > 0);
+
+			ret = coll_sched_send(coll_op, remote_rank,
+					      (char *) send_data + nbytes * mask,
+					      send_cnt, datatype, 1);
+			if (ret)
+				return ret;
+
+			cur_cnt -= send_cnt;
+		}
+		mask >>= 1;
+	}
+
+	if (!(relative_rank % 2)) {
+		/*
+		 * for the root and all even nodes, we've got to copy
+		 * our local data to the result buffer
+		 */
+		ret = coll_sched_copy(coll_op, send_data, result,
+				      count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Reduce-scatter by pairwise exchange: in step i every rank sends the
+ * block owned by rank + i and reduces the block it receives from
+ * rank - i into its own.  buf holds count elements for each rank.
+ */
+static int coll_do_reduce_scatter(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void *tmp_buf, uint64_t count,
+				  enum fi_datatype datatype, enum fi_op op)
+{
+	uint64_t numranks, local, i, dst, src, seg_cnt;
+	size_t nbytes;
+	int ret;
+
+	numranks = coll_op->group.size;
+	local = coll_op->group.rank;
+	nbytes = count * ofi_datatype_size(datatype);
+	seg_cnt = coll_seg_cnt(datatype, count);
+
+	memcpy(result, (char *) send_buf + local * nbytes, nbytes);
+
+	for (i = 1; i < numranks; i++) {
+		dst = (local + i) % numranks;
+		src = (local + numranks - i) % numranks;
+		ret = coll_sched_exchange_reduce(coll_op, dst,
+				(char *) send_buf + dst * nbytes, count,
+				src, tmp_buf, result, count, datatype, op,
+				seg_cnt);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Alltoall by pairwise exchange: in step i every rank sends to rank + i
+ * and receives from rank - i.  The blocks are independent, so all steps
+ * are in flight at once.
+ */
+static int coll_do_alltoall_pairwise(struct util_coll_operation *coll_op,
+				     const void *send_buf, void *result,
+				     uint64_t count, enum fi_datatype datatype)
+{
+	uint64_t numranks, local, i, dst, src;
+	size_t nbytes;
+	int ret;
+
+	numranks = coll_op->group.size;
+	local = coll_op->group.rank;
+	nbytes = count * ofi_datatype_size(datatype);
+
+	memcpy((char *) result + local * nbytes,
+	       (char *) send_buf + local * nbytes, nbytes);
+
+	for (i = 1; i < numranks; i++) {
+		dst = (local + i) % numranks;
+		src = (local + numranks - i) % numranks;
+		ret = coll_sched_recv(coll_op, src,
+				      (char *) result + src * nbytes,
+				      count, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, dst,
+				      (char *) send_buf + dst * nbytes,
+				      count, datatype, 0);
+		if (ret)
+			return ret;
+	}
+
+	coll_sched_fence(coll_op);
+	return FI_SUCCESS;
+}
+
+/*
+ * Bruck's alltoall: after rotating the blocks by the local rank, step k
+ * sends every block whose index has bit k set to rank + 2^k, so all
+ * blocks arrive in log2(n) steps at the cost of forwarding each one
+ * up to log2(n) times.  Suited to small blocks, where the number of
+ * messages dominates.  temp gets n blocks of working space and two
+ * buffers of (n + 1) / 2 blocks to pack and unpack each step.
+ */
+static int coll_do_alltoall_bruck(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void **temp, uint64_t count,
+				  enum fi_datatype datatype)
+{
+	uint64_t numranks, local, i, k, nsend;
+	char *work, *pack, *unpack;
+	size_t nbytes;
+	int ret;
+
+	numranks = coll_op->group.size;
+	local = coll_op->group.rank;
+	nbytes = count * ofi_datatype_size(datatype);
+
+	*temp = malloc((numranks + 2 * ((numranks + 1) / 2)) * nbytes);
+	if (!*temp)
+		return -FI_ENOMEM;
+
+	work = *temp;
+	pack = work + numranks * nbytes;
+	unpack = pack + (numranks + 1) / 2 * nbytes;
+
+	/* work[i] = send_buf[(local + i) % numranks] */
+	memcpy(work, (char *) send_buf + local * nbytes,
+	       (numranks - local) * nbytes);
+	memcpy(work + (numranks - local) * nbytes, send_buf, local * nbytes);
+
+	for (k = 1; k < numranks; k <<= 1) {
+		for (i = 0, nsend = 0; i < numranks; i++) {
+			if (!(i & k))
+				continue;
+			ret = coll_sched_copy(coll_op, work + i * nbytes,
+					      pack + nsend++ * nbytes, count,
+					      datatype, 0);
+			if (ret)
+				return ret;
+		}
+		coll_sched_fence(coll_op);
+
+		ret = coll_sched_recv(coll_op,
+				      (local + numranks - k) % numranks,
+				      unpack, nsend * count, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_send(coll_op, (local + k) % numranks, pack,
+				      nsend * count, datatype, 1);
+		if (ret)
+			return ret;
+
+		for (i = 0, nsend = 0; i < numranks; i++) {
+			if (!(i & k))
+				continue;
+			ret = coll_sched_copy(coll_op, unpack + nsend++ * nbytes,
+					      work + i * nbytes, count,
+					      datatype, 0);
+			if (ret)
+				return ret;
+		}
+		coll_sched_fence(coll_op);
+	}
+
+	/* result[i] = work[(local - i) % numranks] */
+	for (i = 0; i < numranks; i++) {
+		ret = coll_sched_copy(coll_op,
+				      work + (local + numranks - i) % numranks *
+				      nbytes, (char *) result + i * nbytes,
+				      count, datatype, 0);
+		if (ret)
+			return ret;
+	}
+	coll_sched_fence(coll_op);
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Gather implemented with binomial tree algorithm.  Each rank collects
+ * the blocks of its subtree in relative rank order and passes them to
+ * its parent, root rotates them into place.
+ */
+static int coll_do_gather(struct util_coll_operation *coll_op,
+			  const void *data, void *result, void **temp,
+			  size_t count, uint64_t root,
+			  enum fi_datatype datatype)
+{
+	uint64_t local_rank, relative_rank, mask, child;
+	size_t nbytes, numranks, nblocks;
+	char *buf;
+	int ret;
+
+	local_rank = coll_op->group.rank;
+	numranks = coll_op->group.size;
+	relative_rank = (local_rank + numranks - root) % numranks;
+	nbytes = count * ofi_datatype_size(datatype);
+
+	if (count == 0)
+		return FI_SUCCESS;
+
+	nblocks = relative_rank ?
+		  util_binomial_tree_values_to_recv(relative_rank, numranks) :
+		  numranks;
+
+	if (local_rank == 0 && root == 0) {
+		buf = result;
+	} else {
+		*temp = malloc(nblocks * nbytes);
+		if (!*temp)
+			return -FI_ENOMEM;
+		buf = *temp;
+	}
+	memcpy(buf, data, nbytes);
+
+	for (mask = 1; mask < numranks; mask <<= 1) {
+		if (relative_rank & mask) {
+			coll_sched_fence(coll_op);
+			return coll_sched_send(coll_op,
+					(relative_rank - mask + root) % numranks,
+					buf, nblocks * count, datatype, 1);
+		}
+
+		child = relative_rank + mask;
+		if (child >= numranks)
+			continue;
+
+		ret = coll_sched_recv(coll_op, (child + root) % numranks,
+				      buf + mask * nbytes,
+				      MIN(mask, numranks - child) * count,
+				      datatype, 0);
+		if (ret)
+			return ret;
+	}
+	coll_sched_fence(coll_op);
+
+	if (buf != result) {
+		ret = coll_sched_copy(coll_op, buf,
+				      (char *) result + root * nbytes,
+				      (numranks - root) * count, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_copy(coll_op,
+				      buf + (numranks - root) * nbytes, result,
+				      root * count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Reduce implemented with binomial tree algorithm.  tmp_buf holds
+ * 2 * count elements: a receive buffer and, except at root, which
+ * reduces into result, the partial result of the subtree.
+ */
+static int coll_do_reduce(struct util_coll_operation *coll_op,
+			  const void *send_buf, void *result, void *tmp_buf,
+			  uint64_t count, uint64_t root,
+			  enum fi_datatype datatype, enum fi_op op)
+{
+	uint64_t local_rank, relative_rank, mask, child, seg_cnt;
+	size_t nbytes, numranks;
+	void *acc;
+	int ret;
+
+	local_rank = coll_op->group.rank;
+	numranks = coll_op->group.size;
+	relative_rank = (local_rank + numranks - root) % numranks;
+	nbytes = count * ofi_datatype_size(datatype);
+	seg_cnt = coll_seg_cnt(datatype, count);
+
+	acc = relative_rank ? (char *) tmp_buf + nbytes : result;
+	if (acc != send_buf)
+		memcpy(acc, send_buf, nbytes);
+
+	for (mask = 1; mask < numranks; mask <<= 1) {
+		if (relative_rank & mask)
+			return coll_sched_exchange_reduce(coll_op,
+					(relative_rank - mask + root) % numranks,
+					acc, count, 0, NULL, NULL, 0,
+					datatype, op, seg_cnt);
+
+		child = relative_rank + mask;
+		if (child >= numranks)
+			continue;
+
+		ret = coll_sched_exchange_reduce(coll_op, 0, NULL, 0,
+						 (child + root) % numranks,
+						 tmp_buf, acc, count,
+						 datatype, op, seg_cnt);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Broadcast implemented with binomial tree algorithm.  Every segment
+ * is forwarded to the children as soon as it arrives.
+ */
+static int coll_do_bcast(struct util_coll_operation *coll_op, void *buf,
+			 uint64_t count, uint64_t root,
+			 enum fi_datatype datatype)
+{
+	uint64_t numranks, relative_rank, mask, child, seg, seg_cnt, nsegs;
+	uint64_t *ids = NULL;
+	size_t dtsize;
+	int ret = FI_SUCCESS;
+
+	numranks = coll_op->group.size;
+	relative_rank = (coll_op->group.rank + numranks - root) % numranks;
+	dtsize = ofi_datatype_size(datatype);
+	seg_cnt = coll_seg_cnt(datatype, count);
+	nsegs = coll_nsegs(count, seg_cnt);
+
+	/* the children are relative_rank + mask / 2, mask / 4, ... */
+	mask = relative_rank ? relative_rank & -relative_rank :
+			       roundup_power_of_two(numranks);
+
+	if (relative_rank) {
+		ids = calloc(nsegs, sizeof(*ids));
+		if (!ids)
+			return -FI_ENOMEM;
 
-			ret = coll_sched_copy(coll_op, (char *) data,
-					      (char *) *temp + (numranks - local_rank) * nbytes,
-					      local_rank * count, datatype, 1);
+		for (seg = 0; seg < nsegs; seg++) {
+			ret = coll_sched_recv(coll_op,
+					(relative_rank - mask + root) % numranks,
+					(char *) buf + seg * seg_cnt * dtsize,
+					MIN(seg_cnt, count - seg * seg_cnt),
+					datatype, 0);
 			if (ret)
-				return ret;
+				goto out;
+			ids[seg] = coll_op->last_id;
 		}
 	}
 
-	/* set up all receives */
-	mask = 0x1;
-	while (mask < numranks) {
-		if (relative_rank & mask) {
-			remote_rank = local_rank - mask;
-			if (remote_rank < 0)
-				remote_rank += numranks;
+	for (seg = 0; seg < nsegs; seg++) {
+		for (child = mask >> 1; child > 0; child >>= 1) {
+			if (relative_rank + child >= numranks)
+				continue;
 
-			if (relative_rank % 2) {
-				/* leaf node, receive our data */
-				ret = coll_sched_recv(coll_op, remote_rank,
-						      result, count, datatype,
-						      1);
-				if (ret)
-					return ret;
-			} else {
-				/* branch node, receive data to forward */
-				ret = coll_sched_recv(coll_op, remote_rank,
-						      *temp, cur_cnt, datatype,
-						      1);
-				if (ret)
-					return ret;
-			}
-			break;
+			ret = coll_sched_send(coll_op,
+					(relative_rank + child + root) % numranks,
+					(char *) buf + seg * seg_cnt * dtsize,
+					MIN(seg_cnt, count - seg * seg_cnt),
+					datatype, 0);
+			if (ret)
+				goto out;
+			if (ids)
+				coll_sched_depend(coll_op, ids[seg]);
 		}
-		mask <<= 1;
 	}
+	coll_sched_fence(coll_op);
 
-	/* set up all sends */
-	send_data = root == local_rank && root == 0 ? (void *) data : *temp;
-	mask >>= 1;
-	while (mask > 0) {
-		if (relative_rank + mask < numranks) {
-			/*
-			 * To this point, cur_cnt has represented the number of
-			 * values to expect to store in our data buf.  From here
-			 * on, cur_cnt is the number of values we have left to
-			 * forward from the data buf.
-			 */
-			send_cnt = cur_cnt - count * mask;
-
-			remote_rank = local_rank + mask;
-			if ((uint64_t) remote_rank >= numranks)
-				remote_rank -= numranks;
-
-			FI_DBG(coll_op->mc->av_set->av->prov, FI_LOG_CQ,
-			       "MASK: 0x%0lx CUR_CNT: %ld SENDING: %ld TO: %ld\n",
-			       mask, cur_cnt, send_cnt, remote_rank);
+out:
+	free(ids);
+	return ret;
+}
 
-			assert(send_cnt > 0);
+static int coll_do_allreduce_select(struct util_coll_operation *coll_op,
+				    const void *send_buf, void *result,
+				    void *tmp_buf, uint64_t count,
+				    enum fi_datatype datatype, enum fi_op op)
+{
+	switch (coll_select_allreduce(coll_op, count, datatype)) {
+	case COLL_ALLREDUCE_RING:
+		return coll_do_allreduce_ring(coll_op, send_buf, result,
+					      tmp_buf, count, datatype, op);
+	case COLL_ALLREDUCE_RABENSEIFNER:
+		return coll_do_allreduce_rabenseifner(coll_op, send_buf,
+						      result, tmp_buf, count,
+						      datatype, op);
+	default:
+		return coll_do_allreduce(coll_op, send_buf, result, tmp_buf,
+					 count, datatype, op);
+	}
+}
 
-			ret = coll_sched_send(coll_op, remote_rank,
-					      (char *) send_data + nbytes * mask,
-					      send_cnt, datatype, 1);
-			if (ret)
-				return ret;
+/*
+ * Hierarchical allreduce: reduce to the leader of each node, allreduce
+ * among the leaders and broadcast the result within each node, so that
+ * only one rank per node communicates across nodes.  tmp_buf holds
+ * 2 * count elements.
+ */
+static int coll_do_allreduce_hier(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void *tmp_buf, uint64_t count,
+				  enum fi_datatype datatype, enum fi_op op)
+{
+	struct util_coll_topo *topo = coll_op->mc->topo;
+	int ret;
 
-			cur_cnt -= send_cnt;
-		}
-		mask >>= 1;
-	}
+	coll_set_group(coll_op, &topo->node);
+	ret = coll_do_reduce(coll_op, send_buf, result, tmp_buf, count, 0,
+			     datatype, op);
+	if (ret)
+		goto out;
+	coll_sched_fence(coll_op);
 
-	if (!(relative_rank % 2)) {
-		/*
-		 * for the root and all even nodes, we've got to copy
-		 * our local data to the result buffer
-		 */
-		ret = coll_sched_copy(coll_op, send_data, result,
-				      count, datatype, 1);
+	if (topo->leaders.rank != UTIL_COLL_NO_RANK) {
+		coll_set_group(coll_op, &topo->leaders);
+		ret = coll_do_allreduce_select(coll_op, result, result,
+					       tmp_buf, count, datatype, op);
 		if (ret)
-			return ret;
+			goto out;
+		coll_sched_fence(coll_op);
 	}
 
-	return FI_SUCCESS;
+	coll_set_group(coll_op, &topo->node);
+	ret = coll_do_bcast(coll_op, result, count, 0, datatype);
+out:
+	coll_set_group(coll_op, NULL);
+	return ret;
+}
+
+static void coll_free_topo(struct util_coll_topo *topo)
+{
+	if (!topo)
+		return;
+
+	free(topo->node.ranks);
+	free(topo->leaders.ranks);
+	free(topo);
 }
 
 static int coll_close(struct fid *fid)
@@ -652,6 +1606,7 @@ static int coll_close(struct fid *fid)
 	coll_mc = container_of(fid, struct util_coll_mc, mc_fid.fid);
 
 	ofi_atomic_dec32(&coll_mc->av_set->ref);
+	coll_free_topo(coll_mc->topo);
 	free(coll_mc);
 
 	return FI_SUCCESS;
@@ -687,6 +1642,104 @@ static int coll_find_local_rank(struct fid_ep *ep,
 	return FI_SUCCESS;
 }
 
+/*
+ * Groups the ranks of coll_mc into nodes by the host part of their AV
+ * address, or into groups of ranks_per_node consecutive ranks if that is
+ * set.  Leaves topo NULL, so that collectives run flat, if the AV owner
+ * cannot look up addresses, the addresses are not IP based, or there is
+ * nothing to gain: a single node, or one rank per node.
+ */
+static int coll_find_topo(struct util_coll_mc *coll_mc)
+{
+	struct coll_av *av = container_of(coll_mc->av_set->av, struct coll_av,
+					  util_av.av_fid);
+	struct fid_peer_av *peer_av = av->peer_av;
+	struct util_coll_topo *topo = NULL;
+	union ofi_sock_ip *addrs;
+	uint64_t *node_of = NULL;
+	uint64_t numranks, nnodes, local, i, j;
+	size_t addrlen;
+	int ret = FI_SUCCESS;
+
+	coll_mc->topo = NULL;
+	numranks = coll_mc->av_set->fi_addr_count;
+	local = coll_mc->local_rank;
+	if (!coll_env.hierarchical || local == FI_ADDR_NOTAVAIL ||
+	    numranks < 3 ||
+	    (!coll_env.ranks_per_node &&
+	     !FI_CHECK_OP(peer_av->owner_ops, struct fi_ops_av_owner, lookup)))
+		return FI_SUCCESS;
+
+	addrs = calloc(numranks, sizeof(*addrs));
+	node_of = calloc(numranks, sizeof(*node_of));
+	if (!addrs || !node_of) {
+		ret = -FI_ENOMEM;
+		goto out;
+	}
+
+	for (i = 0, nnodes = 0; i < numranks; i++) {
+		if (coll_env.ranks_per_node) {
+			node_of[i] = i / coll_env.ranks_per_node;
+			nnodes = node_of[i] + 1;
+			continue;
+		}
+
+		addrlen = sizeof(*addrs);
+		if (peer_av->owner_ops->lookup(peer_av,
+				coll_mc->av_set->fi_addr_array[i],
+				&addrs[i], &addrlen) ||
+		    addrlen > sizeof(*addrs))
+			goto out;
+
+		for (j = 0; j < i; j++) {
+			if (ofi_equals_ipaddr(&addrs[i].sa, &addrs[j].sa))
+				break;
+		}
+		node_of[i] = j < i ? node_of[j] : nnodes++;
+	}
+
+	if (nnodes == 1 || nnodes == numranks)
+		goto out;
+
+	topo = calloc(1, sizeof(*topo));
+	if (!topo) {
+		ret = -FI_ENOMEM;
+		goto out;
+	}
+
+	topo->node.ranks = calloc(numranks, sizeof(*topo->node.ranks));
+	topo->leaders.ranks = calloc(nnodes, sizeof(*topo->leaders.ranks));
+	if (!topo->node.ranks || !topo->leaders.ranks) {
+		coll_free_topo(topo);
+		ret = -FI_ENOMEM;
+		goto out;
+	}
+
+	/* nodes are numbered in order of their lowest rank, the leader */
+	topo->leaders.rank = UTIL_COLL_NO_RANK;
+	for (i = 0; i < numranks; i++) {
+		if (node_of[i] == node_of[local]) {
+			if (i == local)
+				topo->node.rank = topo->node.size;
+			topo->node.ranks[topo->node.size++] = i;
+		}
+		if (node_of[i] == topo->leaders.size) {
+			if (i == local)
+				topo->leaders.rank = topo->leaders.size;
+			topo->leaders.ranks[topo->leaders.size++] = i;
+		}
+	}
+
+	FI_INFO(coll_mc->av_set->av->prov, FI_LOG_AV,
+		"%" PRIu64 " ranks on %" PRIu64 " nodes, %" PRIu64
+		" on the local node\n", numranks, nnodes, topo->node.size);
+	coll_mc->topo = topo;
+out:
+	free(node_of);
+	free(addrs);
+	return ret;
+}
+
 void coll_join_comp(struct util_coll_operation *coll_op)
 {
 	struct fi_eq_entry entry;
@@ -745,6 +1798,22 @@ void coll_collective_comp(struct util_coll_operation *coll_op)
 		free(coll_op->data.broadcast.scatter);
 		break;
 
+	case UTIL_COLL_REDUCE_SCATTER_OP:
+		free(coll_op->data.reduce_scatter);
+		break;
+
+	case UTIL_COLL_ALLTOALL_OP:
+		free(coll_op->data.alltoall);
+		break;
+
+	case UTIL_COLL_GATHER_OP:
+		free(coll_op->data.gather);
+		break;
+
+	case UTIL_COLL_REDUCE_OP:
+		free(coll_op->data.reduce);
+		break;
+
 	case UTIL_COLL_JOIN_OP:
 	case UTIL_COLL_BARRIER_OP:
 	case UTIL_COLL_ALLGATHER_OP:
@@ -759,10 +1828,10 @@ static ssize_t coll_process_reduce_item(struct util_coll_reduce_item *reduce_ite
 	if (reduce_item->op < FI_MIN || reduce_item->op > FI_BXOR)
 		return -FI_ENOSYS;
 
-	ofi_atomic_write_handler(reduce_item->op, reduce_item->datatype,
-				 reduce_item->inout_buf,
-				 reduce_item->in_buf,
-				 reduce_item->count);
+	ofi_atomic_reduce_handler(reduce_item->op, reduce_item->datatype,
+				  reduce_item->inout_buf,
+				  reduce_item->in_buf,
+				  reduce_item->count);
 	return FI_SUCCESS;
 }
 
@@ -833,7 +1902,8 @@ void coll_ep_progress(struct util_ep *util_ep)
 						 hdr);
 			ret = coll_process_xfer_item(xfer_item);
 			if (ret && ret == -FI_EAGAIN) {
-				slist_insert_tail(&work_item->ready_entry,
+				/* retry first to keep transfers in order */
+				slist_insert_head(&work_item->ready_entry,
 						  &util_ep->coll_ready_queue);
 				goto out;
 			}
@@ -844,6 +1914,11 @@ void coll_ep_progress(struct util_ep *util_ep)
 						 struct util_coll_xfer_item,
 						 hdr);
 			ret = coll_process_xfer_item(xfer_item);
+			if (ret && ret == -FI_EAGAIN) {
+				slist_insert_head(&work_item->ready_entry,
+						  &util_ep->coll_ready_queue);
+				goto out;
+			}
 			if (ret)
 				goto out;
 			break;
@@ -945,6 +2020,10 @@ int coll_join_collective(struct fid_ep *ep, const void *addr,
 	coll_find_local_rank(ep, new_coll_mc);
 	coll_find_local_rank(ep, coll_mc);
 
+	ret = coll_find_topo(new_coll_mc);
+	if (ret)
+		goto err1;
+
 	join_op = coll_create_op(ep, coll_mc, UTIL_COLL_JOIN_OP, flags,
 				 context, coll_join_comp);
 	if (!join_op) {
@@ -1009,10 +2088,16 @@ ssize_t coll_ep_barrier2(struct fid_ep *ep, fi_addr_t coll_addr, uint64_t flags,
 		return -FI_ENOMEM;
 
 	send = ~barrier_op->mc->local_rank;
-	ret = coll_do_allreduce(barrier_op, &send,
-				&barrier_op->data.barrier.data,
-				&barrier_op->data.barrier.tmp, 1, FI_UINT64,
-				FI_BAND);
+	if (barrier_op->mc->topo)
+		ret = coll_do_allreduce_hier(barrier_op, &send,
+					     &barrier_op->data.barrier.data,
+					     barrier_op->data.barrier.tmp, 1,
+					     FI_UINT64, FI_BAND);
+	else
+		ret = coll_do_allreduce(barrier_op, &send,
+					&barrier_op->data.barrier.data,
+					barrier_op->data.barrier.tmp, 1,
+					FI_UINT64, FI_BAND);
 	if (ret)
 		goto err1;
 
@@ -1052,16 +2137,22 @@ ssize_t coll_ep_allreduce(struct fid_ep *ep, const void *buf, size_t count,
 		return -FI_ENOMEM;
 
 	allreduce_op->data.allreduce.size = count * ofi_datatype_size(datatype);
-	allreduce_op->data.allreduce.data = calloc(count,
+	allreduce_op->data.allreduce.data = calloc(coll_mc->topo ?
+						   2 * count : count,
 						   ofi_datatype_size(datatype));
 	if (!allreduce_op->data.allreduce.data) {
 		ret = -FI_ENOMEM;
 		goto err1;
 	}
 
-	ret = coll_do_allreduce(allreduce_op, buf, result,
-				allreduce_op->data.allreduce.data, count,
-				datatype, op);
+	if (coll_mc->topo)
+		ret = coll_do_allreduce_hier(allreduce_op, buf, result,
+					     allreduce_op->data.allreduce.data,
+					     count, datatype, op);
+	else
+		ret = coll_do_allreduce_select(allreduce_op, buf, result,
+					allreduce_op->data.allreduce.data,
+					count, datatype, op);
 	if (ret)
 		goto err2;
 
@@ -1170,8 +2261,8 @@ ssize_t coll_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 	if (!broadcast_op)
 		return -FI_ENOMEM;
 
-	local = broadcast_op->mc->local_rank;
-	numranks = broadcast_op->mc->av_set->fi_addr_count;
+	local = broadcast_op->group.rank;
+	numranks = broadcast_op->group.size;
 	chunk_cnt = (count + numranks - 1) / numranks;
 	if (chunk_cnt * local > count &&
 	    chunk_cnt * local - (int) count > chunk_cnt)
@@ -1212,6 +2303,186 @@ err1:
 	return ret;
 }
 
+ssize_t coll_ep_reduce_scatter(struct fid_ep *ep, const void *buf, size_t count,
+			       void *desc, void *result, void *result_desc,
+			       fi_addr_t coll_addr, enum fi_datatype datatype,
+			       enum fi_op op, uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *reduce_scatter_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	reduce_scatter_op = coll_create_op(ep, coll_mc,
+					   UTIL_COLL_REDUCE_SCATTER_OP,
+					   flags, context,
+					   coll_collective_comp);
+	if (!reduce_scatter_op)
+		return -FI_ENOMEM;
+
+	reduce_scatter_op->data.reduce_scatter =
+		calloc(count, ofi_datatype_size(datatype));
+	if (!reduce_scatter_op->data.reduce_scatter) {
+		ret = -FI_ENOMEM;
+		goto err1;
+	}
+
+	ret = coll_do_reduce_scatter(reduce_scatter_op, buf, result,
+				     reduce_scatter_op->data.reduce_scatter,
+				     count, datatype, op);
+	if (ret)
+		goto err2;
+
+	ret = coll_sched_comp(reduce_scatter_op);
+	if (ret)
+		goto err2;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, reduce_scatter_op);
+
+	return FI_SUCCESS;
+
+err2:
+	free(reduce_scatter_op->data.reduce_scatter);
+err1:
+	free(reduce_scatter_op);
+	return ret;
+}
+
+ssize_t coll_ep_alltoall(struct fid_ep *ep, const void *buf, size_t count,
+			 void *desc, void *result, void *result_desc,
+			 fi_addr_t coll_addr, enum fi_datatype datatype,
+			 uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *alltoall_op;
+	struct util_ep *util_ep;
+	enum coll_alltoall_algo algo;
+	uint64_t numranks;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	alltoall_op = coll_create_op(ep, coll_mc, UTIL_COLL_ALLTOALL_OP,
+				     flags, context,
+				     coll_collective_comp);
+	if (!alltoall_op)
+		return -FI_ENOMEM;
+
+	numranks = alltoall_op->group.size;
+	algo = coll_env.alltoall_algo;
+	if (algo == COLL_ALLTOALL_AUTO)
+		algo = (numranks >= 8 &&
+			count * ofi_datatype_size(datatype) <= 256) ?
+		       COLL_ALLTOALL_BRUCK : COLL_ALLTOALL_PAIRWISE;
+
+	if (algo == COLL_ALLTOALL_BRUCK)
+		ret = coll_do_alltoall_bruck(alltoall_op, buf, result,
+					     &alltoall_op->data.alltoall,
+					     count, datatype);
+	else
+		ret = coll_do_alltoall_pairwise(alltoall_op, buf, result,
+						count, datatype);
+	if (ret)
+		goto err;
+
+	ret = coll_sched_comp(alltoall_op);
+	if (ret)
+		goto err;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, alltoall_op);
+
+	return FI_SUCCESS;
+err:
+	free(alltoall_op->data.alltoall);
+	free(alltoall_op);
+	return ret;
+}
+
+ssize_t coll_ep_gather(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, uint64_t flags,
+		       void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *gather_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	gather_op = coll_create_op(ep, coll_mc, UTIL_COLL_GATHER_OP,
+				   flags, context,
+				   coll_collective_comp);
+	if (!gather_op)
+		return -FI_ENOMEM;
+
+	ret = coll_do_gather(gather_op, buf, result, &gather_op->data.gather,
+			     count, root_addr, datatype);
+	if (ret)
+		goto err;
+
+	ret = coll_sched_comp(gather_op);
+	if (ret)
+		goto err;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, gather_op);
+
+	return FI_SUCCESS;
+err:
+	free(gather_op->data.gather);
+	free(gather_op);
+	return ret;
+}
+
+ssize_t coll_ep_reduce(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, enum fi_op op,
+		       uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *reduce_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	reduce_op = coll_create_op(ep, coll_mc, UTIL_COLL_REDUCE_OP,
+				   flags, context,
+				   coll_collective_comp);
+	if (!reduce_op)
+		return -FI_ENOMEM;
+
+	reduce_op->data.reduce = calloc(2 * count,
+					ofi_datatype_size(datatype));
+	if (!reduce_op->data.reduce) {
+		ret = -FI_ENOMEM;
+		goto err1;
+	}
+
+	ret = coll_do_reduce(reduce_op, buf, result, reduce_op->data.reduce,
+			     count, root_addr, datatype, op);
+	if (ret)
+		goto err2;
+
+	ret = coll_sched_comp(reduce_op);
+	if (ret)
+		goto err2;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, reduce_op);
+
+	return FI_SUCCESS;
+
+err2:
+	free(reduce_op->data.reduce);
+err1:
+	free(reduce_op);
+	return ret;
+}
+
 ssize_t coll_peer_xfer_complete(struct fid_ep *ep,
 				struct fi_cq_tagged_entry *cqe,
 				fi_addr_t src_addr)
@@ -1278,9 +2549,13 @@ int coll_query_collective(struct fid_domain *dom_fid,
 	case FI_ALLGATHER:
 	case FI_SCATTER:
 	case FI_BROADCAST:
+	case FI_ALLTOALL:
+	case FI_GATHER:
 		ret = FI_SUCCESS;
 		break;
 	case FI_ALLREDUCE:
+	case FI_REDUCE_SCATTER:
+	case FI_REDUCE:
 		if (FI_MIN <= attr->op && FI_BXOR >= attr->op)
 			ret = fi_query_atomic(peer_domain, attr->datatype,
 					      attr->op, &attr->datatype_attr,
@@ -1288,10 +2563,6 @@ int coll_query_collective(struct fid_domain *dom_fid,
 		else
 			return -FI_ENOSYS;
 		break;
-	case FI_ALLTOALL:
-	case FI_REDUCE_SCATTER:
-	case FI_REDUCE:
-	case FI_GATHER:
 	default:
 		return -FI_ENOSYS;
 	}
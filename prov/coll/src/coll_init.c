@@ -32,6 +32,95 @@
 
 #include "coll.h"
 
+struct coll_env coll_env = {
+	.allreduce_algo = COLL_ALLREDUCE_AUTO,
+	.allreduce_short_size = 8192,
+	.segment_size = 32768,
+	.alltoall_algo = COLL_ALLTOALL_AUTO,
+	.hierarchical = 1,
+};
+
+static void coll_init_env(void)
+{
+	char *algo = NULL;
+
+	fi_param_define(&coll_prov, "allreduce_algo", FI_PARAM_STRING,
+			"Selects the allreduce algorithm.  Supported values "
+			"are: auto, recursive_doubling, ring and rabenseifner. "
+			"auto uses recursive doubling for short messages and "
+			"for fewer elements than ranks, and otherwise "
+			"Rabenseifner's reduce-scatter/allgather for a power "
+			"of two number of ranks and the ring algorithm for "
+			"other rank counts (default: auto).");
+	fi_param_define(&coll_prov, "allreduce_short_size", FI_PARAM_SIZE_T,
+			"Largest allreduce, in bytes, that auto selection "
+			"runs with recursive doubling (default: %zu).",
+			coll_env.allreduce_short_size);
+
+	fi_param_define(&coll_prov, "segment_size", FI_PARAM_SIZE_T,
+			"Size in bytes of the segments that the allreduce, "
+			"allgather and broadcast algorithms split each step "
+			"into, so that the transfer of one segment overlaps "
+			"the reduction or forwarding of the previous one.  0 "
+			"disables segmentation (default: %zu).",
+			coll_env.segment_size);
+
+	fi_param_define(&coll_prov, "alltoall_algo", FI_PARAM_STRING,
+			"Selects the alltoall algorithm.  Supported values "
+			"are: auto, pairwise and bruck.  auto uses Bruck's "
+			"log2(n) step algorithm for blocks of up to 256 bytes "
+			"with 8 or more ranks, and pairwise exchange "
+			"otherwise (default: auto).");
+
+	fi_param_define(&coll_prov, "hierarchical", FI_PARAM_BOOL,
+			"Run allreduce and barrier in three phases when the "
+			"group spans several nodes with more than one rank on "
+			"some node: a reduction to the lowest rank of each "
+			"node, an allreduce among those node leaders and a "
+			"broadcast within each node.  Ranks share a node when "
+			"their AV addresses have the same host address "
+			"(default: %d).", coll_env.hierarchical);
+	fi_param_define(&coll_prov, "ranks_per_node", FI_PARAM_SIZE_T,
+			"Overrides the node detection of the hierarchical "
+			"collectives: consecutive groups of this many ranks "
+			"are treated as one node.  Intended for testing the "
+			"hierarchical algorithms on a single host.  0 groups "
+			"ranks by their AV addresses (default: 0).");
+
+	fi_param_get_bool(&coll_prov, "hierarchical", &coll_env.hierarchical);
+	fi_param_get_size_t(&coll_prov, "ranks_per_node",
+			    &coll_env.ranks_per_node);
+	fi_param_get_size_t(&coll_prov, "allreduce_short_size",
+			    &coll_env.allreduce_short_size);
+	fi_param_get_size_t(&coll_prov, "segment_size",
+			    &coll_env.segment_size);
+
+	fi_param_get_str(&coll_prov, "allreduce_algo", &algo);
+	if (!algo || !strcasecmp(algo, "auto"))
+		coll_env.allreduce_algo = COLL_ALLREDUCE_AUTO;
+	else if (!strcasecmp(algo, "recursive_doubling"))
+		coll_env.allreduce_algo = COLL_ALLREDUCE_RECURSIVE_DOUBLING;
+	else if (!strcasecmp(algo, "ring"))
+		coll_env.allreduce_algo = COLL_ALLREDUCE_RING;
+	else if (!strcasecmp(algo, "rabenseifner"))
+		coll_env.allreduce_algo = COLL_ALLREDUCE_RABENSEIFNER;
+	else
+		FI_WARN(&coll_prov, FI_LOG_CORE,
+			"unknown allreduce_algo %s, using auto\n", algo);
+
+	algo = NULL;
+	fi_param_get_str(&coll_prov, "alltoall_algo", &algo);
+	if (!algo || !strcasecmp(algo, "auto"))
+		coll_env.alltoall_algo = COLL_ALLTOALL_AUTO;
+	else if (!strcasecmp(algo, "pairwise"))
+		coll_env.alltoall_algo = COLL_ALLTOALL_PAIRWISE;
+	else if (!strcasecmp(algo, "bruck"))
+		coll_env.alltoall_algo = COLL_ALLTOALL_BRUCK;
+	else
+		FI_WARN(&coll_prov, FI_LOG_CORE,
+			"unknown alltoall_algo %s, using auto\n", algo);
+}
+
 static int coll_getinfo(uint32_t version, const char *node, const char *service,
 			uint64_t flags, const struct fi_info *hints,
 			struct fi_info **info)
@@ -60,5 +149,6 @@ struct fi_provider coll_prov = {
 
 COLL_INI
 {
+	coll_init_env();
 	return &coll_prov;
 }
@@ -41,6 +41,8 @@
 struct perf_fabric {
 	struct hook_fabric fabric_hook;
 	struct ofi_perfset perf_set;
+	/* last FI_PERF_DUMP_SIGNAL generation logged for this fabric */
+	ofi_atomic32_t dump_gen;
 };
 
 int hook_perf_destroy(struct fid *fabric);
@@ -36,6 +36,20 @@
 #include "fi_opx_tid_cache.h"
 #include "fi_opx_tid.h"
 
+#if defined(ENABLE_DEBUG) && ENABLE_DEBUG
+#define OPX_TID_CACHE_DBG_STATS(prov, cache)					\
+	do {									\
+		struct ofi_mr_cache_stats stats;				\
+		ofi_mr_cache_get_stats(cache, &stats);				\
+		FI_DBG(prov, FI_LOG_MR, "cached_cnt    %zu, cached_size   %zu, uncached_cnt  %zu, uncached_size %zu, search_cnt    %zu, delete_cnt    %zu, hit_cnt       %zu, notify_cnt    %zu\n", \
+			stats.cached_cnt, stats.cached_size, stats.uncached_cnt, \
+			stats.uncached_size, stats.search_cnt, stats.delete_cnt, \
+			stats.hit_cnt, stats.notify_cnt);			\
+	} while (0)
+#else
+#define OPX_TID_CACHE_DBG_STATS(prov, cache) do {} while (0)
+#endif
+
 /* ofi_mr.h callback functions */
 void opx_tid_cache_delete_region(struct ofi_mr_cache *cache,
 			      struct ofi_mr_entry *entry);
@@ -172,8 +186,7 @@ int opx_setup_tid_cache(struct ofi_mr_cache **cache, struct fi_opx_tid_domain *d
 
 	FI_DBG(&fi_opx_provider, FI_LOG_MR, "OPX TID cache enabled, max_cnt: %zu max_size: %zu\n",
 		 cache_params.max_cnt, cache_params.max_size);
-	FI_DBG(&fi_opx_provider, FI_LOG_MR, "cached_cnt    %zu, cached_size   %zu, uncached_cnt  %zu, uncached_size %zu, search_cnt    %zu, delete_cnt    %zu, hit_cnt       %zu, notify_cnt    %zu\n",
-		(*cache)->cached_cnt      ,(*cache)->cached_size     ,(*cache)->uncached_cnt    ,(*cache)->uncached_size   ,(*cache)->search_cnt      ,(*cache)->delete_cnt      ,(*cache)->hit_cnt         ,(*cache)->notify_cnt      );
+	OPX_TID_CACHE_DBG_STATS(&fi_opx_provider, *cache);
 
 	return 0;
 }
@@ -202,8 +215,7 @@ int opx_tid_cache_add_region(struct ofi_mr_cache *cache,
 			"Unable to insert MR entry (%#lX) into util map (%d)\n", key, err);
 	}
 */
-	FI_DBG(cache->domain->prov, FI_LOG_MR, "cached_cnt    %zu, cached_size   %zu, uncached_cnt  %zu, uncached_size %zu, search_cnt    %zu, delete_cnt    %zu, hit_cnt       %zu, notify_cnt    %zu\n",
-		(cache)->cached_cnt      ,(cache)->cached_size     ,(cache)->uncached_cnt    ,(cache)->uncached_size   ,(cache)->search_cnt      ,(cache)->delete_cnt      ,(cache)->hit_cnt         ,(cache)->notify_cnt      );
+	OPX_TID_CACHE_DBG_STATS(cache->domain->prov, cache);
 	return ret;
 }
 
@@ -243,6 +255,5 @@ void opx_tid_cache_delete_region(struct ofi_mr_cache *cache,
 	}
 */
 	memset(opx_mr, 0x00, sizeof(*opx_mr));
-	FI_DBG(cache->domain->prov, FI_LOG_MR, "cached_cnt    %zu, cached_size   %zu, uncached_cnt  %zu, uncached_size %zu, search_cnt    %zu, delete_cnt    %zu, hit_cnt       %zu, notify_cnt    %zu\n",
-		(cache)->cached_cnt      ,(cache)->cached_size     ,(cache)->uncached_cnt    ,(cache)->uncached_size   ,(cache)->search_cnt      ,(cache)->delete_cnt      ,(cache)->hit_cnt         ,(cache)->notify_cnt      );
+	OPX_TID_CACHE_DBG_STATS(cache->domain->prov, cache);
 }
@@ -60,7 +60,7 @@
 #ifndef _RXD_H_
 #define _RXD_H_
 
-#define RXD_PROTOCOL_VERSION 	(2)
+#define RXD_PROTOCOL_VERSION 	(4)
 
 #define RXD_MAX_MTU_SIZE	4096
 
@@ -72,10 +72,16 @@
 #define RXD_RX_POOL_CHUNK_CNT	1024
 #define RXD_MAX_PENDING		128
 #define RXD_MAX_PKT_RETRY	50
+#define RXD_MAX_RTO		4000000	/* usec */
+#define RXD_INIT_CWND		16
+#define RXD_MIN_CWND		2
+#define RXD_DUP_ACK_THRESH	3
 #define RXD_ADDR_INVALID	0
 
 #define RXD_PKT_IN_USE		(1 << 0)
 #define RXD_PKT_ACKED		(1 << 1)
+#define RXD_PKT_RETRANS		(1 << 2)
+#define RXD_PKT_SACKED		(1 << 3)
 
 #define RXD_REMOTE_CQ_DATA	(1 << 0)
 #define RXD_NO_TX_COMP		(1 << 1)
@@ -84,6 +90,8 @@
 #define RXD_TAG_HDR		(1 << 4)
 #define RXD_INLINE		(1 << 5)
 #define RXD_MULTI_RECV		(1 << 6)
+#define RXD_ACK_REQ		(1 << 7)
+#define RXD_DUP_ACK		(1 << 8)
 
 #define RXD_IDX_OFFSET(x)	(x + 1)	
 
@@ -92,6 +100,7 @@ struct rxd_env {
 	int retry;
 	int max_peers;
 	int max_unacked;
+	int min_rto;
 };
 
 extern struct rxd_env rxd_env;
@@ -132,9 +141,25 @@ struct rxd_peer {
 	uint16_t tx_window;
 	int retry_cnt;
 
+	/* RFC 6298 retransmission timer, in usec */
+	uint64_t srtt;
+	uint64_t rttvar;
+	uint64_t rto;
+	uint64_t ack_time;
+
+	/* AIMD congestion window, in packets */
+	uint16_t cwnd;
+	uint16_t ssthresh;
+	uint16_t cwnd_acked;
+	uint16_t dup_acks;
+	uint64_t recover_seq;
+
 	uint16_t unacked_cnt;
 	uint8_t active;
 
+	/* out of order packets held in buf_pkts, indexed by seq_no */
+	uint64_t rx_sack[RXD_SACK_WORDS];
+
 	uint16_t curr_rx_id;
 	uint16_t curr_tx_id;
 
@@ -144,6 +169,8 @@ struct rxd_peer {
 	struct dlist_entry rma_rx_list;
 	struct dlist_entry unacked;
 	struct dlist_entry buf_pkts;
+	/* on ep->held_peers while the first buffered op cannot start */
+	struct dlist_entry held_entry;
 };
 
 struct rxd_addr {
@@ -216,10 +243,21 @@ struct rxd_ep {
 	struct dlist_entry rx_tag_list;
 	struct dlist_entry active_peers;
 	struct dlist_entry rts_sent_list;
+	struct dlist_entry held_peers;
 	struct dlist_entry ctrl_pkts;
 
 	struct index_map peers_idm;
 };
+
+/*
+ * Packets in flight are limited by both the window advertised by the peer
+ * and the local congestion window.
+ */
+static inline int rxd_peer_window_full(struct rxd_peer *peer)
+{
+	return peer->unacked_cnt >= MIN(peer->tx_window, peer->cwnd);
+}
+
 /* ensure ep lock is held before this function is called */
 static inline struct rxd_peer *rxd_peer(struct rxd_ep *ep, fi_addr_t rxd_addr)
 {
@@ -431,6 +469,7 @@ int rxd_av_insert_dg_addr(struct rxd_av *av, const void *addr,
 /* Pkt resource functions */
 ssize_t rxd_ep_post_buf(struct rxd_ep *ep);
 void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer);
+void rxd_ep_send_dup_ack(struct rxd_ep *rxd_ep, fi_addr_t peer);
 struct rxd_pkt_entry *rxd_get_tx_pkt(struct rxd_ep *ep);
 struct rxd_x_entry *rxd_get_tx_entry(struct rxd_ep *ep, uint32_t op);
 struct rxd_x_entry *rxd_get_rx_entry(struct rxd_ep *ep, uint32_t op);
@@ -474,8 +513,12 @@ struct rxd_x_entry *rxd_rx_entry_init(struct rxd_ep *ep,
 			uint32_t op, uint32_t flags);
 void rxd_tx_entry_free(struct rxd_ep *ep, struct rxd_x_entry *tx_entry);
 void rxd_rx_entry_free(struct rxd_ep *ep, struct rxd_x_entry *rx_entry);
-int rxd_get_timeout(int retry_cnt);
-uint64_t rxd_get_retry_time(uint64_t start, int retry_cnt);
+uint64_t rxd_get_timeout(struct rxd_peer *peer);
+uint64_t rxd_get_retry_time(struct rxd_peer *peer, uint64_t start);
+void rxd_update_rtt(struct rxd_peer *peer, uint64_t rtt);
+void rxd_update_cwnd(struct rxd_peer *peer, uint16_t acked);
+void rxd_fast_retransmit(struct rxd_ep *ep, struct rxd_peer *peer);
+void rxd_retransmit_holes(struct rxd_ep *ep, struct rxd_peer *peer);
 
 /* Generic message functions */
 ssize_t rxd_ep_generic_recvmsg(struct rxd_ep *rxd_ep, const struct iovec *iov,
@@ -494,6 +537,7 @@ ssize_t rxd_ep_generic_inject(struct rxd_ep *rxd_ep, const struct iovec *iov,
 void rxd_tx_entry_progress(struct rxd_ep *ep, struct rxd_x_entry *tx_entry,
 			   int try_send);
 void rxd_handle_recv_comp(struct rxd_ep *ep, struct fi_cq_msg_entry *comp);
+void rxd_progress_held_peers(struct rxd_ep *ep);
 void rxd_handle_send_comp(struct rxd_ep *ep, struct fi_cq_msg_entry *comp);
 void rxd_handle_error(struct rxd_ep *ep);
 void rxd_progress_op(struct rxd_ep *ep, struct rxd_x_entry *rx_entry,
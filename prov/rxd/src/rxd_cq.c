@@ -151,20 +151,6 @@ static void rxd_complete_tx(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 	rxd_tx_entry_free(ep, tx_entry);
 }
 
-static int rxd_comp_pkt_seq_no(struct dlist_entry *item, const void *arg)
-{
-	struct rxd_base_hdr *list_hdr;
-	struct rxd_base_hdr *new_hdr;
-
-	list_hdr = rxd_get_base_hdr(container_of(item,
-				   struct rxd_pkt_entry, d_entry));
-
-	new_hdr = rxd_get_base_hdr(container_of((struct dlist_entry *) arg,
-				  struct rxd_pkt_entry, d_entry));
-
-	return new_hdr->seq_no > list_hdr->seq_no;
-}
-
 void rxd_ep_recv_data(struct rxd_ep *ep, struct rxd_x_entry *x_entry,
 		      struct rxd_data_pkt *pkt, size_t size)
 {
@@ -191,7 +177,8 @@ void rxd_ep_recv_data(struct rxd_ep *ep, struct rxd_x_entry *x_entry,
 
 	if (x_entry->next_seg_no < x_entry->num_segs) {
 		if (!(rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no %
-		    rxd_peer(ep, pkt->base_hdr.peer)->rx_window))
+		    rxd_peer(ep, pkt->base_hdr.peer)->rx_window) ||
+		    pkt->base_hdr.flags & RXD_ACK_REQ)
 			rxd_ep_send_ack(ep, pkt->base_hdr.peer);
 		return;
 	}
@@ -219,6 +206,12 @@ static void rxd_verify_active(struct rxd_ep *ep, fi_addr_t addr, fi_addr_t peer_
 			     struct rxd_pkt_entry, d_entry))->type == RXD_RTS) {
 		dlist_pop_front(&(rxd_peer(ep, addr)->unacked),
 				struct rxd_pkt_entry, pkt_entry, d_entry);
+		if (!(pkt_entry->flags & RXD_PKT_RETRANS))
+			rxd_update_rtt(rxd_peer(ep, addr), ofi_gettime_us() -
+				       pkt_entry->timestamp);
+		else
+			rxd_peer(ep, addr)->rto =
+				rxd_get_timeout(rxd_peer(ep, addr));
 		if (pkt_entry->flags & RXD_PKT_IN_USE) {
 			dlist_insert_tail(&pkt_entry->d_entry, &ep->ctrl_pkts);
 			pkt_entry->flags |= RXD_PKT_ACKED;
@@ -241,8 +234,7 @@ int rxd_start_xfer(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 {
 	struct rxd_base_hdr *hdr = rxd_get_base_hdr(tx_entry->pkt);
 
-	if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-	    rxd_peer(ep, tx_entry->peer)->tx_window)
+	if (rxd_peer_window_full(rxd_peer(ep, tx_entry->peer)))
 		return 0;
 
 	tx_entry->start_seq = rxd_set_pkt_seq(rxd_peer(ep, tx_entry->peer),
@@ -263,8 +255,7 @@ int rxd_start_xfer(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 				  &(rxd_peer(ep, tx_entry->peer)->rma_rx_list));
 	}
 
-	return rxd_peer(ep, tx_entry->peer)->unacked_cnt <
-	       rxd_peer(ep,tx_entry->peer)->tx_window;
+	return !rxd_peer_window_full(rxd_peer(ep, tx_entry->peer));
 }
 
 void rxd_progress_tx_list(struct rxd_ep *ep, struct rxd_peer *peer)
@@ -306,10 +297,8 @@ void rxd_progress_tx_list(struct rxd_ep *ep, struct rxd_peer *peer)
 		}
 
 		if (tx_entry->op == RXD_DATA_READ && !tx_entry->bytes_done) {
-			if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-		    	    rxd_peer(ep, tx_entry->peer)->tx_window) {
+			if (rxd_peer_window_full(rxd_peer(ep, tx_entry->peer)))
 				break;
-			}
 			tx_entry->start_seq = rxd_peer(ep,tx_entry->peer)->tx_seq_no;
 			rxd_peer(ep, tx_entry->peer)->tx_seq_no = tx_entry->start_seq +
 							      tx_entry->num_segs;
@@ -897,114 +886,36 @@ static struct rxd_x_entry *rxd_get_data_x_entry(struct rxd_ep *ep,
 	return ofi_bufpool_get_ibuf(ep->tx_entry_pool.pool, data_pkt->ext_hdr.tx_id);
 }
 
-static void rxd_progress_buf_pkts(struct rxd_ep *ep, fi_addr_t peer)
-{
-	struct fi_cq_err_entry err_entry;
-	struct rxd_pkt_entry *pkt_entry;
-	struct rxd_base_hdr *base_hdr;
-	struct rxd_sar_hdr *sar_hdr;
-	struct rxd_tag_hdr *tag_hdr;
-	struct rxd_data_hdr *data_hdr;
-	struct rxd_rma_hdr *rma_hdr;
-	struct rxd_atom_hdr *atom_hdr;
-	void *msg;
-	int ret;
-	size_t msg_size;
-	struct rxd_x_entry *rx_entry = NULL;
-	struct rxd_data_pkt *data_pkt;
-	struct dlist_entry *bufpkts;
-
-	bufpkts = &(rxd_peer(ep, peer)->buf_pkts);
-	while (!dlist_empty(bufpkts)) {
-		pkt_entry = container_of(bufpkts->next, struct rxd_pkt_entry,
-					 d_entry);
-		base_hdr = rxd_get_base_hdr(pkt_entry);
-		if (base_hdr->seq_no != rxd_peer(ep, peer)->rx_seq_no)
-			return;
-		if (base_hdr->type == RXD_DATA || base_hdr->type == RXD_DATA_READ) {
-			data_pkt = (struct rxd_data_pkt *) pkt_entry->pkt;
-			rx_entry = rxd_get_data_x_entry(ep, data_pkt);
-			rxd_ep_recv_data(ep, rx_entry, data_pkt, pkt_entry->pkt_size);
-		} else {
-			ret = rxd_unpack_init_rx(ep, &rx_entry, pkt_entry, base_hdr, &sar_hdr,
-					      &tag_hdr, &data_hdr, &rma_hdr, &atom_hdr,
-					      &msg, &msg_size);
-			if (ret) {
-				memset(&err_entry, 0, sizeof(err_entry));
-				err_entry.err = FI_ETRUNC;
-				err_entry.prov_errno = 0;
-				ret = ofi_cq_write_error(&rxd_ep_rx_cq(ep)->util_cq,
-							 &err_entry);
-				if (ret)
-					FI_WARN(&rxd_prov, FI_LOG_EP_CTRL,
-						"could not write error entry\n");
-				rxd_peer(ep, base_hdr->peer)->rx_seq_no++;
-				rxd_remove_free_pkt_entry(pkt_entry);
-				continue;
-			}
-			if (!rx_entry) {
-				if (base_hdr->type == RXD_MSG ||
-				    base_hdr->type == RXD_TAGGED) {
-					rxd_peer(ep, base_hdr->peer)->rx_seq_no++;
-					continue;
-				}
-				break;
-			}
-
-			rxd_progress_op(ep, rx_entry, pkt_entry, base_hdr,
-					sar_hdr, tag_hdr, data_hdr, rma_hdr,
-					atom_hdr, &msg, msg_size);
-		}
-
-		rxd_peer(ep,base_hdr->peer)->rx_seq_no++;
-		rxd_remove_free_pkt_entry(pkt_entry);
-	}
-}
-
-static void rxd_handle_data(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
+static void rxd_process_data(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 {
 	struct rxd_data_pkt *pkt = (struct rxd_data_pkt *) (pkt_entry->pkt);
 	struct rxd_x_entry *x_entry;
 	struct rxd_unexp_msg *unexp_msg;
 
-	if (pkt_entry->pkt_size < sizeof(*pkt) + ep->rx_prefix_size) {
-		FI_WARN(&rxd_prov, FI_LOG_CQ,
-			"Cannot process packet smaller than minimum header size\n");
-		goto free;
-	}
-
-	if (pkt->base_hdr.seq_no == rxd_peer(ep,
-				    pkt->base_hdr.peer)->rx_seq_no) {
-		rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no++;
-		if (pkt->base_hdr.type == RXD_DATA &&
-		    rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp) {
-			unexp_msg = rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp;
-			dlist_insert_tail(&pkt_entry->d_entry, &unexp_msg->pkt_list);
-			if (pkt->ext_hdr.seg_no + 1 == unexp_msg->sar_hdr->num_segs - 1) {
-				rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp = NULL;
-				rxd_ep_send_ack(ep, pkt->base_hdr.peer);
-			}
-			return;
+	rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no++;
+	if (pkt->base_hdr.type == RXD_DATA &&
+	    rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp) {
+		unexp_msg = rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp;
+		dlist_insert_tail(&pkt_entry->d_entry, &unexp_msg->pkt_list);
+		if (pkt->ext_hdr.seg_no + 1 == unexp_msg->sar_hdr->num_segs - 1) {
+			rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp = NULL;
+			rxd_ep_send_ack(ep, pkt->base_hdr.peer);
+		} else if (pkt->base_hdr.flags & RXD_ACK_REQ) {
+			rxd_ep_send_ack(ep, pkt->base_hdr.peer);
 		}
-		x_entry = rxd_get_data_x_entry(ep, pkt);
-		rxd_ep_recv_data(ep, x_entry, pkt, pkt_entry->pkt_size);
-		if (!dlist_empty(&(rxd_peer(ep,
-				   pkt->base_hdr.peer)->buf_pkts)))
-			rxd_progress_buf_pkts(ep, pkt->base_hdr.peer);
-	} else if (!rxd_env.retry) {
-		dlist_insert_order(&(rxd_peer(ep,
-				     pkt->base_hdr.peer)->buf_pkts),
-				   &rxd_comp_pkt_seq_no, &pkt_entry->d_entry);
 		return;
-	} else if (rxd_peer(ep, pkt->base_hdr.peer)->peer_addr !=
-		   RXD_ADDR_INVALID) {
-		rxd_ep_send_ack(ep, pkt->base_hdr.peer);
 	}
-free:
+	x_entry = rxd_get_data_x_entry(ep, pkt);
+	rxd_ep_recv_data(ep, x_entry, pkt, pkt_entry->pkt_size);
 	ofi_buf_free(pkt_entry);
 }
 
-static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
+/*
+ * Returns -FI_EAGAIN if the op could not start.  The packet is then
+ * acked and released, unless hold is set and the caller keeps it.
+ */
+static int rxd_process_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry,
+			  bool hold)
 {
 	struct rxd_x_entry *rx_entry;
 	struct rxd_base_hdr *base_hdr = rxd_get_base_hdr(pkt_entry);
@@ -1017,18 +928,6 @@ static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 	size_t msg_size;
 	int ret;
 
-	if (base_hdr->seq_no != rxd_peer(ep, base_hdr->peer)->rx_seq_no) {
-		if (!rxd_env.retry) {
-			dlist_insert_order(&(rxd_peer(ep, base_hdr->peer)->buf_pkts),
-					   &rxd_comp_pkt_seq_no, &pkt_entry->d_entry);
-			return;
-		}
-
-		if (rxd_peer(ep, base_hdr->peer)->peer_addr != RXD_ADDR_INVALID)
-			goto ack;
-		goto release;
-	}
-
 	if (rxd_peer(ep, base_hdr->peer)->peer_addr == RXD_ADDR_INVALID)
 		goto release;
 
@@ -1036,12 +935,12 @@ static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 				 &tag_hdr, &data_hdr, &rma_hdr, &atom_hdr,
 				 &msg, &msg_size);
 	if (ret)
-		goto ack;
+		goto again;
 
 	if (!rx_entry) {
 		if (base_hdr->type == RXD_MSG || base_hdr->type == RXD_TAGGED) {
 			if (!rxd_peer(ep, base_hdr->peer)->curr_unexp)
-				goto ack;
+				goto again;
 
 			rxd_peer(ep, base_hdr->peer)->rx_seq_no++;
 
@@ -1049,10 +948,10 @@ static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 				rxd_peer(ep, base_hdr->peer)->curr_unexp = NULL;
 
 			rxd_ep_send_ack(ep, base_hdr->peer);
-			return;
+			return 0;
 		}
 		rxd_peer(ep, base_hdr->peer)->rx_window = 0;
-		goto ack;
+		goto again;
 	}
 
 	rxd_peer(ep, base_hdr->peer)->rx_seq_no++;
@@ -1060,13 +959,189 @@ static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 	rxd_progress_op(ep, rx_entry, pkt_entry, base_hdr, sar_hdr, tag_hdr,
 			data_hdr, rma_hdr, atom_hdr, &msg, msg_size);
 
-	if (!dlist_empty(&(rxd_peer(ep, base_hdr->peer)->buf_pkts)))
-		rxd_progress_buf_pkts(ep, base_hdr->peer);
-
-ack:
 	rxd_ep_send_ack(ep, base_hdr->peer);
 release:
 	ofi_buf_free(pkt_entry);
+	return 0;
+
+again:
+	if (!hold) {
+		rxd_ep_send_ack(ep, base_hdr->peer);
+		ofi_buf_free(pkt_entry);
+	}
+	return -FI_EAGAIN;
+}
+
+/*
+ * Buffered packets are kept in sequence order.  Packets usually arrive in
+ * order after a gap, so search for the insertion point from the tail.
+ */
+static void rxd_insert_buf_pkt(struct rxd_peer *peer,
+			       struct rxd_pkt_entry *pkt_entry)
+{
+	struct dlist_entry *item;
+	uint64_t seq_no = rxd_get_base_hdr(pkt_entry)->seq_no;
+
+	for (item = peer->buf_pkts.prev; item != &peer->buf_pkts;
+	     item = item->prev) {
+		if (ofi_before(rxd_get_base_hdr(container_of(item,
+				struct rxd_pkt_entry, d_entry))->seq_no, seq_no))
+			break;
+	}
+	dlist_insert_after(&pkt_entry->d_entry, item);
+}
+
+static inline uint64_t *rxd_sack_word(struct rxd_peer *peer, uint64_t seq_no)
+{
+	return &peer->rx_sack[(seq_no % RXD_SACK_BITS) / 64];
+}
+
+static inline uint64_t rxd_sack_bit(uint64_t seq_no)
+{
+	return 1ULL << (seq_no % 64);
+}
+
+/*
+ * Hold a packet received ahead of the next expected sequence number until
+ * the gap is filled, and record it for selective acks.  Returns 0 if the
+ * packet is a duplicate or too far ahead to track.
+ */
+static int rxd_sack_pkt(struct rxd_peer *peer, struct rxd_pkt_entry *pkt_entry)
+{
+	uint64_t seq_no = rxd_get_base_hdr(pkt_entry)->seq_no;
+
+	if (seq_no - peer->rx_seq_no >= RXD_SACK_BITS ||
+	    *rxd_sack_word(peer, seq_no) & rxd_sack_bit(seq_no))
+		return 0;
+
+	*rxd_sack_word(peer, seq_no) |= rxd_sack_bit(seq_no);
+	rxd_insert_buf_pkt(peer, pkt_entry);
+	return 1;
+}
+
+static void rxd_progress_buf_pkts(struct rxd_ep *ep, fi_addr_t peer)
+{
+	struct rxd_pkt_entry *pkt_entry;
+	struct rxd_base_hdr *base_hdr;
+	struct dlist_entry *bufpkts;
+	uint64_t rx_seq_no;
+	bool held = false;
+
+	bufpkts = &(rxd_peer(ep, peer)->buf_pkts);
+	rx_seq_no = rxd_peer(ep, peer)->rx_seq_no;
+	while (!dlist_empty(bufpkts)) {
+		pkt_entry = container_of(bufpkts->next, struct rxd_pkt_entry,
+					 d_entry);
+		base_hdr = rxd_get_base_hdr(pkt_entry);
+		if (base_hdr->seq_no != rxd_peer(ep, peer)->rx_seq_no)
+			break;
+
+		dlist_remove(&pkt_entry->d_entry);
+		*rxd_sack_word(rxd_peer(ep, peer), base_hdr->seq_no) &=
+			~rxd_sack_bit(base_hdr->seq_no);
+		if (base_hdr->type == RXD_DATA ||
+		    base_hdr->type == RXD_DATA_READ) {
+			rxd_process_data(ep, pkt_entry);
+		} else if (rxd_process_op(ep, pkt_entry, !rxd_env.retry) &&
+			   !rxd_env.retry) {
+			/* The peer never resends the op, so keep it until it
+			 * can start.  With retries, the cleared sack makes
+			 * the peer resend it.
+			 */
+			dlist_insert_head(&pkt_entry->d_entry, bufpkts);
+			held = true;
+			break;
+		}
+	}
+	if (!held)
+		dlist_remove_init(&rxd_peer(ep, peer)->held_entry);
+	else if (dlist_empty(&rxd_peer(ep, peer)->held_entry))
+		dlist_insert_tail(&rxd_peer(ep, peer)->held_entry,
+				  &ep->held_peers);
+
+	/* let the sender know how far the gap was filled */
+	if (rxd_peer(ep, peer)->rx_seq_no != rx_seq_no)
+		rxd_ep_send_ack(ep, peer);
+}
+
+static void rxd_handle_ooo_pkt(struct rxd_ep *ep,
+			       struct rxd_pkt_entry *pkt_entry)
+{
+	struct rxd_base_hdr *base_hdr = rxd_get_base_hdr(pkt_entry);
+	struct rxd_peer *peer = rxd_peer(ep, base_hdr->peer);
+	int buffered;
+
+	if (!rxd_env.retry) {
+		rxd_insert_buf_pkt(peer, pkt_entry);
+		return;
+	}
+
+	if (peer->peer_addr == RXD_ADDR_INVALID)
+		goto free;
+
+	if (!ofi_before(peer->rx_seq_no, base_hdr->seq_no)) {
+		rxd_ep_send_ack(ep, base_hdr->peer);
+		goto free;
+	}
+
+	buffered = rxd_sack_pkt(peer, pkt_entry);
+	rxd_ep_send_dup_ack(ep, base_hdr->peer);
+	if (buffered)
+		return;
+free:
+	ofi_buf_free(pkt_entry);
+}
+
+static void rxd_handle_data(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
+{
+	struct rxd_data_pkt *pkt = (struct rxd_data_pkt *) (pkt_entry->pkt);
+	fi_addr_t peer = pkt->base_hdr.peer;
+
+	if (pkt_entry->pkt_size < sizeof(*pkt) + ep->rx_prefix_size) {
+		FI_WARN(&rxd_prov, FI_LOG_CQ,
+			"Cannot process packet smaller than minimum header size\n");
+		ofi_buf_free(pkt_entry);
+		return;
+	}
+
+	if (pkt->base_hdr.seq_no != rxd_peer(ep, peer)->rx_seq_no) {
+		rxd_handle_ooo_pkt(ep, pkt_entry);
+		return;
+	}
+
+	rxd_process_data(ep, pkt_entry);
+	if (!dlist_empty(&(rxd_peer(ep, peer)->buf_pkts)))
+		rxd_progress_buf_pkts(ep, peer);
+}
+
+static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
+{
+	fi_addr_t peer = rxd_get_base_hdr(pkt_entry)->peer;
+
+	if (rxd_get_base_hdr(pkt_entry)->seq_no !=
+	    rxd_peer(ep, peer)->rx_seq_no) {
+		rxd_handle_ooo_pkt(ep, pkt_entry);
+		return;
+	}
+
+	(void) rxd_process_op(ep, pkt_entry, false);
+	if (!dlist_empty(&(rxd_peer(ep, peer)->buf_pkts)))
+		rxd_progress_buf_pkts(ep, peer);
+}
+
+/* Retry buffered ops that could not start, see rxd_progress_buf_pkts() */
+void rxd_progress_held_peers(struct rxd_ep *ep)
+{
+	struct rxd_pkt_entry *pkt_entry;
+	struct rxd_peer *peer;
+	struct dlist_entry *tmp;
+
+	dlist_foreach_container_safe(&ep->held_peers, struct rxd_peer,
+				     peer, held_entry, tmp) {
+		pkt_entry = container_of(peer->buf_pkts.next,
+					 struct rxd_pkt_entry, d_entry);
+		rxd_progress_buf_pkts(ep, rxd_get_base_hdr(pkt_entry)->peer);
+	}
 }
 
 static void rxd_handle_cts(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
@@ -1082,19 +1157,57 @@ static void rxd_handle_cts(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 	rxd_update_peer(ep, cts->rts_addr, cts->cts_addr);
 }
 
+/*
+ * Mark the packets the peer reports holding past the cumulative ack.  The
+ * marks are refreshed by every ack, so the peer may drop packets it
+ * reported earlier.
+ */
+static void rxd_apply_sack(struct rxd_peer *peer, struct rxd_ack_pkt *ack)
+{
+	struct rxd_pkt_entry *pkt_entry;
+	uint64_t seq_no;
+
+	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
+				pkt_entry, d_entry) {
+		seq_no = rxd_get_base_hdr(pkt_entry)->seq_no;
+		if (ofi_before(seq_no, ack->base_hdr.seq_no))
+			continue;
+		if (seq_no - ack->base_hdr.seq_no >= RXD_SACK_BITS)
+			break;
+
+		if (ack->sack[(seq_no % RXD_SACK_BITS) / 64] &
+		    (1ULL << (seq_no % 64)))
+			pkt_entry->flags |= RXD_PKT_SACKED;
+		else
+			pkt_entry->flags &= ~RXD_PKT_SACKED;
+	}
+}
+
 static void rxd_handle_ack(struct rxd_ep *ep, struct rxd_pkt_entry *ack_entry)
 {
 	struct rxd_ack_pkt *ack = (struct rxd_ack_pkt *) (ack_entry->pkt);
 	struct rxd_pkt_entry *pkt_entry;
 	fi_addr_t peer = ack->base_hdr.peer;
 	struct rxd_base_hdr *hdr;
+	uint64_t sent = 0, backoff;
+	uint16_t acked = 0;
 
 	rxd_peer(ep, peer)->tx_window = (uint16_t) ack->ext_hdr.rx_id;
 
-	if (rxd_peer(ep, peer)->last_rx_ack == ack->base_hdr.seq_no)
+	if (rxd_peer(ep, peer)->last_rx_ack == ack->base_hdr.seq_no) {
+		rxd_apply_sack(rxd_peer(ep, peer), ack);
+		if (ack->base_hdr.flags & RXD_DUP_ACK &&
+		    !dlist_empty(&(rxd_peer(ep, peer)->unacked)) &&
+		    ofi_after_eq(ack->base_hdr.seq_no,
+				 rxd_peer(ep, peer)->recover_seq) &&
+		    ++rxd_peer(ep, peer)->dup_acks == RXD_DUP_ACK_THRESH)
+			rxd_fast_retransmit(ep, rxd_peer(ep, peer));
 		return;
+	}
 
 	rxd_peer(ep, peer)->last_rx_ack = ack->base_hdr.seq_no;
+	rxd_peer(ep, peer)->dup_acks = 0;
+	backoff = rxd_get_timeout(rxd_peer(ep, peer));
 
 	if (dlist_empty(&(rxd_peer(ep, peer)->unacked)))
 		return;
@@ -1109,6 +1222,13 @@ static void rxd_handle_ack(struct rxd_ep *ep, struct rxd_pkt_entry *ack_entry)
 		if (ofi_after_eq(hdr->seq_no, ack->base_hdr.seq_no))
 			break;
 
+		if (!(pkt_entry->flags & RXD_PKT_ACKED)) {
+			acked++;
+			/* Karn: only time packets that were sent once */
+			if (!(pkt_entry->flags & RXD_PKT_RETRANS))
+				sent = MAX(sent, pkt_entry->timestamp);
+		}
+
 		if (pkt_entry->flags & RXD_PKT_IN_USE) {
 			pkt_entry->flags |= RXD_PKT_ACKED;
 			pkt_entry = container_of((&pkt_entry->d_entry)->next,
@@ -1123,6 +1243,22 @@ static void rxd_handle_ack(struct rxd_ep *ep, struct rxd_pkt_entry *ack_entry)
 					struct rxd_pkt_entry, d_entry);
 	}
 
+	/* without a valid sample, keep the backed off timeout (RFC 6298 5.7) */
+	if (sent)
+		rxd_update_rtt(rxd_peer(ep, peer), ofi_gettime_us() - sent);
+	else if (acked)
+		rxd_peer(ep, peer)->rto = backoff;
+	if (acked) {
+		rxd_peer(ep, peer)->ack_time = ofi_gettime_us();
+		rxd_update_cwnd(rxd_peer(ep, peer), acked);
+	}
+
+	/* a partial ack during recovery points at the next hole */
+	rxd_apply_sack(rxd_peer(ep, peer), ack);
+	if (acked && ofi_after_eq(rxd_peer(ep, peer)->recover_seq,
+				  ack->base_hdr.seq_no))
+		rxd_retransmit_holes(ep, rxd_peer(ep, peer));
+
 	rxd_progress_tx_list(ep, rxd_peer(ep, ack->base_hdr.peer));
 }
 
@@ -1270,7 +1406,7 @@ ssize_t rxd_cq_sreadfrom(struct fid_cq *cq_fid, void *buf, size_t count,
 		ofi_mutex_unlock(&cq->ep_list_lock);
 
 		ret = fi_wait(&cq->wait->wait_fid, ep_retry == -1 ?
-			      timeout : rxd_get_timeout(ep_retry));
+			      timeout : ep_retry);
 
 		if (ep_retry != -1 && ret == -FI_ETIMEDOUT)
 			ret = 0;
@@ -273,16 +273,56 @@ static int rxd_ep_enable(struct rxd_ep *ep)
 }
 
 /*
- * Exponential back-off starting at 1ms, max 4s.
+ * Retransmission timeout computed as in RFC 6298, doubled for every
+ * unsuccessful retry and capped at 4s.
  */
-int rxd_get_timeout(int retry_cnt)
+uint64_t rxd_get_timeout(struct rxd_peer *peer)
 {
-	return MIN(1 << retry_cnt, 4000);
+	if (peer->retry_cnt >= 32 || (peer->rto << peer->retry_cnt) > RXD_MAX_RTO)
+		return RXD_MAX_RTO;
+	return peer->rto << peer->retry_cnt;
 }
 
-uint64_t rxd_get_retry_time(uint64_t start, int retry_cnt)
+uint64_t rxd_get_retry_time(struct rxd_peer *peer, uint64_t start)
 {
-	return start + rxd_get_timeout(retry_cnt);
+	return start + rxd_get_timeout(peer);
+}
+
+void rxd_update_rtt(struct rxd_peer *peer, uint64_t rtt)
+{
+	uint64_t delta;
+
+	rtt = MAX(rtt, 1);
+	if (!peer->srtt) {
+		peer->srtt = rtt;
+		peer->rttvar = rtt / 2;
+	} else {
+		delta = peer->srtt > rtt ? peer->srtt - rtt : rtt - peer->srtt;
+		peer->rttvar = (3 * peer->rttvar + delta) / 4;
+		peer->srtt = (7 * peer->srtt + rtt) / 8;
+	}
+
+	peer->rto = peer->srtt + MAX(4 * peer->rttvar,
+				     (uint64_t) rxd_env.min_rto);
+	peer->rto = MIN(peer->rto, RXD_MAX_RTO);
+}
+
+/*
+ * Slow start up to ssthresh, then grow by one packet per window of acked
+ * packets.  The window never exceeds max_unacked.
+ */
+void rxd_update_cwnd(struct rxd_peer *peer, uint16_t acked)
+{
+	if (peer->cwnd < peer->ssthresh) {
+		peer->cwnd += acked;
+	} else {
+		peer->cwnd_acked += acked;
+		if (peer->cwnd_acked >= peer->cwnd) {
+			peer->cwnd_acked -= peer->cwnd;
+			peer->cwnd++;
+		}
+	}
+	peer->cwnd = MIN(peer->cwnd, (uint16_t) rxd_env.max_unacked);
 }
 
 void rxd_init_data_pkt(struct rxd_ep *ep, struct rxd_x_entry *tx_entry,
@@ -379,14 +419,28 @@ void rxd_insert_unacked(struct rxd_ep *ep, fi_addr_t peer,
 	rxd_peer(ep, peer)->unacked_cnt++;
 }
 
+/*
+ * The peer only acks data on its own ack interval, which is sized for the
+ * largest window.  Ask for acks a few times per congestion window so the
+ * window keeps moving and a single lost ack does not stall the sender
+ * until the retransmission timer fires.
+ */
+static void rxd_check_ack_req(struct rxd_peer *peer,
+			      struct rxd_base_hdr *base_hdr)
+{
+	uint16_t interval = MAX(peer->cwnd / 4, 1);
+
+	if (rxd_peer_window_full(peer) || !(base_hdr->seq_no % interval))
+		base_hdr->flags |= RXD_ACK_REQ;
+}
+
 ssize_t rxd_ep_post_data_pkts(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 {
 	struct rxd_pkt_entry *pkt_entry;
 	struct rxd_data_pkt *data;
 
 	while (tx_entry->bytes_done != tx_entry->cq_entry.len) {
-		if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-		    rxd_peer(ep, tx_entry->peer)->tx_window)
+		if (rxd_peer_window_full(rxd_peer(ep, tx_entry->peer)))
 			return 0;
 
 		pkt_entry = rxd_get_tx_pkt(ep);
@@ -401,19 +455,20 @@ ssize_t rxd_ep_post_data_pkts(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 		if (data->base_hdr.type != RXD_DATA_READ)
 			data->base_hdr.seq_no++;
 
-		rxd_ep_send_pkt(ep, pkt_entry);
 		rxd_insert_unacked(ep, tx_entry->peer, pkt_entry);
+		rxd_check_ack_req(rxd_peer(ep, tx_entry->peer),
+				  &data->base_hdr);
+		rxd_ep_send_pkt(ep, pkt_entry);
 	}
 
-	return rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-	       rxd_peer(ep, tx_entry->peer)->tx_window;
+	return rxd_peer_window_full(rxd_peer(ep, tx_entry->peer));
 }
 
 ssize_t rxd_ep_send_pkt(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 {
 	ssize_t ret;
 	fi_addr_t dg_addr;
-	pkt_entry->timestamp = ofi_gettime_ms();
+	pkt_entry->timestamp = ofi_gettime_us();
 
 	dg_addr = (intptr_t) ofi_idx_lookup(&(rxd_ep_av(ep)->rxdaddr_dg_idx),
 					    (int)pkt_entry->peer);
@@ -557,7 +612,8 @@ size_t rxd_init_msg(void **ptr, const struct iovec *iov, size_t iov_count,
 	return done;
 }
 
-void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
+static void rxd_ep_send_ack_pkt(struct rxd_ep *rxd_ep, fi_addr_t peer,
+				uint16_t flags)
 {
 	struct rxd_pkt_entry *pkt_entry;
 	struct rxd_ack_pkt *ack;
@@ -574,9 +630,11 @@ void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
 
 	ack->base_hdr.version = RXD_PROTOCOL_VERSION;
 	ack->base_hdr.type = RXD_ACK;
+	ack->base_hdr.flags = flags;
 	ack->base_hdr.peer = (uint32_t) rxd_peer(rxd_ep, peer)->peer_addr;
 	ack->base_hdr.seq_no = rxd_peer(rxd_ep, peer)->rx_seq_no;
 	ack->ext_hdr.rx_id = rxd_peer(rxd_ep, peer)->rx_window;
+	memcpy(ack->sack, rxd_peer(rxd_ep, peer)->rx_sack, sizeof(ack->sack));
 	rxd_peer(rxd_ep, peer)->last_tx_ack = ack->base_hdr.seq_no;
 
 	dlist_insert_tail(&pkt_entry->d_entry, &rxd_ep->ctrl_pkts);
@@ -584,6 +642,17 @@ void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
 		rxd_remove_free_pkt_entry(pkt_entry);
 }
 
+void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
+{
+	rxd_ep_send_ack_pkt(rxd_ep, peer, 0);
+}
+
+/* Ack a packet that arrived ahead of the next expected sequence number */
+void rxd_ep_send_dup_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
+{
+	rxd_ep_send_ack_pkt(rxd_ep, peer, RXD_DUP_ACK);
+}
+
 static void rxd_ep_free_res(struct rxd_ep *ep)
 {
 	if (ep->tx_pkt_pool.pool)
@@ -914,36 +983,117 @@ static void rxd_peer_timeout(struct rxd_ep *rxd_ep, struct rxd_peer *peer)
 	dlist_remove(&peer->entry);
 }
 
-static void rxd_progress_pkt_list(struct rxd_ep *ep, struct rxd_peer *peer)
+/*
+ * The peer drops packets that arrive out of order, so once the oldest
+ * packet is due everything outstanding is sent again.
+ */
+static int rxd_retransmit(struct rxd_ep *ep, struct rxd_peer *peer,
+			  uint64_t current)
 {
 	struct rxd_pkt_entry *pkt_entry;
-	uint64_t current;
-	ssize_t ret;
 	int retry = 0;
 
-	current = ofi_gettime_ms();
-	if (peer->retry_cnt > RXD_MAX_PKT_RETRY) {
-		rxd_peer_timeout(ep, peer);
-		return;
+	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
+				pkt_entry, d_entry) {
+		if (pkt_entry->flags & (RXD_PKT_IN_USE | RXD_PKT_ACKED))
+			continue;
+		if (!retry && current < rxd_get_retry_time(peer,
+				MAX(pkt_entry->timestamp, peer->ack_time)))
+			break;
+		retry = 1;
+		/* the peer may have dropped what it selectively acked, so
+		 * a timeout resends everything (RFC 2018 section 8) */
+		pkt_entry->flags &= ~RXD_PKT_SACKED;
+		pkt_entry->flags |= RXD_PKT_RETRANS;
+		rxd_get_base_hdr(pkt_entry)->flags |= RXD_ACK_REQ;
+		if (rxd_ep_send_pkt(ep, pkt_entry))
+			break;
 	}
+	return retry;
+}
+
+/*
+ * Resend the packets the peer is missing: those not selectively acked that
+ * were sent before the last one it has, or just the first unacked packet
+ * if nothing was selectively acked.  Packets already resent are left to
+ * the retransmission timer.
+ */
+void rxd_retransmit_holes(struct rxd_ep *ep, struct rxd_peer *peer)
+{
+	struct rxd_pkt_entry *pkt_entry, *last = NULL;
 
 	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
 				pkt_entry, d_entry) {
-		if (pkt_entry->flags & (RXD_PKT_IN_USE | RXD_PKT_ACKED) ||
-		    current < rxd_get_retry_time(pkt_entry->timestamp,
-						 (uint8_t) peer->retry_cnt))
+		if (pkt_entry->flags & RXD_PKT_SACKED)
+			last = pkt_entry;
+	}
+
+	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
+				pkt_entry, d_entry) {
+		if (pkt_entry == last)
 			break;
-		retry = 1;
-		ret = rxd_ep_send_pkt(ep, pkt_entry);
-		if (ret)
+		if (pkt_entry->flags & (RXD_PKT_IN_USE | RXD_PKT_ACKED |
+					RXD_PKT_SACKED | RXD_PKT_RETRANS))
+			continue;
+		pkt_entry->flags |= RXD_PKT_RETRANS;
+		rxd_get_base_hdr(pkt_entry)->flags |= RXD_ACK_REQ;
+		if (rxd_ep_send_pkt(ep, pkt_entry) || !last)
 			break;
 	}
-	if (retry)
+}
+
+/*
+ * Duplicate acks caused by packets already in flight when a loss is
+ * repaired must not shrink the window again.  Ignore them until the peer
+ * acks everything sent so far.
+ */
+static void rxd_enter_recovery(struct rxd_peer *peer)
+{
+	peer->recover_seq = rxd_get_base_hdr(container_of(peer->unacked.prev,
+				struct rxd_pkt_entry, d_entry))->seq_no;
+	peer->ssthresh = MAX(peer->cwnd / 2, RXD_MIN_CWND);
+	peer->cwnd_acked = 0;
+	peer->dup_acks = 0;
+}
+
+/*
+ * Duplicate acks mean the peer dropped an out of order packet.  Resend
+ * everything outstanding without waiting for the timer and halve the
+ * congestion window.
+ */
+void rxd_fast_retransmit(struct rxd_ep *ep, struct rxd_peer *peer)
+{
+	rxd_enter_recovery(peer);
+	peer->cwnd = peer->ssthresh;
+	rxd_retransmit_holes(ep, peer);
+}
+
+static void rxd_progress_pkt_list(struct rxd_ep *ep, struct rxd_peer *peer)
+{
+	int timeout;
+
+	if (peer->retry_cnt > RXD_MAX_PKT_RETRY) {
+		rxd_peer_timeout(ep, peer);
+		return;
+	}
+
+	if (rxd_retransmit(ep, peer, ofi_gettime_us())) {
+		/* halve the window on the first timeout; collapse it only if
+		 * the retransmissions time out as well */
+		if (!peer->retry_cnt) {
+			rxd_enter_recovery(peer);
+			peer->cwnd = peer->ssthresh;
+		} else if (peer->retry_cnt == 1) {
+			peer->cwnd = RXD_MIN_CWND;
+		}
 		peer->retry_cnt++;
+	}
 
-	if (!dlist_empty(&peer->unacked))
-		ep->next_retry = ep->next_retry == -1 ? peer->retry_cnt :
-				 MIN(ep->next_retry, peer->retry_cnt);
+	if (!dlist_empty(&peer->unacked)) {
+		timeout = (int) ((rxd_get_timeout(peer) + 999) / 1000);
+		ep->next_retry = ep->next_retry == -1 ? timeout :
+				 MIN(ep->next_retry, timeout);
+	}
 }
 
 void rxd_ep_progress(struct util_ep *util_ep)
@@ -976,8 +1126,10 @@ void rxd_ep_progress(struct util_ep *util_ep)
 			rxd_handle_send_comp(ep, &cq_entry);
 	}
 
-	if (!rxd_env.retry)
+	if (!rxd_env.retry) {
+		rxd_progress_held_peers(ep);
 		goto out;
+	}
 
 	ep->next_retry = -1;
 	dlist_foreach_container_safe(&ep->rts_sent_list, struct rxd_peer,
@@ -1134,6 +1286,7 @@ int rxd_ep_init_res(struct rxd_ep *ep, struct fi_info *fi_info)
 	dlist_init(&ep->rx_tag_list);
 	dlist_init(&ep->active_peers);
 	dlist_init(&ep->rts_sent_list);
+	dlist_init(&ep->held_peers);
 	dlist_init(&ep->unexp_list);
 	dlist_init(&ep->unexp_tag_list);
 	dlist_init(&ep->ctrl_pkts);
@@ -1164,12 +1317,23 @@ int rxd_create_peer(struct rxd_ep *ep, uint64_t rxd_addr)
 	peer->tx_window = (uint16_t) rxd_env.max_unacked;
 	peer->unacked_cnt = 0;
 	peer->retry_cnt = 0;
+	peer->srtt = 0;
+	peer->rttvar = 0;
+	peer->rto = rxd_env.min_rto;
+	peer->ack_time = 0;
+	peer->cwnd = (uint16_t) MIN(RXD_INIT_CWND, rxd_env.max_unacked);
+	peer->ssthresh = (uint16_t) rxd_env.max_unacked;
+	peer->cwnd_acked = 0;
+	peer->dup_acks = 0;
+	peer->recover_seq = 0;
 	peer->active = 0;
+	memset(peer->rx_sack, 0, sizeof(peer->rx_sack));
 	dlist_init(&(peer->unacked));
 	dlist_init(&(peer->tx_list));
 	dlist_init(&(peer->rx_list));
 	dlist_init(&(peer->rma_rx_list));
 	dlist_init(&(peer->buf_pkts));
+	dlist_init(&(peer->held_entry));
 
 	if (ofi_idm_set(&(ep->peers_idm), (int) rxd_addr, peer) < 0)
 		goto err;
@@ -43,6 +43,7 @@ struct rxd_env rxd_env = {
 	.retry		= 1,
 	.max_peers	= 1024,
 	.max_unacked	= 128,
+	.min_rto	= 1000,
 };
 
 char *rxd_pkt_type_str[] = {
@@ -55,6 +56,8 @@ static void rxd_init_env(void)
 	fi_param_get_bool(&rxd_prov, "retry", &rxd_env.retry);
 	fi_param_get_int(&rxd_prov, "max_peers", &rxd_env.max_peers);
 	fi_param_get_int(&rxd_prov, "max_unacked", &rxd_env.max_unacked);
+	fi_param_get_int(&rxd_prov, "min_rto", &rxd_env.min_rto);
+	rxd_env.min_rto = MAX(rxd_env.min_rto, 1);
 }
 
 void rxd_info_to_core_mr_modes(uint32_t version, const struct fi_info *hints,
@@ -147,6 +150,10 @@ RXD_INI
 			"Maximum number of peers to track (default: 1024)");
 	fi_param_define(&rxd_prov, "max_unacked", FI_PARAM_INT,
 			"Maximum number of packets to send at once (default: 128)");
+	fi_param_define(&rxd_prov, "min_rto", FI_PARAM_INT,
+			"Lower bound in microseconds for the retransmission "
+			"timeout computed from measured round-trip times "
+			"(default: 1000)");
 
 	rxd_init_env();
 
@@ -212,7 +212,7 @@ ssize_t rxd_ep_generic_recvmsg(struct rxd_ep *rxd_ep, const struct iovec *iov,
 
 	ofi_mutex_lock(&rxd_ep->util_ep.lock);
 
-	if (ofi_cirque_isfull(rxd_ep->util_ep.rx_cq->cirq)) {
+	if (ofi_cq_isfull(rxd_ep->util_ep.rx_cq)) {
 		ret = -FI_EAGAIN;
 		goto out;
 	}
@@ -363,7 +363,7 @@ ssize_t rxd_ep_generic_inject(struct rxd_ep *rxd_ep, const struct iovec *iov,
 
 	ofi_mutex_lock(&rxd_ep->util_ep.lock);
 
-	if (ofi_cirque_isfull(rxd_ep->util_ep.tx_cq->cirq))
+	if (ofi_cq_isfull(rxd_ep->util_ep.tx_cq))
 		goto out;
 
 	rxd_addr = (intptr_t) ofi_idx_lookup(&(rxd_ep_av(rxd_ep)->fi_addr_idx),
@@ -407,7 +407,7 @@ ssize_t rxd_ep_generic_sendmsg(struct rxd_ep *rxd_ep, const struct iovec *iov,
 
 	ofi_mutex_lock(&rxd_ep->util_ep.lock);
 
-	if (ofi_cirque_isfull(rxd_ep->util_ep.tx_cq->cirq))
+	if (ofi_cq_isfull(rxd_ep->util_ep.tx_cq))
 		goto out;
 
 	rxd_addr = (intptr_t) ofi_idx_lookup(&(rxd_ep_av(rxd_ep)->fi_addr_idx),
@@ -42,6 +42,8 @@
 
 #define RXD_IOV_LIMIT		4
 #define RXD_NAME_LENGTH		64
+#define RXD_SACK_BITS		256
+#define RXD_SACK_WORDS		(RXD_SACK_BITS / 64)
 
 /* Values below are part of the wire protocol
    Reserved values are unused but defined for compatibility */
@@ -120,11 +122,14 @@ struct rxd_cts_pkt {
 
 /*
  * ACK: to signal received packets and send tx/rx id info
+ * 	- sack: packets received ahead of base_hdr.seq_no.  Sequence number
+ * 	  seq is marked by bit (seq % RXD_SACK_BITS) and the bitmap covers
+ * 	  the RXD_SACK_BITS - 1 sequence numbers following base_hdr.seq_no
  */
 struct rxd_ack_pkt {
 	struct rxd_base_hdr	base_hdr;
 	struct rxd_ext_hdr	ext_hdr;
-	//TODO fill in more fields? Selective ack?
+	uint64_t		sack[RXD_SACK_WORDS];
 };
 
 /*
@@ -687,6 +687,8 @@ struct rxm_ep {
 	void			(*handle_comp_error)(struct rxm_ep *ep);
 	ssize_t			(*handle_comp)(struct rxm_ep *ep,
 					       struct fi_cq_data_entry *comp);
+	/* Set while progressing the msg CQ, see rxm_ep_do_progress */
+	struct ofi_cq_batch	*cq_batch;
 
 	bool			msg_mr_local;
 	bool			rdm_mr_local;
@@ -750,8 +752,8 @@ ssize_t rxm_handle_rx_buf(struct rxm_rx_buf *rx_buf);
 int rxm_endpoint(struct fid_domain *domain, struct fi_info *info,
 			  struct fid_ep **ep, void *context);
 
-void rxm_cq_write_error(struct util_cq *cq, struct util_cntr *cntr,
-			void *op_context, int err);
+void rxm_cq_write_error(struct rxm_ep *rxm_ep, struct util_cq *cq,
+			struct util_cntr *cntr, void *op_context, int err);
 void rxm_cq_write_error_all(struct rxm_ep *rxm_ep, int err);
 void rxm_handle_comp_error(struct rxm_ep *rxm_ep);
 ssize_t rxm_handle_comp(struct rxm_ep *rxm_ep, struct fi_cq_data_entry *comp);
@@ -856,42 +858,72 @@ static inline void rxm_cntr_incerr(struct util_cntr *cntr)
 		cntr->cntr_fid.ops->adderr(&cntr->cntr_fid, 1);
 }
 
+/* Errors are written directly to the CQ, after any batched completions */
+static inline void rxm_cq_flush_batch(struct rxm_ep *rxm_ep)
+{
+	int ret;
+
+	if (!rxm_ep->cq_batch)
+		return;
+
+	ret = ofi_cq_batch_flush(rxm_ep->cq_batch);
+	if (ret) {
+		FI_WARN(&rxm_prov, FI_LOG_CQ,
+			"Unable to report batched completions\n");
+		assert(0);
+	}
+}
+
 static inline void
-rxm_cq_write(struct util_cq *cq, void *context, uint64_t flags, size_t len,
-	     void *buf, uint64_t data, uint64_t tag)
+rxm_cq_write(struct rxm_ep *rxm_ep, struct util_cq *cq, void *context,
+	     uint64_t flags, size_t len, void *buf, uint64_t data,
+	     uint64_t tag)
 {
 	int ret;
 
 	FI_DBG(&rxm_prov, FI_LOG_CQ, "Reporting %s completion\n",
 	       fi_tostr((void *) &flags, FI_TYPE_CQ_EVENT_FLAGS));
 
-	ret = ofi_cq_write(cq, context, flags, len, buf, data, tag);
+	if (rxm_ep->cq_batch) {
+		ret = ofi_cq_batch_write(rxm_ep->cq_batch, cq, context, flags,
+					 len, buf, data, tag,
+					 FI_ADDR_NOTAVAIL);
+	} else {
+		ret = ofi_cq_write(cq, context, flags, len, buf, data, tag);
+		if (cq->wait)
+			cq->wait->signal(cq->wait);
+	}
 	if (ret) {
 		FI_WARN(&rxm_prov, FI_LOG_CQ,
 			"Unable to report completion\n");
 		assert(0);
 	}
-	if (cq->wait)
-		cq->wait->signal(cq->wait);
 }
 
 static inline void
-rxm_cq_write_src(struct util_cq *cq, void *context, uint64_t flags, size_t len,
-		 void *buf, uint64_t data, uint64_t tag, fi_addr_t addr)
+rxm_cq_write_src(struct rxm_ep *rxm_ep, struct util_cq *cq, void *context,
+		 uint64_t flags, size_t len, void *buf, uint64_t data,
+		 uint64_t tag, fi_addr_t addr)
 {
 	int ret;
 
 	FI_DBG(&rxm_prov, FI_LOG_CQ, "Reporting %s completion\n",
 	       fi_tostr((void *) &flags, FI_TYPE_CQ_EVENT_FLAGS));
 
-	ret = ofi_cq_write_src(cq, context, flags, len, buf, data, tag, addr);
+	if (rxm_ep->cq_batch) {
+		ret = ofi_cq_batch_write(rxm_ep->cq_batch, cq, context, flags,
+					 len, buf, data, tag, addr);
+	} else {
+		ret = ofi_cq_write_src(cq, context, flags, len, buf, data,
+				       tag, addr);
+		if (cq->wait)
+			cq->wait->signal(cq->wait);
+	}
 	if (ret) {
 		FI_WARN(&rxm_prov, FI_LOG_CQ,
 			"Unable to report completion\n");
 		assert(0);
 	}
-	if (cq->wait)
-		cq->wait->signal(cq->wait);
 }
 
 ssize_t rxm_get_conn(struct rxm_ep *rxm_ep, fi_addr_t addr,
@@ -984,12 +1016,12 @@ rxm_cq_write_recv_comp(struct rxm_rx_buf *rx_buf, void *context, uint64_t flags,
 	}
 
 	if (rx_buf->ep->rxm_info->caps & FI_SOURCE)
-		rxm_cq_write_src(rx_buf->ep->util_ep.rx_cq, context,
+		rxm_cq_write_src(rx_buf->ep, rx_buf->ep->util_ep.rx_cq, context,
 				 flags, len, buf, rx_buf->pkt.hdr.data,
 				 rx_buf->pkt.hdr.tag,
 				 rx_buf->conn->peer->fi_addr);
 	else
-		rxm_cq_write(rx_buf->ep->util_ep.rx_cq, context,
+		rxm_cq_write(rx_buf->ep, rx_buf->ep->util_ep.rx_cq, context,
 			     flags, len, buf, rx_buf->pkt.hdr.data,
 			     rx_buf->pkt.hdr.tag);
 }
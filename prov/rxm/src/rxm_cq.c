@@ -141,6 +141,7 @@ static void rxm_cq_write_error_trunc(struct rxm_rx_buf *rx_buf, size_t done_len)
 	FI_WARN(&rxm_prov, FI_LOG_CQ, "Message truncated: "
 		"recv buf length: %zu message length: %" PRIu64 "\n",
 		done_len, rx_buf->pkt.hdr.size);
+	rxm_cq_flush_batch(rx_buf->ep);
 	ret = ofi_cq_write_error_trunc(rx_buf->ep->util_ep.rx_cq,
 				       rx_buf->recv_entry->context,
 				       rx_buf->recv_entry->comp_flags |
@@ -186,11 +187,31 @@ rxm_cq_write_tx_comp(struct rxm_ep *rxm_ep, uint64_t comp_flags,
 		     void *app_context,  uint64_t flags)
 {
 	if (flags & FI_COMPLETION) {
-		rxm_cq_write(rxm_ep->util_ep.tx_cq, app_context,
+		rxm_cq_write(rxm_ep, rxm_ep->util_ep.tx_cq, app_context,
 			     comp_flags, 0, NULL, 0, 0);
 	}
 }
 
+/*
+ * Sends issued by util_coll with FI_PEER_TRANSFER complete through its
+ * peer transfer callback on every protocol, not only eager.
+ */
+static bool rxm_peer_xfer_tx_comp(struct rxm_ep *rxm_ep, uint64_t tag,
+				  void *app_context)
+{
+	struct fi_cq_tagged_entry cqe = {
+		.tag = tag,
+		.op_context = app_context,
+	};
+
+	if (!rxm_ep->util_coll_ep || !(tag & RXM_PEER_XFER_TAG_FLAG))
+		return false;
+
+	rxm_ep->util_coll_peer_xfer_ops->complete(rxm_ep->util_coll_ep,
+						  &cqe, 0);
+	return true;
+}
+
 static void rxm_finish_rma(struct rxm_ep *rxm_ep, struct rxm_tx_buf *rma_buf,
 			  uint64_t comp_flags)
 {
@@ -249,15 +270,19 @@ static void rxm_handle_sar_comp(struct rxm_ep *rxm_ep,
 				struct rxm_tx_buf *tx_buf)
 {
 	void *app_context;
-	uint64_t comp_flags, tx_flags;
+	uint64_t comp_flags, tx_flags, tag;
 
 	app_context = tx_buf->app_context;
 	comp_flags = ofi_tx_cq_flags(tx_buf->pkt.hdr.op);
 	tx_flags = tx_buf->flags;
+	tag = tx_buf->pkt.hdr.tag;
 
 	if (!rxm_complete_sar(rxm_ep, tx_buf))
 		return;
 
+	if (rxm_peer_xfer_tx_comp(rxm_ep, tag, app_context))
+		return;
+
 	rxm_cq_write_tx_comp(rxm_ep, comp_flags, app_context, tx_flags);
 	ofi_ep_tx_cntr_inc(&rxm_ep->util_ep);
 }
@@ -287,15 +312,22 @@ static void rxm_rndv_tx_finish(struct rxm_ep *rxm_ep,
 	if (!rxm_ep->rdm_mr_local)
 		rxm_msg_mr_closev(tx_buf->rma.mr, tx_buf->rma.count);
 
-	rxm_cq_write_tx_comp(rxm_ep, ofi_tx_cq_flags(tx_buf->pkt.hdr.op),
-			     tx_buf->app_context, tx_buf->flags);
+	/* Peer transfers complete to the collective, not the app's CQ or
+	 * counter.
+	 */
+	if (!rxm_peer_xfer_tx_comp(rxm_ep, tx_buf->pkt.hdr.tag,
+				   tx_buf->app_context)) {
+		rxm_cq_write_tx_comp(rxm_ep,
+				     ofi_tx_cq_flags(tx_buf->pkt.hdr.op),
+				     tx_buf->app_context, tx_buf->flags);
+		ofi_ep_tx_cntr_inc(&rxm_ep->util_ep);
+	}
 
 	if (rxm_ep->rndv_ops == &rxm_rndv_ops_write &&
 	    tx_buf->write_rndv.done_buf) {
 		ofi_buf_free(tx_buf->write_rndv.done_buf);
 		tx_buf->write_rndv.done_buf = NULL;
 	}
-	ofi_ep_tx_cntr_inc(&rxm_ep->util_ep);
 	rxm_free_tx_buf(rxm_ep, tx_buf);
 }
 
@@ -517,7 +549,7 @@ ssize_t rxm_rndv_read(struct rxm_rx_buf *rx_buf)
 			    rx_buf->recv_entry->rxm_iov.count, total_len,
 			    rx_buf);
 	if (ret) {
-		rxm_cq_write_error(rx_buf->ep->util_ep.rx_cq,
+		rxm_cq_write_error(rx_buf->ep, rx_buf->ep->util_ep.rx_cq,
 				   rx_buf->ep->util_ep.rx_cntr, rx_buf, (int) ret);
 	}
 	return ret;
@@ -560,7 +592,7 @@ static ssize_t rxm_rndv_handle_wr_data(struct rxm_rx_buf *rx_buf)
 			    tx_buf->rma.count, total_len, tx_buf);
 
 	if (ret)
-		rxm_cq_write_error(rx_buf->ep->util_ep.rx_cq,
+		rxm_cq_write_error(rx_buf->ep, rx_buf->ep->util_ep.rx_cq,
 				   rx_buf->ep->util_ep.rx_cntr,
 				   tx_buf, (int) ret);
 	rxm_free_rx_buf(rx_buf);
@@ -1002,8 +1034,8 @@ err:
 static void rxm_handle_remote_write(struct rxm_ep *rxm_ep,
 				   struct fi_cq_data_entry *comp)
 {
-	rxm_cq_write(rxm_ep->util_ep.rx_cq, NULL, comp->flags, comp->len, NULL,
-		     comp->data, 0);
+	rxm_cq_write(rxm_ep, rxm_ep->util_ep.rx_cq, NULL, comp->flags,
+		     comp->len, NULL, comp->data, 0);
 	ofi_ep_rem_wr_cntr_inc(&rxm_ep->util_ep);
 	if (comp->op_context)
 		rxm_free_rx_buf(comp->op_context);
@@ -1326,7 +1358,7 @@ write_err:
 			"unknown atomic request op!\n");
 		assert(0);
 	}
-	rxm_cq_write_error(rxm_ep->util_ep.tx_cq, cntr,
+	rxm_cq_write_error(rxm_ep, rxm_ep->util_ep.tx_cq, cntr,
 			   tx_buf->app_context, (int) ret);
 	goto free;
 }
@@ -1660,8 +1692,8 @@ ssize_t rxm_get_dyn_rbuf(struct ofi_cq_rbuf_entry *entry, struct iovec *iov,
 	return 0;
 }
 
-void rxm_cq_write_error(struct util_cq *cq, struct util_cntr *cntr,
-			void *op_context, int err)
+void rxm_cq_write_error(struct rxm_ep *rxm_ep, struct util_cq *cq,
+			struct util_cntr *cntr, void *op_context, int err)
 {
 	struct fi_cq_err_entry err_entry = {0};
 	err_entry.op_context = op_context;
@@ -1671,6 +1703,8 @@ void rxm_cq_write_error(struct util_cq *cq, struct util_cntr *cntr,
 	if (cntr)
 		rxm_cntr_incerr(cntr);
 
+	rxm_cq_flush_batch(rxm_ep);
+
 	if (ofi_cq_write_error(cq, &err_entry)) {
 		FI_WARN(&rxm_prov, FI_LOG_CQ, "Unable to ofi_cq_write_error\n");
 		assert(0);
@@ -1684,6 +1718,7 @@ void rxm_cq_write_error_all(struct rxm_ep *rxm_ep, int err)
 
 	err_entry.prov_errno = err;
 	err_entry.err = -err;
+	rxm_cq_flush_batch(rxm_ep);
 	if (rxm_ep->util_ep.tx_cq) {
 		ret = ofi_cq_write_error(rxm_ep->util_ep.tx_cq, &err_entry);
 		if (ret) {
@@ -1830,6 +1865,7 @@ void rxm_handle_comp_error(struct rxm_ep *rxm_ep)
 		rxm_cntr_incerr(cntr);
 
 	assert(cq);
+	rxm_cq_flush_batch(rxm_ep);
 	ret = ofi_cq_write_error(cq, &err_entry);
 	if (ret) {
 		FI_WARN(&rxm_prov, FI_LOG_CQ, "Unable to ofi_cq_write_error\n");
@@ -1845,14 +1881,20 @@ ssize_t rxm_thru_comp(struct rxm_ep *ep, struct fi_cq_data_entry *comp)
 	cq = (comp->flags & (FI_RECV | FI_REMOTE_WRITE | FI_REMOTE_READ)) ?
 	     ep->util_ep.rx_cq : ep->util_ep.tx_cq;
 
-	ret = ofi_cq_write(cq, comp->op_context, comp->flags, comp->len,
-			   comp->buf, comp->data, 0);
+	if (ep->cq_batch) {
+		ret = ofi_cq_batch_write(ep->cq_batch, cq, comp->op_context,
+					 comp->flags, comp->len, comp->buf,
+					 comp->data, 0, FI_ADDR_NOTAVAIL);
+	} else {
+		ret = ofi_cq_write(cq, comp->op_context, comp->flags,
+				   comp->len, comp->buf, comp->data, 0);
+		if (cq->wait)
+			cq->wait->signal(cq->wait);
+	}
 	if (ret) {
 		FI_WARN(&rxm_prov, FI_LOG_CQ, "Unable to report completion\n");
 		assert(0);
 	}
-	if (cq->wait)
-		cq->wait->signal(cq->wait);
 
 	return ret;
 }
@@ -1872,6 +1914,7 @@ void rxm_thru_comp_error(struct rxm_ep *ep)
 	}
 
 	cq = (err_entry.flags & FI_RECV) ? ep->util_ep.rx_cq : ep->util_ep.tx_cq;
+	rxm_cq_flush_batch(ep);
 	ret = ofi_cq_write_error(cq, &err_entry);
 	if (ret) {
 		FI_WARN(&rxm_prov, FI_LOG_CQ, "Unable to ofi_cq_write_error\n");
@@ -1931,6 +1974,7 @@ ssize_t rxm_cq_owner_writeerr(struct fid_peer_cq *peer_cq,
 	}
 
 	rxm_cq = container_of(peer_cq, struct rxm_cq, peer_cq);
+	rxm_cq_flush_batch(rxm_ep);
 	return ofi_cq_write_error(&rxm_cq->util_cq, &cqe_err);
 }
 
@@ -1979,16 +2023,27 @@ int rxm_prepost_recv(struct rxm_ep *ep, struct fid_ep *rx_ep)
 	return 0;
 }
 
+/* Completions generated while processing the msg CQ are batched and
+ * written to the rxm CQs once progress completes.  The batch is owned by
+ * the outermost call, as progress may be driven recursively.  It is
+ * flushed before writing an error completion to keep completions ordered.
+ */
 void rxm_ep_do_progress(struct util_ep *util_ep)
 {
 	struct rxm_ep *rxm_ep = container_of(util_ep, struct rxm_ep, util_ep);
 	struct fi_cq_data_entry comp[32];
+	struct ofi_cq_batch cq_batch;
 	struct dlist_entry *conn_entry_tmp;
 	struct rxm_conn *rxm_conn;
 	size_t comp_read = 0;
 	uint64_t timestamp;
 	ssize_t ret, i, err;
 
+	if (!rxm_ep->cq_batch) {
+		ofi_cq_batch_init(&cq_batch);
+		rxm_ep->cq_batch = &cq_batch;
+	}
+
 	do {
 		ret = fi_cq_read(rxm_ep->msg_cq, &comp, 32);
 		if (ret > 0) {
@@ -2025,6 +2080,16 @@ void rxm_ep_do_progress(struct util_ep *util_ep)
 		}
 	} while ((ret > 0) && (comp_read < rxm_ep->comp_per_progress));
 
+	if (rxm_ep->cq_batch == &cq_batch) {
+		rxm_ep->cq_batch = NULL;
+		err = ofi_cq_batch_flush(&cq_batch);
+		if (err) {
+			FI_WARN(&rxm_prov, FI_LOG_CQ,
+				"Unable to report batched completions\n");
+			rxm_cq_write_error_all(rxm_ep, (int) err);
+		}
+	}
+
 	if (!dlist_empty(&rxm_ep->deferred_queue)) {
 		dlist_foreach_container_safe(&rxm_ep->deferred_queue,
 					     struct rxm_conn, rxm_conn,
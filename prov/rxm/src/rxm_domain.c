@@ -215,10 +215,19 @@ err1:
 	return FI_ADDR_NOTAVAIL;
 }
 
+static int rxm_peer_av_lookup(struct fid_peer_av *av, fi_addr_t fi_addr,
+			      void *addr, size_t *addrlen)
+{
+	struct rxm_av *rxm_av = container_of(av, struct rxm_av, peer_av);
+
+	return fi_av_lookup(&rxm_av->util_av.av_fid, fi_addr, addr, addrlen);
+}
+
 static struct fi_ops_av_owner rxm_av_owner_ops = {
 	.size = sizeof(struct fi_ops_av_owner),
 	.query = rxm_peer_av_query,
 	.ep_addr = rxm_peer_av_ep_addr,
+	.lookup = rxm_peer_av_lookup,
 };
 
 static int
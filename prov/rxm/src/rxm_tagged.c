@@ -50,8 +50,9 @@ rxm_discard_recv(struct rxm_ep *rxm_ep, struct rxm_rx_buf *rx_buf,
 	RXM_DBG_ADDR_TAG(FI_LOG_EP_DATA, "Discarding message",
 			 rx_buf->unexp_msg.addr, rx_buf->unexp_msg.tag);
 
-	rxm_cq_write(rxm_ep->util_ep.rx_cq, context, FI_TAGGED | FI_RECV,
-		     0, NULL, rx_buf->pkt.hdr.data, rx_buf->pkt.hdr.tag);
+	rxm_cq_write(rxm_ep, rxm_ep->util_ep.rx_cq, context,
+		     FI_TAGGED | FI_RECV, 0, NULL, rx_buf->pkt.hdr.data,
+		     rx_buf->pkt.hdr.tag);
 	rxm_free_rx_buf(rx_buf);
 }
 
@@ -94,8 +95,8 @@ rxm_peek_recv(struct rxm_ep *rxm_ep, fi_addr_t addr, uint64_t tag,
 		dlist_remove(&rx_buf->unexp_msg.entry);
 	}
 
-	rxm_cq_write(rxm_ep->util_ep.rx_cq, context, FI_TAGGED | FI_RECV,
-		     rx_buf->pkt.hdr.size, NULL,
+	rxm_cq_write(rxm_ep, rxm_ep->util_ep.rx_cq, context,
+		     FI_TAGGED | FI_RECV, rx_buf->pkt.hdr.size, NULL,
 		     rx_buf->pkt.hdr.data, rx_buf->pkt.hdr.tag);
 }
 
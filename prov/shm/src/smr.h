@@ -74,6 +74,7 @@ struct smr_env {
 	int disable_cma;
 	int use_dsa_sar;
 	size_t max_gdrcopy_size;
+	size_t cma_chunk_size;
 };
 
 extern struct smr_env smr_env;
@@ -110,8 +111,14 @@ int smr_query_atomic(struct fid_domain *domain, enum fi_datatype datatype,
 
 #define SMR_IOV_LIMIT		4
 
+#define SMR_CMA_CHUNK_MIN	(64 * 1024)
+#define SMR_CMA_CHUNK_MAX	(4 * 1024 * 1024)
+#define SMR_CMA_CHUNK_DEF	(512 * 1024)
+
 struct smr_rx_entry {
 	struct fi_peer_rx_entry	peer_entry;
+	struct dlist_entry	match_entry;
+	uint64_t		seq;
 	struct iovec		iov[SMR_IOV_LIMIT];
 	void			*desc[SMR_IOV_LIMIT];
 	int64_t			peer_id;
@@ -177,11 +184,55 @@ OFI_DECLARE_FREESTACK(struct smr_rx_entry, smr_recv_fs);
 OFI_DECLARE_FREESTACK(struct smr_tx_entry, smr_tx_fs);
 OFI_DECLARE_FREESTACK(struct smr_pend_entry, smr_pend_fs);
 
+/*
+ * Receive and unexpected message queues.  All entries are kept on list in
+ * insertion order.  Tagged queues additionally index entries that carry
+ * no ignore bits into hash buckets keyed on the tag; entries with ignore
+ * bits go on wild_list.  The sequence number recorded on insertion is used
+ * to pick the oldest match between a bucket and wild_list.  The source
+ * address is not part of the hash key because FI_ADDR_UNSPEC on either side
+ * matches any address.
+ */
+#define SMR_MATCH_HASH_SIZE	256
+
 struct smr_queue {
 	struct dlist_entry list;
+	struct dlist_entry wild_list;
+	struct dlist_entry *hash;
 	dlist_func_t *match_func;
+	uint64_t seq;
 };
 
+static inline struct dlist_entry *
+smr_queue_bucket(struct smr_queue *queue, uint64_t tag)
+{
+	tag *= 0x9E3779B97F4A7C15ULL;
+	return &queue->hash[(tag >> 32) & (SMR_MATCH_HASH_SIZE - 1)];
+}
+
+int smr_init_queue(struct smr_queue *queue, dlist_func_t *match_func,
+		   bool tagged);
+void smr_cleanup_queue(struct smr_queue *queue);
+void smr_queue_insert(struct smr_queue *queue, struct smr_rx_entry *entry);
+void smr_queue_remove(struct smr_queue *queue, struct smr_rx_entry *entry);
+struct smr_rx_entry *smr_queue_find(struct smr_queue *queue,
+				    const struct smr_match_attr *attr);
+struct smr_rx_entry *smr_queue_find_func(struct smr_queue *queue,
+					 dlist_func_t *match_func,
+					 const void *arg);
+
+static inline struct smr_rx_entry *
+smr_queue_remove_first(struct smr_queue *queue,
+		       const struct smr_match_attr *attr)
+{
+	struct smr_rx_entry *entry;
+
+	entry = smr_queue_find(queue, attr);
+	if (entry)
+		smr_queue_remove(queue, entry);
+	return entry;
+}
+
 struct smr_fabric {
 	struct util_fabric	util_fabric;
 };
@@ -239,9 +290,14 @@ struct smr_sock_info {
 	pthread_t		listener_thread;
 	int			*my_fds;
 	int			nfds;
-	struct smr_cmap_entry	peers[SMR_MAX_PEERS];
+	/* allocated in chunks of peer ids, like the peer map */
+	pthread_mutex_t		peers_lock;
+	struct smr_cmap_entry	*peers[SMR_PEER_CHUNK_CNT];
 };
 
+struct smr_cmap_entry *smr_sock_peer(struct smr_sock_info *sock_info,
+				     int64_t id);
+
 struct smr_srx_ctx {
 	struct fid_peer_srx	peer_srx;
 	struct smr_queue	recv_queue;
@@ -331,6 +387,14 @@ size_t smr_copy_from_sar(struct smr_freestack *sar_pool, struct smr_resp *resp,
 			 struct smr_cmd *cmd, struct ofi_mr **mr,
 			 const struct iovec *iov, size_t count,
 			 size_t *bytes_done, int *next);
+size_t smr_copy_to_sar_ring(struct smr_freestack *sar_pool,
+			    struct smr_resp *resp, struct smr_cmd *cmd,
+			    struct ofi_mr **mr, const struct iovec *iov,
+			    size_t count, size_t *bytes_done);
+size_t smr_copy_from_sar_ring(struct smr_freestack *sar_pool,
+			      struct smr_resp *resp, struct smr_cmd *cmd,
+			      struct ofi_mr **mr, const struct iovec *iov,
+			      size_t count, size_t *bytes_done);
 int smr_select_proto(enum fi_hmem_iface, bool use_ipc, bool cma_avail,
                      bool gdrcopy_avail, uint32_t op, uint64_t total_len,
                      uint64_t op_flags);
@@ -345,9 +409,9 @@ int smr_write_err_comp(struct util_cq *cq, void *context,
 		       uint64_t flags, uint64_t tag, uint64_t err);
 int smr_complete_tx(struct smr_ep *ep, void *context, uint32_t op,
 		    uint64_t flags);
-int smr_complete_rx(struct smr_ep *ep, void *context, uint32_t op,
-		    uint64_t flags, size_t len, void *buf, int64_t id,
-		    uint64_t tag, uint64_t data);
+int smr_complete_rx(struct smr_ep *ep, struct ofi_cq_batch *batch,
+		    void *context, uint32_t op, uint64_t flags, size_t len,
+		    void *buf, int64_t id, uint64_t tag, uint64_t data);
 
 static inline uint64_t smr_rx_cq_flags(uint32_t op, uint64_t rx_flags,
 				       uint16_t op_flags)
@@ -190,7 +190,7 @@ static ssize_t smr_generic_atomic(struct smr_ep *ep,
 	if (id < 0)
 		return -FI_EAGAIN;
 
-	peer_id = smr_peer_data(ep->region)[id].addr.id;
+	peer_id = smr_peer_data(ep->region)[id].id;
 	peer_smr = smr_peer_region(ep->region, id);
 
 	if (smr_peer_data(ep->region)[id].sar_status)
@@ -339,7 +339,7 @@ static ssize_t smr_atomic_inject(struct fid_ep *ep_fid, const void *buf,
 	if (id < 0)
 		return -FI_EAGAIN;
 
-	peer_id = smr_peer_data(ep->region)[id].addr.id;
+	peer_id = smr_peer_data(ep->region)[id].id;
 	peer_smr = smr_peer_region(ep->region, id);
 
 	if (smr_peer_data(ep->region)[id].sar_status) {
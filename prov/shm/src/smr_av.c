@@ -61,6 +61,7 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 	struct util_ep *util_ep;
 	struct smr_av *smr_av;
 	struct smr_ep *smr_ep;
+	struct smr_peer *peer;
 	struct dlist_entry *av_entry;
 	fi_addr_t util_addr;
 	int64_t shm_id = -1;
@@ -103,11 +104,12 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 		}
 
 		assert(shm_id >= 0 && shm_id < SMR_MAX_PEERS);
+		peer = smr_map_peer(smr_av->smr_map, shm_id);
 		if (flags & FI_AV_USER_ID) {
 			assert(fi_addr);
-			smr_av->smr_map->peers[shm_id].fiaddr = fi_addr[i];
+			peer->fiaddr = fi_addr[i];
 		} else {
-			smr_av->smr_map->peers[shm_id].fiaddr = util_addr;
+			peer->fiaddr = util_addr;
 		}
 		succ_count++;
 		smr_av->used++;
@@ -121,8 +123,7 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 			util_ep = container_of(av_entry, struct util_ep, av_entry);
 			smr_ep = container_of(util_ep, struct smr_ep, util_ep);
 			smr_map_to_endpoint(smr_ep->region, shm_id);
-			smr_ep->region->max_sar_buf_per_peer =
-				SMR_MAX_PEERS / smr_av->smr_map->num_peers;
+			smr_update_sar_per_peer(smr_ep->region);
 		}
 	}
 
@@ -164,13 +165,7 @@ static int smr_av_remove(struct fid_av *av_fid, fi_addr_t *fi_addr, size_t count
 			util_ep = container_of(av_entry, struct util_ep, av_entry);
 			smr_ep = container_of(util_ep, struct smr_ep, util_ep);
 			smr_unmap_from_endpoint(smr_ep->region, id);
-			if (smr_av->smr_map->num_peers > 0)
-				smr_ep->region->max_sar_buf_per_peer =
-					SMR_MAX_PEERS /
-					smr_av->smr_map->num_peers;
-			else
-				smr_ep->region->max_sar_buf_per_peer =
-					SMR_BUF_BATCH_MAX;
+			smr_update_sar_per_peer(smr_ep->region);
 		}
 		smr_av->used--;
 	}
@@ -191,7 +186,7 @@ static int smr_av_lookup(struct fid_av *av, fi_addr_t fi_addr, void *addr,
 	smr_av = container_of(util_av, struct smr_av, util_av);
 
 	id = smr_addr_lookup(util_av, fi_addr);
-	name = smr_av->smr_map->peers[id].peer.name;
+	name = smr_map_peer(smr_av->smr_map, id)->peer.name;
 
 	strncpy((char *) addr, name, *addrlen);
 
@@ -275,7 +270,7 @@ int smr_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 	(*av)->fid.ops = &smr_av_fi_ops;
 	(*av)->ops = &smr_av_ops;
 
-	ret = smr_map_create(&smr_prov, SMR_MAX_PEERS,
+	ret = smr_map_create(&smr_prov,
 			     util_domain->info_domain_caps & FI_HMEM ?
 			     SMR_FLAG_HMEM_ENABLED : 0, &smr_av->smr_map);
 	if (ret)
@@ -64,17 +64,28 @@ int smr_write_err_comp(struct util_cq *cq, void *context,
 	return ofi_peer_cq_write_error(cq, &err_entry);
 }
 
-int smr_complete_rx(struct smr_ep *ep, void *context, uint32_t op,
-		    uint64_t flags, size_t len, void *buf, int64_t id,
-		    uint64_t tag, uint64_t data)
+/* If batch is set, the completion is staged and written to the CQ when
+ * the caller flushes the batch.
+ */
+int smr_complete_rx(struct smr_ep *ep, struct ofi_cq_batch *batch,
+		    void *context, uint32_t op, uint64_t flags, size_t len,
+		    void *buf, int64_t id, uint64_t tag, uint64_t data)
 {
+	fi_addr_t addr;
+
 	ofi_ep_rx_cntr_inc_func(&ep->util_ep, op);
 
 	if (!(flags & (FI_REMOTE_CQ_DATA | FI_COMPLETION)))
 		return 0;
 
 	flags &= ~FI_COMPLETION;
+	addr = smr_map_peer(ep->region->map, id)->fiaddr;
+
+	if (batch) {
+		return ofi_cq_batch_write(batch, ep->util_ep.rx_cq, context,
+					  flags, len, buf, data, tag, addr);
+	}
 
 	return ofi_peer_cq_write(ep->util_ep.rx_cq, context, flags, len, buf,
-				 data, tag, ep->region->map->peers[id].fiaddr);
+				 data, tag, addr);
 }
\ No newline at end of file
@@ -169,14 +169,12 @@ static int smr_ep_cancel_recv(struct smr_ep *ep, struct smr_queue *queue,
 {
 	struct smr_srx_ctx *srx = smr_get_smr_srx(ep);
 	struct smr_rx_entry *recv_entry;
-	struct dlist_entry *entry;
 	int ret = 0;
 
 	ofi_spin_lock(&srx->lock);
-	entry = dlist_remove_first_match(&queue->list, smr_match_recv_ctx,
-					 context);
-	if (entry) {
-		recv_entry = container_of(entry, struct smr_rx_entry, peer_entry);
+	recv_entry = smr_queue_find_func(queue, smr_match_recv_ctx, context);
+	if (recv_entry) {
+		smr_queue_remove(queue, recv_entry);
 		ret = smr_write_err_comp(ep->util_ep.rx_cq,
 			recv_entry->peer_entry.context,
 			smr_rx_cq_flags(op, recv_entry->peer_entry.flags, 0),
@@ -257,10 +255,10 @@ int64_t smr_verify_peer(struct smr_ep *ep, fi_addr_t fi_addr)
 	id = smr_addr_lookup(ep->util_ep.av, fi_addr);
 	assert(id < SMR_MAX_PEERS);
 
-	if (smr_peer_data(ep->region)[id].addr.id >= 0)
+	if (smr_peer_data(ep->region)[id].id >= 0)
 		return id;
 
-	if (ep->region->map->peers[id].peer.id < 0) {
+	if (smr_map_peer(ep->region->map, id)->peer.id < 0) {
 		ret = smr_map_to_region(&smr_prov, ep->region->map, id);
 		if (ret == -ENOENT)
 			return -1;
@@ -291,11 +289,118 @@ static int smr_match_tagged(struct dlist_entry *item, const void *args)
 			     attr->tag);
 }
 
-static void smr_init_queue(struct smr_queue *queue,
-			   dlist_func_t *match_func)
+static int smr_match_unexp_tagged(struct dlist_entry *item, const void *args)
 {
+	struct smr_match_attr *attr = (struct smr_match_attr *)args;
+	struct smr_rx_entry *recv_entry;
+
+	recv_entry = container_of(item, struct smr_rx_entry, peer_entry);
+	return smr_match_id(recv_entry->peer_entry.addr, attr->id) &&
+	       smr_match_tag(recv_entry->peer_entry.tag, attr->ignore,
+			     attr->tag);
+}
+
+int smr_init_queue(struct smr_queue *queue, dlist_func_t *match_func,
+		   bool tagged)
+{
+	int i;
+
 	dlist_init(&queue->list);
+	dlist_init(&queue->wild_list);
 	queue->match_func = match_func;
+	queue->seq = 0;
+	queue->hash = NULL;
+
+	if (!tagged)
+		return FI_SUCCESS;
+
+	queue->hash = calloc(SMR_MATCH_HASH_SIZE, sizeof(*queue->hash));
+	if (!queue->hash)
+		return -FI_ENOMEM;
+
+	for (i = 0; i < SMR_MATCH_HASH_SIZE; i++)
+		dlist_init(&queue->hash[i]);
+
+	return FI_SUCCESS;
+}
+
+void smr_cleanup_queue(struct smr_queue *queue)
+{
+	free(queue->hash);
+	queue->hash = NULL;
+}
+
+void smr_queue_insert(struct smr_queue *queue, struct smr_rx_entry *entry)
+{
+	entry->seq = queue->seq++;
+	dlist_insert_tail((struct dlist_entry *) &entry->peer_entry,
+			  &queue->list);
+	if (!queue->hash)
+		return;
+
+	if (entry->ignore)
+		dlist_insert_tail(&entry->match_entry, &queue->wild_list);
+	else
+		dlist_insert_tail(&entry->match_entry,
+			smr_queue_bucket(queue, entry->peer_entry.tag));
+}
+
+void smr_queue_remove(struct smr_queue *queue, struct smr_rx_entry *entry)
+{
+	dlist_remove((struct dlist_entry *) &entry->peer_entry);
+	if (queue->hash)
+		dlist_remove(&entry->match_entry);
+}
+
+static struct smr_rx_entry *
+smr_queue_find_match(struct smr_queue *queue, struct dlist_entry *head,
+		     const struct smr_match_attr *attr)
+{
+	struct smr_rx_entry *entry;
+	struct dlist_entry *item;
+
+	dlist_foreach(head, item) {
+		entry = container_of(item, struct smr_rx_entry, match_entry);
+		if (queue->match_func((struct dlist_entry *) &entry->peer_entry,
+				      attr))
+			return entry;
+	}
+	return NULL;
+}
+
+struct smr_rx_entry *smr_queue_find_func(struct smr_queue *queue,
+					 dlist_func_t *match_func,
+					 const void *arg)
+{
+	struct dlist_entry *item;
+
+	item = dlist_find_first_match(&queue->list, match_func, arg);
+	return item ? container_of(item, struct smr_rx_entry, peer_entry) :
+		      NULL;
+}
+
+/*
+ * An exact lookup (no ignore bits) only needs to check the bucket for the tag
+ * and the wildcard list, returning whichever match was queued first.  Lookups
+ * with ignore bits set can match any bucket and fall back to an ordered walk.
+ */
+struct smr_rx_entry *smr_queue_find(struct smr_queue *queue,
+				    const struct smr_match_attr *attr)
+{
+	struct smr_rx_entry *entry, *wild_entry;
+
+	if (!queue->hash || attr->ignore)
+		return smr_queue_find_func(queue, queue->match_func, attr);
+
+	entry = smr_queue_find_match(queue, smr_queue_bucket(queue, attr->tag),
+				     attr);
+	if (dlist_empty(&queue->wild_list))
+		return entry;
+
+	wild_entry = smr_queue_find_match(queue, &queue->wild_list, attr);
+	if (!entry || (wild_entry && wild_entry->seq < entry->seq))
+		return wild_entry;
+	return entry;
 }
 
 void smr_format_pend_resp(struct smr_tx_entry *pend, struct smr_cmd *cmd,
@@ -372,6 +477,7 @@ static int smr_format_ze_ipc(struct smr_ep *ep, int64_t id, struct smr_cmd *cmd,
 		struct smr_region *smr, struct smr_resp *resp,
 		struct smr_tx_entry *pend)
 {
+	struct smr_cmap_entry *cmap;
 	int ret;
 	void *base;
 
@@ -380,9 +486,13 @@ static int smr_format_ze_ipc(struct smr_ep *ep, int64_t id, struct smr_cmd *cmd,
 	cmd->msg.hdr.size = total_len;
 	cmd->msg.data.ipc_info.iface = FI_HMEM_ZE;
 
-	if (ep->sock_info->peers[id].state == SMR_CMAP_INIT)
+	cmap = smr_sock_peer(ep->sock_info, id);
+	if (!cmap)
+		return -FI_ENOMEM;
+
+	if (cmap->state == SMR_CMAP_INIT)
 		smr_ep_exchange_fds(ep, id);
-	if (ep->sock_info->peers[id].state != SMR_CMAP_SUCCESS)
+	if (cmap->state != SMR_CMAP_SUCCESS)
 		return -FI_EAGAIN;
 
 	ret = ze_hmem_get_base_addr(iov[0].iov_base, &base, NULL);
@@ -570,6 +680,86 @@ size_t smr_copy_from_sar(struct smr_freestack *sar_pool, struct smr_resp *resp,
 	return *bytes_done - start;
 }
 
+size_t smr_copy_to_sar_ring(struct smr_freestack *sar_pool,
+			    struct smr_resp *resp, struct smr_cmd *cmd,
+			    struct ofi_mr **mr, const struct iovec *iov,
+			    size_t count, size_t *bytes_done)
+{
+	struct smr_sar_buf *sar_buf;
+	size_t start = *bytes_done;
+	uint32_t seg, limit;
+
+	limit = resp->sar_drained + cmd->msg.data.buf_batch_size;
+	ofi_rmb();
+
+	seg = *bytes_done / SMR_SAR_SIZE;
+	while (*bytes_done < cmd->msg.hdr.size && seg < limit) {
+		sar_buf = smr_freestack_get_entry_from_index(sar_pool,
+			cmd->msg.data.sar[seg % cmd->msg.data.buf_batch_size]);
+
+		*bytes_done += ofi_copy_from_mr_iov(
+				sar_buf->buf, SMR_SAR_SIZE, mr, iov, count,
+				*bytes_done);
+
+		/* publish each segment so the consumer can start on it */
+		ofi_wmb();
+		resp->sar_filled = ++seg;
+	}
+
+	return *bytes_done - start;
+}
+
+size_t smr_copy_from_sar_ring(struct smr_freestack *sar_pool,
+			      struct smr_resp *resp, struct smr_cmd *cmd,
+			      struct ofi_mr **mr, const struct iovec *iov,
+			      size_t count, size_t *bytes_done)
+{
+	struct smr_sar_buf *sar_buf;
+	size_t start = *bytes_done;
+	uint32_t seg, filled;
+
+	filled = resp->sar_filled;
+	ofi_rmb();
+
+	seg = *bytes_done / SMR_SAR_SIZE;
+	while (*bytes_done < cmd->msg.hdr.size && seg < filled) {
+		sar_buf = smr_freestack_get_entry_from_index(sar_pool,
+			cmd->msg.data.sar[seg % cmd->msg.data.buf_batch_size]);
+
+		*bytes_done += ofi_copy_to_mr_iov(mr, iov, count, *bytes_done,
+				sar_buf->buf, SMR_SAR_SIZE);
+
+		/* hand the buffer back to the producer */
+		ofi_wmb();
+		resp->sar_drained = ++seg;
+	}
+
+	if (*bytes_done == cmd->msg.hdr.size) {
+		ofi_wmb();
+		resp->status = SMR_STATUS_SAR_FREE;
+	}
+	return *bytes_done - start;
+}
+
+/*
+ * Number of SAR buffers to use for a pipelined transfer.  Messages that
+ * fit in this peer's share of the pool get one buffer per segment;
+ * larger ones cycle through a ring of up to SMR_BUF_BATCH_MAX buffers,
+ * which needs at least two so both sides can make progress at once.
+ */
+static uint32_t smr_sar_ring_size(struct smr_region *peer_smr,
+				  size_t total_len)
+{
+	uint32_t sar_needed, ring;
+
+	sar_needed = (total_len + SMR_SAR_SIZE - 1) / SMR_SAR_SIZE;
+	ring = MIN(SMR_BUF_BATCH_MAX, peer_smr->max_sar_buf_per_peer);
+	if (sar_needed <= ring)
+		return sar_needed;
+
+	return MAX(ring, 2);
+}
+
 static int smr_format_sar(struct smr_ep *ep, struct smr_cmd *cmd,
 		   struct ofi_mr **mr, const struct iovec *iov, size_t count,
 		   size_t total_len, struct smr_region *smr,
@@ -578,6 +768,7 @@ static int smr_format_sar(struct smr_ep *ep, struct smr_cmd *cmd,
 {
 	int i, ret;
 	uint32_t sar_needed;
+	bool pipeline = !(smr_env.use_dsa_sar && !mr);
 
 	if (peer_smr->max_sar_buf_per_peer == 0)
 		return -FI_EAGAIN;
@@ -590,9 +781,14 @@ static int smr_format_sar(struct smr_ep *ep, struct smr_cmd *cmd,
 	smr_peer_data(smr)[id].sar_status = SMR_STATUS_SAR_READY;
 	ofi_ep_lock_release(&ep->util_ep);
 
-	sar_needed = (total_len + SMR_SAR_SIZE - 1) / SMR_SAR_SIZE;
-	cmd->msg.data.buf_batch_size = MIN(SMR_BUF_BATCH_MAX,
+	if (pipeline) {
+		cmd->msg.data.buf_batch_size =
+			smr_sar_ring_size(peer_smr, total_len);
+	} else {
+		sar_needed = (total_len + SMR_SAR_SIZE - 1) / SMR_SAR_SIZE;
+		cmd->msg.data.buf_batch_size = MIN(SMR_BUF_BATCH_MAX,
 			MIN(peer_smr->max_sar_buf_per_peer, sar_needed));
+	}
 
 	pthread_spin_lock(&peer_smr->lock);
 	for (i = 0; i < cmd->msg.data.buf_batch_size; i++) {
@@ -600,6 +796,9 @@ static int smr_format_sar(struct smr_ep *ep, struct smr_cmd *cmd,
 			cmd->msg.data.buf_batch_size = i;
 			if (i == 0) {
 				pthread_spin_unlock(&peer_smr->lock);
+				ofi_ep_lock_acquire(&ep->util_ep);
+				smr_peer_data(smr)[id].sar_status = 0;
+				ofi_ep_lock_release(&ep->util_ep);
 				return -FI_EAGAIN;
 			}
 			break;
@@ -610,15 +809,27 @@ static int smr_format_sar(struct smr_ep *ep, struct smr_cmd *cmd,
 	}
 	pthread_spin_unlock(&peer_smr->lock);
 
-	resp->status = SMR_STATUS_SAR_FREE;
 	cmd->msg.hdr.op_src = smr_src_sar;
 	cmd->msg.hdr.src_data = smr_get_offset(smr, resp);
 	cmd->msg.hdr.size = total_len;
 	pending->bytes_done = 0;
 	pending->next = 0;
 
+	if (pipeline) {
+		cmd->msg.hdr.op_flags |= SMR_SAR_PIPELINE;
+		resp->sar_filled = 0;
+		resp->sar_drained = 0;
+		resp->status = SMR_STATUS_SAR_READY;
+	} else {
+		resp->status = SMR_STATUS_SAR_FREE;
+	}
+
 	if (cmd->msg.hdr.op != ofi_op_read_req) {
-		if (smr_env.use_dsa_sar && !mr) {
+		if (pipeline) {
+			smr_copy_to_sar_ring(smr_sar_pool(peer_smr), resp, cmd,
+					     mr, iov, count,
+					     &pending->bytes_done);
+		} else if (smr_env.use_dsa_sar && !mr) {
 			ret = smr_dsa_copy_to_sar(ep, smr_sar_pool(peer_smr),
 					resp, cmd, iov,	count,
 					&pending->bytes_done, pending);
@@ -850,6 +1061,47 @@ smr_proto_func smr_proto_ops[smr_src_max] = {
 	[smr_src_ipc] = &smr_do_ipc,
 };
 
+/*
+ * Chunks are only freed with the endpoint, so an entry can be used without
+ * the lock once its chunk has been published.
+ */
+struct smr_cmap_entry *smr_sock_peer(struct smr_sock_info *sock_info,
+				     int64_t id)
+{
+	struct smr_cmap_entry *chunk;
+	int64_t i = id >> SMR_PEER_CHUNK_SHIFT;
+
+	if (id < 0 || id >= SMR_MAX_PEERS)
+		return NULL;
+
+	chunk = sock_info->peers[i];
+	if (!chunk) {
+		pthread_mutex_lock(&sock_info->peers_lock);
+		chunk = sock_info->peers[i];
+		if (!chunk) {
+			chunk = calloc(SMR_PEER_CHUNK_SIZE, sizeof(*chunk));
+			if (chunk) {
+				ofi_wmb();
+				sock_info->peers[i] = chunk;
+			}
+		}
+		pthread_mutex_unlock(&sock_info->peers_lock);
+		if (!chunk)
+			return NULL;
+	}
+	return &chunk[id & (SMR_PEER_CHUNK_SIZE - 1)];
+}
+
+static void smr_free_sock_info(struct smr_sock_info *sock_info)
+{
+	int i;
+
+	for (i = 0; i < SMR_PEER_CHUNK_CNT; i++)
+		free(sock_info->peers[i]);
+	pthread_mutex_destroy(&sock_info->peers_lock);
+	free(sock_info);
+}
+
 static void smr_cleanup_epoll(struct smr_sock_info *sock_info)
 {
 	fd_signal_free(&sock_info->signal);
@@ -877,8 +1129,9 @@ static void smr_close_recv_queue(struct smr_srx_ctx *srx,
 	int ret;
 
 	while (!dlist_empty(&recv_queue->list)) {
-		dlist_pop_front(&recv_queue->list, struct smr_rx_entry,
-				rx_entry, peer_entry);
+		rx_entry = container_of(recv_queue->list.next,
+					struct smr_rx_entry, peer_entry);
+		smr_queue_remove(recv_queue, rx_entry);
 
 		memset(&err_entry, 0, sizeof err_entry);
 		err_entry.op_context = rx_entry->peer_entry.context;
@@ -908,19 +1161,23 @@ static int smr_srx_close(struct fid *fid)
 	smr_close_recv_queue(srx, &srx->trecv_queue);
 
 	while (!dlist_empty(&srx->unexp_msg_queue.list)) {
-		dlist_pop_front(&srx->unexp_msg_queue.list, struct smr_rx_entry,
-				rx_entry, peer_entry);
+		rx_entry = container_of(srx->unexp_msg_queue.list.next,
+					struct smr_rx_entry, peer_entry);
+		smr_queue_remove(&srx->unexp_msg_queue, rx_entry);
 		rx_entry->peer_entry.srx->peer_ops->discard_msg(
 							&rx_entry->peer_entry);
 	}
 
 	while (!dlist_empty(&srx->unexp_tagged_queue.list)) {
-		dlist_pop_front(&srx->unexp_tagged_queue.list,
-				struct smr_rx_entry, rx_entry, peer_entry);
+		rx_entry = container_of(srx->unexp_tagged_queue.list.next,
+					struct smr_rx_entry, peer_entry);
+		smr_queue_remove(&srx->unexp_tagged_queue, rx_entry);
 		rx_entry->peer_entry.srx->peer_ops->discard_tag(
 							&rx_entry->peer_entry);
 	}
 
+	smr_cleanup_queue(&srx->trecv_queue);
+	smr_cleanup_queue(&srx->unexp_tagged_queue);
 	ofi_atomic_dec32(&srx->cq->ref);
 	smr_recv_fs_free(srx->recv_fs);
 	ofi_spin_destroy(&srx->lock);
@@ -944,7 +1201,7 @@ static int smr_ep_close(struct fid *fid)
 		close(ep->sock_info->listen_sock);
 		unlink(ep->sock_info->name);
 		smr_cleanup_epoll(ep->sock_info);
-		free(ep->sock_info);
+		smr_free_sock_info(ep->sock_info);
 	}
 
 	ofi_endpoint_close(&ep->util_ep);
@@ -1106,7 +1363,9 @@ static void *smr_start_listener(void *args)
 {
 	struct smr_ep *ep = (struct smr_ep *) args;
 	struct sockaddr_un sockaddr;
-	struct ofi_epollfds_event events[SMR_MAX_PEERS + 1];
+	/* only the listening socket and the stop signal are polled */
+	struct ofi_epollfds_event events[2];
+	struct smr_cmap_entry *cmap;
 	int i, ret, poll_fds, sock = -1;
 	int peer_fds[ZE_MAX_DEVICES];
 	socklen_t len = sizeof(sockaddr);
@@ -1115,7 +1374,7 @@ static void *smr_start_listener(void *args)
 	ep->region->flags |= SMR_FLAG_IPC_SOCK;
 	while (1) {
 		poll_fds = ofi_epoll_wait(ep->sock_info->epollfd, events,
-					  SMR_MAX_PEERS + 1, -1);
+					  ARRAY_SIZE(events), -1);
 
 		if (poll_fds < 0) {
 			FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
@@ -1141,18 +1400,18 @@ static void *smr_start_listener(void *args)
 
 			ret = smr_recvmsg_fd(sock, &id, peer_fds,
 					     ep->sock_info->nfds);
-			if (!ret) {
-				memcpy(ep->sock_info->peers[id].device_fds,
-				       peer_fds, sizeof(*peer_fds) *
+			cmap = ret ? NULL : smr_sock_peer(ep->sock_info, id);
+			if (cmap) {
+				memcpy(cmap->device_fds, peer_fds,
+				       sizeof(*peer_fds) *
 				       ep->sock_info->nfds);
 
-				peer_id = smr_peer_data(ep->region)[id].addr.id;
+				peer_id = smr_peer_data(ep->region)[id].id;
 				ret = smr_sendmsg_fd(sock, id, peer_id,
 						ep->sock_info->my_fds,
 						ep->sock_info->nfds);
-				ep->sock_info->peers[id].state =
-					ret ? SMR_CMAP_FAILED :
-					SMR_CMAP_SUCCESS;
+				cmap->state = ret ? SMR_CMAP_FAILED :
+					      SMR_CMAP_SUCCESS;
 			}
 
 			close(sock);
@@ -1199,12 +1458,16 @@ err2:
 void smr_ep_exchange_fds(struct smr_ep *ep, int64_t id)
 {
 	struct smr_region *peer_smr = smr_peer_region(ep->region, id);
+	struct smr_cmap_entry *cmap = smr_sock_peer(ep->sock_info, id);
 	struct sockaddr_un server_sockaddr = {0}, client_sockaddr = {0};
 	char *name1, *name2;
 	int ret = -1, sock = -1;
 	int64_t peer_id;
 	int peer_fds[ZE_MAX_DEVICES];
 
+	/* callers look up the entry first, so its chunk exists */
+	assert(cmap);
+
 	if (peer_smr->pid == ep->region->pid ||
 	    !(peer_smr->flags & SMR_FLAG_IPC_SOCK))
 		goto out;
@@ -1229,7 +1492,7 @@ void smr_ep_exchange_fds(struct smr_ep *ep, int64_t id)
 	if (ret == -1) {
 		if (errno != EADDRINUSE) {
 			FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "bind error\n");
-			ep->sock_info->peers[id].state = SMR_CMAP_FAILED;
+			cmap->state = SMR_CMAP_FAILED;
 		}
 		close(sock);
 		return;
@@ -1247,25 +1510,25 @@ void smr_ep_exchange_fds(struct smr_ep *ep, int64_t id)
 	FI_DBG(&smr_prov, FI_LOG_EP_CTRL, "EP connected to UNIX socket %s\n",
 	       server_sockaddr.sun_path);
 
-	peer_id = smr_peer_data(ep->region)[id].addr.id;
+	peer_id = smr_peer_data(ep->region)[id].id;
 	ret = smr_sendmsg_fd(sock, id, peer_id, ep->sock_info->my_fds,
 			     ep->sock_info->nfds);
 	if (ret)
 		goto cleanup;
 
-	ret = smr_recvmsg_fd(sock, &id, peer_fds, ep->sock_info->nfds);
+	/* the listener echoes back our id for it */
+	ret = smr_recvmsg_fd(sock, &peer_id, peer_fds, ep->sock_info->nfds);
 	if (ret)
 		goto cleanup;
 
-	memcpy(ep->sock_info->peers[id].device_fds, peer_fds,
+	memcpy(cmap->device_fds, peer_fds,
 	       sizeof(*peer_fds) * ep->sock_info->nfds);
 
 cleanup:
 	close(sock);
 	unlink(client_sockaddr.sun_path);
 out:
-	ep->sock_info->peers[id].state = ret ?
-		SMR_CMAP_FAILED : SMR_CMAP_SUCCESS;
+	cmap->state = ret ? SMR_CMAP_FAILED : SMR_CMAP_SUCCESS;
 }
 
 static void smr_init_ipc_socket(struct smr_ep *ep)
@@ -1277,6 +1540,7 @@ static void smr_init_ipc_socket(struct smr_ep *ep)
 	ep->sock_info = calloc(1, sizeof(*ep->sock_info));
 	if (!ep->sock_info)
 		goto err_out;
+	pthread_mutex_init(&ep->sock_info->peers_lock, NULL);
 
 	ep->sock_info->listen_sock = socket(AF_UNIX, SOCK_STREAM, 0);
 	if (ep->sock_info->listen_sock < 0)
@@ -1336,7 +1600,7 @@ close:
 	close(ep->sock_info->listen_sock);
 	unlink(sockaddr.sun_path);
 free:
-	free(ep->sock_info);
+	smr_free_sock_info(ep->sock_info);
 	ep->sock_info = NULL;
 err_out:
 	FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "Unable to initialize IPC socket."
@@ -1365,7 +1629,6 @@ static int smr_get_msg(struct fid_peer_srx *srx, fi_addr_t addr,
 	struct smr_rx_entry *smr_entry;
 	struct smr_srx_ctx *srx_ctx;
 	struct smr_match_attr match_attr;
-	struct dlist_entry *dlist_entry;
 	struct smr_rx_entry *owner_entry;
 	int ret;
 
@@ -1374,10 +1637,8 @@ static int smr_get_msg(struct fid_peer_srx *srx, fi_addr_t addr,
 
 	match_attr.id = addr;
 
-	dlist_entry = dlist_find_first_match(&srx_ctx->recv_queue.list,
-					     srx_ctx->recv_queue.match_func,
-					     &match_attr);
-	if (!dlist_entry) {
+	owner_entry = smr_queue_find(&srx_ctx->recv_queue, &match_attr);
+	if (!owner_entry) {
 		smr_entry = smr_alloc_rx_entry(srx_ctx);
 		if (!smr_entry) {
 			ret = -FI_ENOMEM;
@@ -1392,10 +1653,9 @@ static int smr_get_msg(struct fid_peer_srx *srx, fi_addr_t addr,
 		goto out;
 	}
 
-	*rx_entry = (struct fi_peer_rx_entry *) dlist_entry;
+	*rx_entry = &owner_entry->peer_entry;
 
 	if ((*rx_entry)->flags & FI_MULTI_RECV) {
-		owner_entry = container_of(*rx_entry, struct smr_rx_entry, peer_entry);
 		smr_entry = smr_get_recv_entry(srx_ctx, owner_entry->iov, owner_entry->desc,
 					     owner_entry->peer_entry.count, addr,
 					     owner_entry->peer_entry.context,
@@ -1408,13 +1668,13 @@ static int smr_get_msg(struct fid_peer_srx *srx, fi_addr_t addr,
 		}
 
 		if (smr_adjust_multi_recv(srx_ctx, &owner_entry->peer_entry, size))
-			dlist_remove(dlist_entry);
+			smr_queue_remove(&srx_ctx->recv_queue, owner_entry);
 
 		smr_entry->peer_entry.owner_context = owner_entry;
 		*rx_entry = &smr_entry->peer_entry;
 		owner_entry->multi_recv_ref++;
 	} else {
-		dlist_remove(dlist_entry);
+		smr_queue_remove(&srx_ctx->recv_queue, owner_entry);
 	}
 
 	(*rx_entry)->srx = srx;
@@ -1430,7 +1690,6 @@ static int smr_get_tag(struct fid_peer_srx *srx, fi_addr_t addr,
 	struct smr_rx_entry *smr_entry;
 	struct smr_srx_ctx *srx_ctx;
 	struct smr_match_attr match_attr;
-	struct dlist_entry *dlist_entry;
 	int ret;
 
 	srx_ctx = srx->ep_fid.fid.context;
@@ -1438,11 +1697,10 @@ static int smr_get_tag(struct fid_peer_srx *srx, fi_addr_t addr,
 
 	match_attr.id = addr;
 	match_attr.tag = tag;
+	match_attr.ignore = 0;
 
-	dlist_entry = dlist_find_first_match(&srx_ctx->trecv_queue.list,
-					     srx_ctx->trecv_queue.match_func,
-					     &match_attr);
-	if (!dlist_entry) {
+	smr_entry = smr_queue_remove_first(&srx_ctx->trecv_queue, &match_attr);
+	if (!smr_entry) {
 		smr_entry = smr_alloc_rx_entry(srx_ctx);
 		if (!smr_entry) {
 			ret = -FI_ENOMEM;
@@ -1452,14 +1710,14 @@ static int smr_get_tag(struct fid_peer_srx *srx, fi_addr_t addr,
 			smr_entry->peer_entry.size = size;
 			smr_entry->peer_entry.tag = tag;
 			smr_entry->peer_entry.srx = srx;
+			smr_entry->ignore = 0;
 			*rx_entry = &smr_entry->peer_entry;
 			ret = -FI_ENOENT;
 		}
 		goto out;
 	}
-	dlist_remove(dlist_entry);
 
-	*rx_entry = (struct fi_peer_rx_entry *) dlist_entry;
+	*rx_entry = &smr_entry->peer_entry;
 	(*rx_entry)->srx = srx;
 	ret = FI_SUCCESS;
 out:
@@ -1472,8 +1730,9 @@ static int smr_queue_msg(struct fi_peer_rx_entry *rx_entry)
 	struct smr_srx_ctx *srx_ctx = rx_entry->srx->ep_fid.fid.context;
 
 	ofi_spin_lock(&srx_ctx->lock);
-	dlist_insert_tail((struct dlist_entry *) rx_entry,
-			  &srx_ctx->unexp_msg_queue.list);
+	smr_queue_insert(&srx_ctx->unexp_msg_queue,
+			 container_of(rx_entry, struct smr_rx_entry,
+				      peer_entry));
 	ofi_spin_unlock(&srx_ctx->lock);
 	return 0;
 }
@@ -1483,8 +1742,9 @@ static int smr_queue_tag(struct fi_peer_rx_entry *rx_entry)
 	struct smr_srx_ctx *srx_ctx = rx_entry->srx->ep_fid.fid.context;
 
 	ofi_spin_lock(&srx_ctx->lock);
-	dlist_insert_tail((struct dlist_entry *) rx_entry,
-			  &srx_ctx->unexp_tagged_queue.list);
+	smr_queue_insert(&srx_ctx->unexp_tagged_queue,
+			 container_of(rx_entry, struct smr_rx_entry,
+				      peer_entry));
 	ofi_spin_unlock(&srx_ctx->lock);
 	return 0;
 }
@@ -1574,10 +1834,15 @@ static int smr_ep_srx_context(struct smr_domain *domain, size_t rx_size,
 	if (ret)
 		goto err;
 
-	smr_init_queue(&srx->recv_queue, smr_match_msg);
-	smr_init_queue(&srx->trecv_queue, smr_match_tagged);
-	smr_init_queue(&srx->unexp_msg_queue, smr_match_msg);
-	smr_init_queue(&srx->unexp_tagged_queue, smr_match_tagged);
+	smr_init_queue(&srx->recv_queue, smr_match_msg, false);
+	smr_init_queue(&srx->unexp_msg_queue, smr_match_msg, false);
+	ret = smr_init_queue(&srx->trecv_queue, smr_match_tagged, true);
+	if (ret)
+		goto err_lock;
+	ret = smr_init_queue(&srx->unexp_tagged_queue, smr_match_unexp_tagged,
+			     true);
+	if (ret)
+		goto err_queue;
 
 	srx->recv_fs = smr_recv_fs_create(rx_size, NULL, NULL);
 
@@ -1598,6 +1863,10 @@ static int smr_ep_srx_context(struct smr_domain *domain, size_t rx_size,
 
 	return FI_SUCCESS;
 
+err_queue:
+	smr_cleanup_queue(&srx->trecv_queue);
+err_lock:
+	ofi_spin_destroy(&srx->lock);
 err:
 	free(srx);
 	return ret;
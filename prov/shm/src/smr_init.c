@@ -45,8 +45,29 @@ struct smr_env smr_env = {
 	.disable_cma = false,
 	.use_dsa_sar = false,
 	.max_gdrcopy_size = 3072,
+	.cma_chunk_size = SMR_CMA_CHUNK_DEF,
 };
 
+/*
+ * Size CMA pieces to a quarter of the per-core cache, so that the source
+ * and destination of the piece being copied stay in the private cache.
+ * The shared LLC is split between all ranks on the node.
+ */
+static size_t smr_cma_auto_chunk(void)
+{
+	long cache = -1;
+
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	cache = ofi_sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+	if (cache <= 0)
+		return SMR_CMA_CHUNK_DEF;
+
+	return ofi_get_aligned_size(MIN(MAX((size_t) cache / 4,
+					    SMR_CMA_CHUNK_MIN),
+					SMR_CMA_CHUNK_MAX), ofi_get_page_size());
+}
+
 static void smr_init_env(void)
 {
 	fi_param_get_size_t(&smr_prov, "sar_threshold", &smr_env.sar_threshold);
@@ -54,6 +75,9 @@ static void smr_init_env(void)
 	fi_param_get_size_t(&smr_prov, "rx_size", &smr_info.rx_attr->size);
 	fi_param_get_bool(&smr_prov, "disable_cma", &smr_env.disable_cma);
 	fi_param_get_bool(&smr_prov, "use_dsa_sar", &smr_env.use_dsa_sar);
+	if (fi_param_get_size_t(&smr_prov, "cma_chunk_size",
+				&smr_env.cma_chunk_size))
+		smr_env.cma_chunk_size = smr_cma_auto_chunk();
 }
 
 static void smr_resolve_addr(const char *node, const char *service,
@@ -216,6 +240,13 @@ SHM_INI
 			"Manually disables CMA. Default: false");
 	fi_param_define(&smr_prov, "use_dsa_sar", FI_PARAM_BOOL,
 			"Enable use of DSA in SAR protocol. Default: false");
+	fi_param_define(&smr_prov, "cma_chunk_size", FI_PARAM_SIZE_T,
+			"Size of the pieces that CMA transfers larger than \
+			 this are split into.  Pieces are copied one at a \
+			 time per transfer, interleaved with other progress. \
+			 0 copies each message in one call. \
+			 Default: a quarter of the L2 cache, within \
+			 64KiB-4MiB");
 	fi_param_define(&smr_prov, "enable_dsa_page_touch", FI_PARAM_BOOL,
 			"Enable CPU touching of memory pages in DSA command \
 			 descriptor when page fault is reported. \
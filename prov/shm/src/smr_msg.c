@@ -95,7 +95,6 @@ static ssize_t smr_generic_mrecv(struct smr_srx_ctx *srx,
 {
 	struct smr_match_attr match_attr;
 	struct smr_rx_entry *rx_entry, *mrecv_entry;
-	struct dlist_entry *dlist_entry;
 	bool buf_done = false;
 	int ret;
 
@@ -113,12 +112,8 @@ static ssize_t smr_generic_mrecv(struct smr_srx_ctx *srx,
 	}
 	mrecv_entry->peer_entry.size = ofi_total_iov_len(iov, iov_count);
 
-	dlist_entry = dlist_remove_first_match(&srx->unexp_msg_queue.list,
-					       srx->unexp_msg_queue.match_func,
-					       &match_attr);
-	while (dlist_entry) {
-		rx_entry = container_of(dlist_entry, struct smr_rx_entry,
-					peer_entry);
+	rx_entry = smr_queue_remove_first(&srx->unexp_msg_queue, &match_attr);
+	while (rx_entry) {
 		smr_init_rx_entry(rx_entry, mrecv_entry->peer_entry.iov, desc,
 				  iov_count, addr, context, 0,
 				  flags & (~FI_MULTI_RECV));
@@ -136,13 +131,11 @@ static ssize_t smr_generic_mrecv(struct smr_srx_ctx *srx,
 			return ret;
 
 		ofi_spin_lock(&srx->lock);
-		dlist_entry = dlist_remove_first_match(&srx->unexp_msg_queue.list,
-						       srx->unexp_msg_queue.match_func,
-						       &match_attr);
+		rx_entry = smr_queue_remove_first(&srx->unexp_msg_queue,
+						  &match_attr);
 	}
 
-	dlist_insert_tail((struct dlist_entry *) (&mrecv_entry->peer_entry),
-			  &srx->recv_queue.list);
+	smr_queue_insert(&srx->recv_queue, mrecv_entry);
 	ret = FI_SUCCESS;
 out:
 	ofi_spin_unlock(&srx->lock);
@@ -155,7 +148,6 @@ static ssize_t smr_generic_recv(struct smr_srx_ctx *srx,
 {
 	struct smr_match_attr match_attr;
 	struct smr_rx_entry *rx_entry;
-	struct dlist_entry *dlist_entry;
 	int ret = FI_SUCCESS;
 
 	if (flags & FI_MULTI_RECV)
@@ -168,24 +160,19 @@ static ssize_t smr_generic_recv(struct smr_srx_ctx *srx,
 	match_attr.id = addr;
 
 	ofi_spin_lock(&srx->lock);
-	dlist_entry = dlist_remove_first_match(&srx->unexp_msg_queue.list,
-					       srx->unexp_msg_queue.match_func,
-					       &match_attr);
-	if (!dlist_entry) {
+	rx_entry = smr_queue_remove_first(&srx->unexp_msg_queue, &match_attr);
+	if (!rx_entry) {
 		rx_entry = smr_get_recv_entry(srx, iov, desc, iov_count, addr,
 					      context, 0, 0, flags);
 		if (!rx_entry)
 			ret = -FI_ENOMEM;
 		else
-			dlist_insert_tail((struct dlist_entry *)
-					  (&rx_entry->peer_entry),
-					  &srx->recv_queue.list);
+			smr_queue_insert(&srx->recv_queue, rx_entry);
 		ofi_spin_unlock(&srx->lock);
 		return ret;
 	}
 	ofi_spin_unlock(&srx->lock);
 
-	rx_entry = container_of(dlist_entry, struct smr_rx_entry, peer_entry);
 	smr_init_rx_entry(rx_entry, iov, desc, iov_count, addr, context,
 			  0, flags);
 
@@ -292,7 +279,7 @@ static ssize_t smr_generic_sendmsg(struct smr_ep *ep, const struct iovec *iov,
 	if (id < 0)
 		return -FI_EAGAIN;
 
-	peer_id = smr_peer_data(ep->region)[id].addr.id;
+	peer_id = smr_peer_data(ep->region)[id].id;
 	peer_smr = smr_peer_region(ep->region, id);
 
 	if (smr_peer_data(ep->region)[id].sar_status)
@@ -413,7 +400,7 @@ static ssize_t smr_generic_inject(struct fid_ep *ep_fid, const void *buf,
 	if (id < 0)
 		return -FI_EAGAIN;
 
-	peer_id = smr_peer_data(ep->region)[id].addr.id;
+	peer_id = smr_peer_data(ep->region)[id].id;
 	peer_smr = smr_peer_region(ep->region, id);
 
 	if (smr_peer_data(ep->region)[id].sar_status)
@@ -513,7 +500,6 @@ static ssize_t smr_generic_trecv(struct smr_srx_ctx *srx,
 {
 	struct smr_match_attr match_attr;
 	struct smr_rx_entry *rx_entry;
-	struct dlist_entry *dlist_entry;
 	int ret = FI_SUCCESS;
 
 	assert(iov_count <= SMR_IOV_LIMIT);
@@ -524,24 +510,19 @@ static ssize_t smr_generic_trecv(struct smr_srx_ctx *srx,
 	match_attr.tag = tag;
 
 	ofi_spin_lock(&srx->lock);
-	dlist_entry = dlist_remove_first_match(&srx->unexp_tagged_queue.list,
-					srx->unexp_tagged_queue.match_func,
-					&match_attr);
-	if (!dlist_entry) {
+	rx_entry = smr_queue_remove_first(&srx->unexp_tagged_queue, &match_attr);
+	if (!rx_entry) {
 		rx_entry = smr_get_recv_entry(srx, iov, desc, iov_count, addr,
 					      context, tag, ignore, flags);
 		if (!rx_entry)
 			ret = -FI_ENOMEM;
 		else
-			dlist_insert_tail((struct dlist_entry *)
-					  (&rx_entry->peer_entry),
-					  &srx->trecv_queue.list);
+			smr_queue_insert(&srx->trecv_queue, rx_entry);
 		ofi_spin_unlock(&srx->lock);
 		return ret;
 	}
 	ofi_spin_unlock(&srx->lock);
 
-	rx_entry = container_of(dlist_entry, struct smr_rx_entry, peer_entry);
 	smr_init_rx_entry(rx_entry, iov, desc, iov_count, addr, context,
 			  tag, flags);
 
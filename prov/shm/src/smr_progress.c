@@ -49,7 +49,10 @@ smr_try_progress_to_sar(struct smr_ep *ep, struct smr_region *smr,
                         size_t *bytes_done, int *next, void *entry_ptr)
 {
 	if (*bytes_done < cmd->msg.hdr.size) {
-		if (smr_env.use_dsa_sar && !mr) {
+		if (cmd->msg.hdr.op_flags & SMR_SAR_PIPELINE) {
+			smr_copy_to_sar_ring(sar_pool, resp, cmd, mr, iov,
+					     iov_count, bytes_done);
+		} else if (smr_env.use_dsa_sar && !mr) {
 			(void) smr_dsa_copy_to_sar(ep, sar_pool, resp, cmd, iov,
 					    iov_count, bytes_done, entry_ptr);
 			return;
@@ -69,7 +72,10 @@ smr_try_progress_from_sar(struct smr_ep *ep, struct smr_region *smr,
                           size_t *bytes_done, int *next, void *entry_ptr)
 {
 	if (*bytes_done < cmd->msg.hdr.size) {
-		if (smr_env.use_dsa_sar && !mr) {
+		if (cmd->msg.hdr.op_flags & SMR_SAR_PIPELINE) {
+			smr_copy_from_sar_ring(sar_pool, resp, cmd, mr, iov,
+					       iov_count, bytes_done);
+		} else if (smr_env.use_dsa_sar && !mr) {
 			(void) smr_dsa_copy_from_sar(ep, sar_pool, resp, cmd, 
 					iov, iov_count, bytes_done, entry_ptr);
 			return;
@@ -335,6 +341,71 @@ out:
 	return -ret;
 }
 
+/*
+ * CMA transfers larger than cma_chunk_size are queued on the pending list
+ * and copied one piece per progress pass.  A single large message then no
+ * longer holds up the command queue, and large transfers from several
+ * peers advance together.  The peer is notified after the last piece.
+ */
+static inline bool smr_cma_pipelined(struct smr_cmd *cmd)
+{
+	return smr_env.cma_chunk_size &&
+	       cmd->msg.hdr.size > smr_env.cma_chunk_size;
+}
+
+static struct smr_pend_entry *smr_progress_cma(struct smr_cmd *cmd,
+			struct fi_peer_rx_entry *rx_entry, struct iovec *iov,
+			size_t iov_count, struct smr_ep *ep)
+{
+	struct smr_pend_entry *cma_entry;
+
+	ofi_ep_lock_acquire(&ep->util_ep);
+	cma_entry = ofi_freestack_pop(ep->pend_fs);
+	cma_entry->cmd = *cmd;
+	cma_entry->bytes_done = 0;
+	memcpy(cma_entry->iov, iov, sizeof(*iov) * iov_count);
+	cma_entry->iov_count = iov_count;
+	(void) ofi_truncate_iov(cma_entry->iov, &cma_entry->iov_count,
+				cmd->msg.hdr.size);
+	memset(cma_entry->mr, 0, sizeof(cma_entry->mr));
+	cma_entry->rx_entry = rx_entry;
+	cma_entry->in_use = false;
+	dlist_insert_tail(&cma_entry->entry, &ep->sar_list);
+	ofi_ep_lock_release(&ep->util_ep);
+
+	smr_signal(ep->region);
+	return cma_entry;
+}
+
+static int smr_progress_cma_chunk(struct smr_region *peer_smr,
+				  struct smr_pend_entry *cma_entry)
+{
+	struct smr_cmd *cmd = &cma_entry->cmd;
+	struct iovec local[SMR_IOV_LIMIT];
+	struct iovec remote[ARRAY_SIZE(cmd->msg.data.iov)];
+	size_t local_cnt = cma_entry->iov_count;
+	size_t remote_cnt = cmd->msg.data.iov_count;
+	size_t len;
+	int ret;
+
+	memcpy(local, cma_entry->iov, sizeof(*local) * local_cnt);
+	memcpy(remote, cmd->msg.data.iov, sizeof(*remote) * remote_cnt);
+	ofi_consume_iov(local, &local_cnt, cma_entry->bytes_done);
+	ofi_consume_iov(remote, &remote_cnt, cma_entry->bytes_done);
+
+	len = MIN(smr_env.cma_chunk_size,
+		  cmd->msg.hdr.size - cma_entry->bytes_done);
+	(void) ofi_truncate_iov(local, &local_cnt, len);
+	(void) ofi_truncate_iov(remote, &remote_cnt, len);
+
+	ret = smr_cma_loop(peer_smr->pid, local, local_cnt, remote,
+			   remote_cnt, 0, len,
+			   cmd->msg.hdr.op == ofi_op_read_req);
+	if (!ret)
+		cma_entry->bytes_done += len;
+	return ret;
+}
+
 static int smr_mmap_peer_copy(struct smr_ep *ep, struct smr_cmd *cmd,
 			      struct ofi_mr **mr, struct iovec *iov,
 			      size_t iov_count, size_t *total_len)
@@ -346,8 +417,8 @@ static int smr_mmap_peer_copy(struct smr_ep *ep, struct smr_cmd *cmd,
 	ssize_t hmem_copy_ret;
 
 	num = smr_mmap_name(shm_name,
-			ep->region->map->peers[cmd->msg.hdr.id].peer.name,
-			cmd->msg.hdr.msg_id);
+		smr_map_peer(ep->region->map, cmd->msg.hdr.id)->peer.name,
+		cmd->msg.hdr.msg_id);
 	if (num < 0) {
 		FI_WARN(&smr_prov, FI_LOG_AV, "generating shm file name failed\n");
 		return -errno;
@@ -551,6 +622,7 @@ static struct smr_pend_entry *smr_progress_ipc(struct smr_cmd *cmd,
 	struct ofi_mr_entry *mr_entry;
 	struct smr_domain *domain;
 	struct smr_pend_entry *ipc_entry;
+	struct smr_cmap_entry *cmap;
 
 	domain = container_of(ep->util_ep.domain, struct smr_domain,
 			      util_domain);
@@ -562,7 +634,12 @@ static struct smr_pend_entry *smr_progress_ipc(struct smr_cmd *cmd,
 	if (cmd->msg.data.ipc_info.iface == FI_HMEM_ZE) {
 		id = cmd->msg.hdr.id;
 		ipc_device = cmd->msg.data.ipc_info.device;
-		fd = ep->sock_info->peers[id].device_fds[ipc_device];
+		cmap = smr_sock_peer(ep->sock_info, id);
+		if (!cmap) {
+			ret = -FI_ENOMEM;
+			goto out;
+		}
+		fd = cmap->device_fds[ipc_device];
 		ret = ze_hmem_open_shared_handle(fd,
 				(void **) &cmd->msg.data.ipc_info.ipc_handle,
 				&ipc_fd, ipc_device, &base);
@@ -724,7 +801,7 @@ out:
 }
 
 static int smr_start_common(struct smr_ep *ep, struct smr_cmd *cmd,
-		struct fi_peer_rx_entry *rx_entry)
+		struct fi_peer_rx_entry *rx_entry, struct ofi_cq_batch *batch)
 {
 	struct smr_pend_entry *pend = NULL;
 	size_t total_len = 0;
@@ -746,6 +823,11 @@ static int smr_start_common(struct smr_ep *ep, struct smr_cmd *cmd,
 				ep, 0);
 		break;
 	case smr_src_iov:
+		if (smr_cma_pipelined(cmd)) {
+			pend = smr_progress_cma(cmd, rx_entry, rx_entry->iov,
+						rx_entry->count, ep);
+			break;
+		}
 		err = smr_progress_iov(cmd, rx_entry->iov, rx_entry->count,
 				       &total_len, ep, 0);
 		break;
@@ -779,13 +861,16 @@ static int smr_start_common(struct smr_ep *ep, struct smr_cmd *cmd,
 		if (err) {
 			FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
 				"error processing op\n");
+			if (batch)
+				(void) ofi_cq_batch_flush(batch);
 			ret = smr_write_err_comp(ep->util_ep.rx_cq,
 						 rx_entry->context,
 						 comp_flags, rx_entry->tag,
 						 err);
 		} else {
-			ret = smr_complete_rx(ep, rx_entry->context, cmd->msg.hdr.op,
-					      comp_flags, total_len, comp_buf,
+			ret = smr_complete_rx(ep, batch, rx_entry->context,
+					      cmd->msg.hdr.op, comp_flags,
+					      total_len, comp_buf,
 					      cmd->msg.hdr.id, cmd->msg.hdr.tag,
 					      cmd->msg.hdr.data);
 		}
@@ -804,7 +889,7 @@ int smr_unexp_start(struct fi_peer_rx_entry *rx_entry)
 	struct smr_cmd_ctx *cmd_ctx = rx_entry->peer_context;
 	int ret;
 
-	ret = smr_start_common(cmd_ctx->ep, &cmd_ctx->cmd, rx_entry);
+	ret = smr_start_common(cmd_ctx->ep, &cmd_ctx->cmd, rx_entry, NULL);
 	ofi_buf_free(cmd_ctx);
 
 	return ret;
@@ -836,13 +921,12 @@ static void smr_progress_connreq(struct smr_ep *ep, struct smr_cmd *cmd)
 		smr_map_to_region(&smr_prov, ep->region->map, idx);
 		peer_smr = smr_peer_region(ep->region, idx);
 	}
-	smr_peer_data(peer_smr)[cmd->msg.hdr.id].addr.id = idx;
-	smr_peer_data(ep->region)[idx].addr.id = cmd->msg.hdr.id;
+	smr_peer_data(peer_smr)[cmd->msg.hdr.id].id = idx;
+	smr_peer_data(ep->region)[idx].id = cmd->msg.hdr.id;
 
 	smr_release_txbuf(ep->region, tx_buf);
 	assert(ep->region->map->num_peers > 0);
-	ep->region->max_sar_buf_per_peer = SMR_MAX_PEERS /
-		ep->region->map->num_peers;
+	smr_update_sar_per_peer(ep->region);
 }
 
 static int smr_alloc_cmd_ctx(struct smr_ep *ep,
@@ -864,14 +948,15 @@ static int smr_alloc_cmd_ctx(struct smr_ep *ep,
 	return FI_SUCCESS;
 }
 
-static int smr_progress_cmd_msg(struct smr_ep *ep, struct smr_cmd *cmd)
+static int smr_progress_cmd_msg(struct smr_ep *ep, struct smr_cmd *cmd,
+				struct ofi_cq_batch *batch)
 {
 	struct fid_peer_srx *peer_srx = smr_get_peer_srx(ep);
 	struct fi_peer_rx_entry *rx_entry;
 	fi_addr_t addr;
 	int ret;
 
-	addr = ep->region->map->peers[cmd->msg.hdr.id].fiaddr;
+	addr = smr_map_peer(ep->region->map, cmd->msg.hdr.id)->fiaddr;
 	if (cmd->msg.hdr.op == ofi_op_tagged) {
 		ret = peer_srx->owner_ops->get_tag(peer_srx, addr,
 				cmd->msg.hdr.size, cmd->msg.hdr.tag, &rx_entry);
@@ -901,7 +986,7 @@ static int smr_progress_cmd_msg(struct smr_ep *ep, struct smr_cmd *cmd)
 		FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "Error getting rx_entry\n");
 		return ret;
 	}
-	ret = smr_start_common(ep, cmd, rx_entry);
+	ret = smr_start_common(ep, cmd, rx_entry, batch);
 
 out:
 	return ret < 0 ? ret : 0;
@@ -956,6 +1041,10 @@ static int smr_progress_cmd_rma(struct smr_ep *ep, struct smr_cmd *cmd,
 		}
 		break;
 	case smr_src_iov:
+		if (smr_cma_pipelined(cmd)) {
+			(void) smr_progress_cma(cmd, NULL, iov, iov_count, ep);
+			return ret;
+		}
 		err = smr_progress_iov(cmd, iov, iov_count, &total_len, ep, ret);
 		break;
 	case smr_src_mmap:
@@ -985,7 +1074,7 @@ static int smr_progress_cmd_rma(struct smr_ep *ep, struct smr_cmd *cmd,
 					 smr_rx_cq_flags(cmd->msg.hdr.op, 0,
 					 cmd->msg.hdr.op_flags), 0, err);
 	} else {
-		ret = smr_complete_rx(ep, (void *) cmd->msg.hdr.msg_id,
+		ret = smr_complete_rx(ep, NULL, (void *) cmd->msg.hdr.msg_id,
 			      cmd->msg.hdr.op, smr_rx_cq_flags(cmd->msg.hdr.op,
 			      0, cmd->msg.hdr.op_flags), total_len,
 			      iov_count ? iov[0].iov_base : NULL,
@@ -1057,7 +1146,7 @@ static int smr_progress_cmd_atomic(struct smr_ep *ep, struct smr_cmd *cmd,
 					 smr_rx_cq_flags(cmd->msg.hdr.op, 0,
 					 cmd->msg.hdr.op_flags), 0, err);
 	} else {
-		ret = smr_complete_rx(ep, NULL, cmd->msg.hdr.op,
+		ret = smr_complete_rx(ep, NULL, NULL, cmd->msg.hdr.op,
 				      smr_rx_cq_flags(cmd->msg.hdr.op, 0,
 				      cmd->msg.hdr.op_flags), total_len,
 				      ioc_count ? ioc[0].addr : NULL,
@@ -1076,9 +1165,15 @@ out:
 static void smr_progress_cmd(struct smr_ep *ep)
 {
 	struct smr_cmd_entry *ce;
+	struct ofi_cq_batch batch;
 	int ret = 0;
 	int64_t pos;
 
+	/* Message completions are staged in a batch, which is written to
+	 * the CQ before any other command can generate a completion.
+	 */
+	ofi_cq_batch_init(&batch);
+
 	/* ep->util_ep.lock is used to serialize the message/tag matching.
 	 * We keep the lock until the matching is complete. This will
 	 * ensure that commands are matched in the order they are
@@ -1098,10 +1193,14 @@ static void smr_progress_cmd(struct smr_ep *ep)
 			ofi_ep_lock_release(&ep->util_ep);
 			break;
 		}
+		if (ce->cmd.msg.hdr.op != ofi_op_msg &&
+		    ce->cmd.msg.hdr.op != ofi_op_tagged)
+			(void) ofi_cq_batch_flush(&batch);
+
 		switch (ce->cmd.msg.hdr.op) {
 		case ofi_op_msg:
 		case ofi_op_tagged:
-			ret = smr_progress_cmd_msg(ep, &ce->cmd);
+			ret = smr_progress_cmd_msg(ep, &ce->cmd, &batch);
 			break;
 		case ofi_op_write:
 		case ofi_op_read_req:
@@ -1142,6 +1241,7 @@ static void smr_progress_cmd(struct smr_ep *ep)
 			break;
 		}
 	}
+	(void) ofi_cq_batch_flush(&batch);
 }
 
 static void smr_progress_ipc_list(struct smr_ep *ep)
@@ -1187,7 +1287,8 @@ static void smr_progress_ipc_list(struct smr_ep *ep)
 					0, ipc_entry->cmd.msg.hdr.op_flags);
 		}
 
-		ret = smr_complete_rx(ep, context, ipc_entry->cmd.msg.hdr.op,
+		ret = smr_complete_rx(ep, NULL, context,
+				ipc_entry->cmd.msg.hdr.op,
 				flags, ipc_entry->bytes_done,
 				ipc_entry->iov[0].iov_base,
 				ipc_entry->cmd.msg.hdr.id,
@@ -1238,7 +1339,19 @@ static void smr_progress_sar_list(struct smr_ep *ep)
 		ofi_ep_lock_release(&ep->util_ep);
 		peer_smr = smr_peer_region(ep->region, sar_entry->cmd.msg.hdr.id);
 		resp = smr_get_ptr(peer_smr, sar_entry->cmd.msg.hdr.src_data);
-		if (sar_entry->cmd.msg.hdr.op == ofi_op_read_req)
+		ret = 0;
+		if (sar_entry->cmd.msg.hdr.op_src == smr_src_iov) {
+			ret = smr_progress_cma_chunk(peer_smr, sar_entry);
+			if (ret || sar_entry->bytes_done ==
+				   sar_entry->cmd.msg.hdr.size) {
+				//Status must be set last (signals peer: op done)
+				resp->status = ret;
+				smr_signal(peer_smr);
+			} else {
+				/* come back for the next piece */
+				smr_signal(ep->region);
+			}
+		} else if (sar_entry->cmd.msg.hdr.op == ofi_op_read_req)
 			smr_try_progress_to_sar(ep, peer_smr, smr_sar_pool(ep->region),
 					resp, &sar_entry->cmd, sar_entry->mr,
 					sar_entry->iov, sar_entry->iov_count,
@@ -1251,7 +1364,7 @@ static void smr_progress_sar_list(struct smr_ep *ep)
 					&sar_entry->bytes_done,
 					&sar_entry->next, sar_entry);
 
-		if (sar_entry->bytes_done == sar_entry->cmd.msg.hdr.size) {
+		if (ret || sar_entry->bytes_done == sar_entry->cmd.msg.hdr.size) {
 			if (sar_entry->rx_entry) {
 				comp_ctx = sar_entry->rx_entry->context;
 				comp_flags = smr_rx_cq_flags(sar_entry->cmd.msg.hdr.op,
@@ -1262,13 +1375,21 @@ static void smr_progress_sar_list(struct smr_ep *ep)
 				comp_flags = smr_rx_cq_flags(sar_entry->cmd.msg.hdr.op,
 						0, sar_entry->cmd.msg.hdr.op_flags);
 			}
-			ret = smr_complete_rx(ep, comp_ctx,
+			if (ret) {
+				FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+					"error processing op\n");
+				ret = smr_write_err_comp(ep->util_ep.rx_cq,
+						comp_ctx, comp_flags,
+						sar_entry->cmd.msg.hdr.tag, -ret);
+			} else {
+				ret = smr_complete_rx(ep, NULL, comp_ctx,
 					sar_entry->cmd.msg.hdr.op, comp_flags,
 					sar_entry->bytes_done,
 					sar_entry->iov[0].iov_base,
 					sar_entry->cmd.msg.hdr.id,
 					sar_entry->cmd.msg.hdr.tag,
 					sar_entry->cmd.msg.hdr.data);
+			}
 			if (ret) {
 				FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
 					"unable to process rx completion\n");
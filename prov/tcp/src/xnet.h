@@ -83,6 +83,7 @@ extern struct fi_info		xnet_srx_info;
 extern struct xnet_port_range	xnet_ports;
 
 extern int xnet_nodelay;
+extern int xnet_busy_poll;
 extern int xnet_staging_sbuf_size;
 extern int xnet_prefetch_rbuf_size;
 extern size_t xnet_default_tx_size;
@@ -90,7 +91,10 @@ extern size_t xnet_default_rx_size;
 extern size_t xnet_zerocopy_size;
 extern int xnet_trace_msg;
 extern int xnet_disable_autoprog;
+extern int xnet_progress_threads;
 extern int xnet_io_uring;
+extern int xnet_io_uring_multishot;
+extern int xnet_io_uring_fixed;
 extern int xnet_max_saved;
 extern size_t xnet_max_saved_size;
 extern size_t xnet_max_inject;
@@ -165,11 +169,14 @@ struct xnet_active_rx {
 	struct xnet_xfer_entry	*entry;
 	int			(*handler)(struct xnet_ep *ep);
 	void			*claim_ctx;
+	/* last header was a plain message, see xnet_recv_predicted() */
+	bool			predict;
 };
 
 struct xnet_active_tx {
 	size_t			data_left;
 	struct xnet_xfer_entry	*entry;
+	int			zc_res;
 };
 
 struct xnet_saved_msg {
@@ -178,6 +185,25 @@ struct xnet_saved_msg {
 	int			cnt;
 };
 
+/* Tagged receives posted without ignore bits and saved messages are
+ * indexed by tag.  Entries within a bucket are kept in posting/arrival
+ * order.  Receives with ignore bits remain on the tag_queue and
+ * src_tag_queues lists, and tag_seq_no is used to select the oldest
+ * match across the hash and those lists.
+ */
+#define XNET_TAG_HASH_SIZE	256
+
+struct xnet_tag_hash {
+	struct dlist_entry	bucket[XNET_TAG_HASH_SIZE];
+};
+
+static inline struct dlist_entry *
+xnet_tag_bucket(struct xnet_tag_hash *hash, uint64_t tag)
+{
+	tag *= 0x9E3779B97F4A7C15ULL;
+	return &hash->bucket[(tag >> 32) & (XNET_TAG_HASH_SIZE - 1)];
+}
+
 struct xnet_srx {
 	struct fid_ep		rx_fid;
 	struct xnet_domain	*domain;
@@ -185,6 +211,8 @@ struct xnet_srx {
 	struct slist		tag_queue;
 	struct ofi_dyn_arr	src_tag_queues;
 	struct ofi_dyn_arr	saved_msgs;
+	struct xnet_tag_hash	tag_hash;
+	struct xnet_tag_hash	saved_hash;
 
 	struct xnet_xfer_entry	*(*match_tag_rx)(struct xnet_srx *srx,
 						 struct xnet_ep *ep,
@@ -221,6 +249,8 @@ struct xnet_ep {
 	struct xnet_saved_msg	*saved_msg;
 	int			rx_avail;
 	struct xnet_srx		*srx;
+	/* The domain progress engine, or one of the domain's shards */
+	struct xnet_progress	*progress;
 
 	enum xnet_state		state;
 	struct util_peer_addr	*peer;
@@ -231,6 +261,12 @@ struct xnet_ep {
 	void (*hdr_bswap)(struct xnet_ep *ep, struct xnet_base_hdr *hdr);
 
 	short			pollflags;
+
+	/* io_uring multishot receive buffers not yet copied to bsock.rq */
+	struct slist		mshot_bufs;
+	int			mshot_cnt;
+	struct dlist_entry	mshot_entry;
+	struct ofi_sockctx	mshot_cancel_sockctx;
 };
 
 struct xnet_event {
@@ -272,10 +308,35 @@ ssize_t xnet_get_conn(struct xnet_rdm *rdm, fi_addr_t dest_addr,
 struct xnet_ep *xnet_get_rx_ep(struct xnet_rdm *rdm, fi_addr_t addr);
 void xnet_freeall_conns(struct xnet_rdm *rdm);
 
+/* Multishot receives select buffers from a ring shared by all sockets
+ * on the rx_uring.  A buffer is held by the endpoint until its data has
+ * been copied into the endpoint's prefetch buffer.  An endpoint that holds
+ * XNET_URING_MSHOT_MAX buffers has its multishot receive canceled, so that
+ * a single blocked endpoint cannot drain the ring.  Endpoints waiting for
+ * the ring to be refilled are kept on mshot_wait_list.
+ */
+#define XNET_URING_BUF_CNT	512
+#define XNET_URING_BUF_SIZE	4096
+#define XNET_URING_MSHOT_MAX	(XNET_URING_BUF_CNT / 8)
+
+/* Size of the fixed file and buffer tables, indexed by socket */
+#define XNET_URING_FIXED_CNT	4096
+
+struct xnet_uring_buf {
+	struct slist_entry entry;
+	uint32_t len;
+	uint32_t offset;
+};
+
 struct xnet_uring {
 	struct fid fid;
 	ofi_io_uring_t ring;
 	struct ofi_sockapi_uring *sockapi;
+
+	struct ofi_uring_buf_ring buf_ring;
+	struct xnet_uring_buf *bufs;
+	unsigned int bufs_held;
+	struct dlist_entry mshot_wait_list;
 };
 
 /* Serialization is handled at the progress instance level, using the
@@ -331,6 +392,17 @@ struct xnet_progress {
 	struct ofi_dynpoll	epoll_fd;
 	struct ofi_epollfds_event events[XNET_MAX_EVENTS];
 
+	/* Set while xnet_run_progress executes */
+	struct ofi_cq_batch	*cq_batch;
+
+	/* Busy polling: average time between events and the last event,
+	 * updated outside the progress lock, only steers spinning.
+	 */
+	uint64_t		busy_poll_gap;
+	uint64_t		busy_poll_last;
+
+	/* Additional engine of a domain, see xnet_domain */
+	bool			shard;
 	bool			auto_progress;
 	pthread_t		thread;
 };
@@ -361,6 +433,10 @@ int xnet_uring_cancel(struct xnet_progress *progress,
 int xnet_uring_pollin_add(struct xnet_progress *progress,
 			  int fd, bool multishot,
 			  struct ofi_sockctx *pollin_ctx);
+int xnet_uring_pollin_ep(struct xnet_ep *ep);
+void xnet_uring_register_ep(struct xnet_ep *ep);
+void xnet_uring_unregister_ep(struct xnet_ep *ep);
+void xnet_uring_mshot_release(struct xnet_ep *ep);
 
 static inline int xnet_progress_locked(struct xnet_progress *progress)
 {
@@ -394,6 +470,7 @@ static inline void xnet_signal_progress(struct xnet_progress *progress)
 
 struct xnet_xfer_entry {
 	struct slist_entry	entry;
+	struct dlist_entry	match_entry;
 	void			*user_buf;
 	size_t			iov_cnt;
 	struct iovec		iov[XNET_IOV_LIMIT+1];
@@ -420,17 +497,25 @@ struct xnet_xfer_entry {
 	char			msg_data[];
 };
 
+/* Msg endpoints that do not share state with other endpoints may be
+ * assigned to one of several progress shards, each driven by its own
+ * thread.  A shard only touches the endpoints assigned to it, so it is
+ * serialized by its own lock and never takes the domain progress lock.
+ */
 struct xnet_domain {
 	struct util_domain		util_domain;
 	struct xnet_progress		progress;
+
+	struct xnet_progress		*shards;
+	int				shard_cnt;
+	ofi_atomic32_t			next_shard;
 };
 
+struct xnet_progress *xnet_domain_next_progress(struct xnet_domain *domain);
+
 static inline struct xnet_progress *xnet_ep2_progress(struct xnet_ep *ep)
 {
-	struct xnet_domain *domain;
-	domain = container_of(ep->util_ep.domain, struct xnet_domain,
-			      util_domain);
-	return &domain->progress;
+	return ep->progress;
 }
 
 static inline struct xnet_progress *xnet_rdm2_progress(struct xnet_rdm *rdm)
@@ -601,10 +686,18 @@ xnet_alloc_xfer(struct xnet_progress *progress)
 	return xfer;
 }
 
+/* Transfers are owned by the progress engine that allocated them */
+static inline struct xnet_progress *
+xnet_xfer2_progress(struct xnet_xfer_entry *xfer)
+{
+	return ofi_buf_pool(xfer)->attr.context;
+}
+
 static inline void
 xnet_free_xfer(struct xnet_progress *progress, struct xnet_xfer_entry *xfer)
 {
 	assert(xnet_progress_locked(progress));
+	assert(xnet_xfer2_progress(xfer) == progress);
 
 	if (xfer->ctrl_flags & XNET_FREE_BUF)
 		free(xfer->user_buf);
@@ -126,6 +126,7 @@ static void xnet_get_cq_info(struct xnet_xfer_entry *entry, uint64_t *flags,
 
 void xnet_report_success(struct xnet_xfer_entry *xfer_entry)
 {
+	struct xnet_progress *progress;
 	struct util_cq *cq;
 	uint64_t flags, data, tag;
 	size_t len;
@@ -165,6 +166,17 @@ void xnet_report_success(struct xnet_xfer_entry *xfer_entry)
 		tag = 0;
 	}
 
+	progress = xnet_xfer2_progress(xfer_entry);
+	assert(xnet_progress_locked(progress));
+	if (progress->cq_batch) {
+		(void) ofi_cq_batch_write(progress->cq_batch, cq,
+					  xfer_entry->context, flags, len,
+					  xfer_entry->user_buf, data, tag,
+					  cq->src ? xfer_entry->src_addr :
+						    FI_ADDR_NOTAVAIL);
+		return;
+	}
+
 	if (cq->src) {
 		ofi_cq_write_src(cq, xfer_entry->context, flags, len,
 				 xfer_entry->user_buf, data, tag,
@@ -180,6 +192,7 @@ void xnet_report_success(struct xnet_xfer_entry *xfer_entry)
 void xnet_report_error(struct xnet_xfer_entry *xfer_entry, int err)
 {
 	struct fi_cq_err_entry err_entry;
+	struct xnet_progress *progress;
 
 	if (xfer_entry->ctrl_flags &
 	    (XNET_INTERNAL_XFER | XNET_SAVED_XFER | XNET_INJECT_OP)) {
@@ -216,6 +229,11 @@ void xnet_report_error(struct xnet_xfer_entry *xfer_entry, int err)
 	err_entry.err_data = NULL;
 	err_entry.err_data_size = 0;
 
+	/* Keep the error ordered after batched completions */
+	progress = xnet_xfer2_progress(xfer_entry);
+	if (progress->cq_batch)
+		(void) ofi_cq_batch_flush(progress->cq_batch);
+
 	ofi_cq_write_error(&xfer_entry->cq->util_cq, &err_entry);
 }
 
@@ -255,9 +273,37 @@ static int xnet_cq_wait_try_func(void *arg)
 	return FI_SUCCESS;
 }
 
+/* Progress shards write completions from their own threads, independent
+ * from the threading model requested by the app.  They stage completions
+ * in the lock-free ring, and the CQ needs a real lock for draining it.
+ */
+static int xnet_cq_init_shards(struct util_cq *cq)
+{
+	int ret;
+
+	if (cq->flags & FI_PEER)
+		return 0;
+
+	if (cq->cq_lock.lock_type == OFI_LOCK_NOOP ||
+	    cq->cq_lock.lock_type == OFI_LOCK_NONE) {
+		ofi_genlock_destroy(&cq->cq_lock);
+		ret = ofi_genlock_init(&cq->cq_lock, OFI_LOCK_MUTEX);
+		if (ret)
+			return ret;
+	}
+
+	if (!cq->mpscq) {
+		cq->mpscq = util_cq_mpscq_create(cq->cirq->size);
+		if (!cq->mpscq)
+			return -FI_ENOMEM;
+	}
+	return 0;
+}
+
 int xnet_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 		 struct fid_cq **cq_fid, void *context)
 {
+	struct xnet_domain *xnet_domain;
 	struct xnet_cq *cq;
 	struct fi_cq_attr cq_attr;
 	int ret;
@@ -280,6 +326,14 @@ int xnet_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 	if (ret)
 		goto free_cq;
 
+	xnet_domain = container_of(domain, struct xnet_domain,
+				   util_domain.domain_fid);
+	if (xnet_domain->shard_cnt) {
+		ret = xnet_cq_init_shards(&cq->util_cq);
+		if (ret)
+			goto cleanup;
+	}
+
 	if (cq->util_cq.wait && ofi_have_epoll) {
 		ret = ofi_wait_add_fd(cq->util_cq.wait,
 			       ofi_dynpoll_get_fd(&xnet_cq2_progress(cq)->epoll_fd),
@@ -406,9 +460,11 @@ xnet_cntr_wait(struct fid_cntr *cntr_fid, uint64_t threshold, int timeout)
 }
 
 /* We use these calls if the app uses a single thread around any access
- * to the counter (e.g. FI_THREAD_DOMAIN).  There should be no other
- * threads updating the counter or waiting for a value in parallel with
- * these calls.
+ * to the counter (e.g. FI_THREAD_DOMAIN) and the domain has no shards.
+ * There should be no other threads updating the counter or waiting for
+ * a value in parallel with these calls.  Shard progress threads update
+ * counters asynchronously, so sharded domains use the util calls, which
+ * signal the wait object.
  */
 static struct fi_ops_cntr xnet_cntr_ops = {
 	.size = sizeof(struct fi_ops_cntr),
@@ -445,7 +501,7 @@ int xnet_cntr_open(struct fid_domain *fid_domain, struct fi_cntr_attr *attr,
 			      util_domain.domain_fid);
 	if (attr->wait_obj == FI_WAIT_UNSPEC) {
 		cntr_attr = *attr;
-		if (domain->progress.auto_progress ||
+		if (domain->progress.auto_progress || domain->shard_cnt ||
 		    domain->util_domain.threading != FI_THREAD_DOMAIN) {
 			cntr_attr.wait_obj = FI_WAIT_FD;
 		} else {
@@ -461,7 +517,8 @@ int xnet_cntr_open(struct fid_domain *fid_domain, struct fi_cntr_attr *attr,
 		goto free;
 
 	if (attr->wait_obj == FI_WAIT_NONE) {
-		cntr->cntr_fid.ops = &xnet_cntr_ops;
+		if (!domain->shard_cnt)
+			cntr->cntr_fid.ops = &xnet_cntr_ops;
 	} else {
 		progress = xnet_cntr2_progress(cntr);
 		if (attr->wait_obj == FI_WAIT_FD && ofi_have_epoll) {
@@ -36,6 +36,27 @@
 #include "ofi_atomic.h"
 #include "xnet.h"
 
+/* RMA requests are verified against the MR map by the progress engine
+ * of the target endpoint, so updates to the map exclude all of them.
+ */
+static void xnet_lock_mr_map(struct xnet_domain *domain)
+{
+	int i;
+
+	ofi_genlock_lock(&domain->progress.lock);
+	for (i = 0; i < domain->shard_cnt; i++)
+		ofi_genlock_lock(&domain->shards[i].lock);
+}
+
+static void xnet_unlock_mr_map(struct xnet_domain *domain)
+{
+	int i;
+
+	for (i = domain->shard_cnt - 1; i >= 0; i--)
+		ofi_genlock_unlock(&domain->shards[i].lock);
+	ofi_genlock_unlock(&domain->progress.lock);
+}
+
 static int xnet_mr_close(struct fid *fid)
 {
 	struct xnet_domain *domain;
@@ -46,9 +67,9 @@ static int xnet_mr_close(struct fid *fid)
 	domain = container_of(&mr->domain->domain_fid, struct xnet_domain,
 			      util_domain.domain_fid.fid);
 
-	ofi_genlock_lock(&domain->progress.lock);
+	xnet_lock_mr_map(domain);
 	ret = ofi_mr_close(fid);
-	ofi_genlock_unlock(&domain->progress.lock);
+	xnet_unlock_mr_map(domain);
 	return ret;
 }
 
@@ -71,10 +92,10 @@ xnet_mr_reg(struct fid *fid, const void *buf, size_t len,
 
 	domain = container_of(fid, struct xnet_domain,
 			      util_domain.domain_fid.fid);
-	ofi_genlock_lock(&domain->progress.lock);
+	xnet_lock_mr_map(domain);
 	ret = ofi_mr_reg(fid, buf, len, access, offset, requested_key, flags,
 			 mr_fid, context);
-	ofi_genlock_unlock(&domain->progress.lock);
+	xnet_unlock_mr_map(domain);
 
 	if (!ret) {
 		mr = container_of(*mr_fid, struct ofi_mr, mr_fid.fid);
@@ -95,10 +116,10 @@ xnet_mr_regv(struct fid *fid, const struct iovec *iov,
 
 	domain = container_of(fid, struct xnet_domain,
 			      util_domain.domain_fid.fid);
-	ofi_genlock_lock(&domain->progress.lock);
+	xnet_lock_mr_map(domain);
 	ret = ofi_mr_regv(fid, iov, count, access, offset, requested_key, flags,
 			 mr_fid, context);
-	ofi_genlock_unlock(&domain->progress.lock);
+	xnet_unlock_mr_map(domain);
 
 	if (!ret) {
 		mr = container_of(*mr_fid, struct ofi_mr, mr_fid.fid);
@@ -117,9 +138,9 @@ xnet_mr_regattr(struct fid *fid, const struct fi_mr_attr *attr,
 
 	domain = container_of(fid, struct xnet_domain,
 			      util_domain.domain_fid.fid);
-	ofi_genlock_lock(&domain->progress.lock);
+	xnet_lock_mr_map(domain);
 	ret = ofi_mr_regattr(fid, attr, flags, mr_fid);
-	ofi_genlock_unlock(&domain->progress.lock);
+	xnet_unlock_mr_map(domain);
 
 	if (!ret) {
 		mr = container_of(*mr_fid, struct ofi_mr, mr_fid.fid);
@@ -174,6 +195,62 @@ static struct fi_ops_domain xnet_domain_ops = {
 	.query_collective = fi_no_query_collective,
 };
 
+static void xnet_close_shards(struct xnet_domain *domain)
+{
+	while (domain->shard_cnt)
+		xnet_close_progress(&domain->shards[--domain->shard_cnt]);
+	free(domain->shards);
+	domain->shards = NULL;
+}
+
+/* Shards are always driven by their own threads.  Endpoints underlying
+ * an rdm endpoint share its receive state, so rdm domains do not shard.
+ */
+static int xnet_init_shards(struct xnet_domain *domain, struct fi_info *info)
+{
+	int ret;
+
+	ofi_atomic_initialize32(&domain->next_shard, 0);
+	if (!xnet_progress_threads || xnet_disable_autoprog ||
+	    (info->ep_attr && info->ep_attr->type == FI_EP_RDM))
+		return 0;
+
+	domain->shards = calloc(xnet_progress_threads,
+				sizeof(*domain->shards));
+	if (!domain->shards)
+		return -FI_ENOMEM;
+
+	while (domain->shard_cnt < xnet_progress_threads) {
+		ret = xnet_init_progress(&domain->shards[domain->shard_cnt],
+					 info);
+		if (ret)
+			goto err;
+
+		domain->shards[domain->shard_cnt].shard = true;
+		ret = xnet_start_progress(&domain->shards[domain->shard_cnt]);
+		domain->shard_cnt++;
+		if (ret)
+			goto err;
+	}
+	return 0;
+
+err:
+	xnet_close_shards(domain);
+	return ret;
+}
+
+/* Assign shards round robin, otherwise use the domain progress engine. */
+struct xnet_progress *xnet_domain_next_progress(struct xnet_domain *domain)
+{
+	uint32_t i;
+
+	if (!domain->shard_cnt)
+		return &domain->progress;
+
+	i = (uint32_t) ofi_atomic_inc32(&domain->next_shard);
+	return &domain->shards[i % domain->shard_cnt];
+}
+
 static int xnet_domain_close(fid_t fid)
 {
 	struct xnet_domain *domain;
@@ -187,6 +264,7 @@ static int xnet_domain_close(fid_t fid)
 	if (ret)
 		return ret;
 
+	xnet_close_shards(domain);
 	xnet_close_progress(&domain->progress);
 	free(domain);
 	return FI_SUCCESS;
@@ -232,6 +310,10 @@ int xnet_domain_open(struct fid_fabric *fabric_fid, struct fi_info *info,
 	if (ret)
 		goto close;
 
+	ret = xnet_init_shards(domain, info);
+	if (ret)
+		goto close_progress;
+
 	domain->util_domain.domain_fid.fid.ops = &xnet_domain_fi_ops;
 	domain->util_domain.domain_fid.ops = &xnet_domain_ops;
 	domain->util_domain.domain_fid.mr = &xnet_domain_fi_ops_mr;
@@ -239,6 +321,8 @@ int xnet_domain_open(struct fid_fabric *fabric_fid, struct fi_info *info,
 
 	return FI_SUCCESS;
 
+close_progress:
+	xnet_close_progress(&domain->progress);
 close:
 	(void) ofi_domain_close(&domain->util_domain);
 free:
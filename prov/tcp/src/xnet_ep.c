@@ -124,6 +124,17 @@ static void xnet_config_bsock(struct ofi_bsock *bsock)
 	if (xnet_zerocopy_size == SIZE_MAX)
 		return;
 
+	/* io_uring zero copy sends do not require SO_ZEROCOPY */
+	if (xnet_io_uring) {
+		if (bsock->sockapi->tx_uring.send_zc) {
+			bsock->zerocopy_size = xnet_zerocopy_size;
+			FI_INFO(&xnet_prov, FI_LOG_EP_CTRL,
+				"io_uring zero copy enabled for transfers > %zu\n",
+				bsock->zerocopy_size);
+		}
+		return;
+	}
+
 	ret = getsockopt(bsock->sock, SOL_SOCKET, SO_ZEROCOPY, &val, &len);
 	if (!ret && val) {
 		bsock->zerocopy_size = xnet_zerocopy_size;
@@ -153,6 +164,29 @@ static void xnet_set_no_port(SOCKET sock)
 #define xnet_set_no_port(sock)
 #endif
 
+#if defined(SO_BUSY_POLL) && defined(SO_PREFER_BUSY_POLL)
+static void xnet_set_busy_poll(SOCKET sock)
+{
+	int val = xnet_busy_poll;
+
+	if (setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val))) {
+		FI_INFO(&xnet_prov, FI_LOG_EP_CTRL,
+			"setsockopt busy poll failed (%s)\n",
+			strerror(ofi_sockerr()));
+		return;
+	}
+
+	val = 1;
+	(void) setsockopt(sock, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+			  &val, sizeof(val));
+}
+#else
+static void xnet_set_busy_poll(SOCKET sock)
+{
+	OFI_UNUSED(sock);
+}
+#endif
+
 int xnet_setup_socket(SOCKET sock, struct fi_info *info)
 {
 	int ret, optval = 1;
@@ -180,6 +214,9 @@ int xnet_setup_socket(SOCKET sock, struct fi_info *info)
 		}
 	}
 
+	if (xnet_busy_poll)
+		xnet_set_busy_poll(sock);
+
 	ret = fi_fd_nonblock(sock);
 	if (ret) {
 		FI_WARN(&xnet_prov, FI_LOG_EP_CTRL,
@@ -194,8 +231,8 @@ static int xnet_monitor_ep(struct xnet_progress *progress, struct xnet_ep *ep)
 {
 	if (xnet_io_uring) {
 		assert(!(ep->pollflags & POLLOUT));
-		return xnet_uring_pollin_add(progress, ep->bsock.sock,
-					     false, &ep->bsock.pollin_sockctx);
+		xnet_uring_register_ep(ep);
+		return xnet_uring_pollin_ep(ep);
 	}
 
 	return xnet_monitor_sock(progress, ep->bsock.sock, ep->pollflags,
@@ -361,6 +398,8 @@ static void xnet_ep_flush_all_queues(struct xnet_ep *ep)
 				&ep->util_ep.ep_fid);
 	if (ret)
 		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "Failed to cancel POLLIN uring\n");
+	xnet_uring_mshot_release(ep);
+	xnet_uring_unregister_ep(ep);
 
 	if (ep->cur_tx.entry) {
 		ep->hdr_bswap(ep, &ep->cur_tx.entry->hdr.base_hdr);
@@ -559,13 +598,15 @@ static int xnet_ep_close(struct fid *fid)
 	dlist_remove_init(&ep->unexp_entry);
 	if (!xnet_io_uring)
 		xnet_halt_sock(progress, ep->bsock.sock);
+	xnet_uring_unregister_ep(ep);
 	ofi_close_socket(ep->bsock.sock);
 	xnet_ep_flush_all_queues(ep);
 	ofi_genlock_unlock(&progress->lock);
 
 	if (ep->bsock.tx_sockctx.uring_sqe_inuse ||
 	    ep->bsock.rx_sockctx.uring_sqe_inuse ||
-	    ep->bsock.pollin_sockctx.uring_sqe_inuse)
+	    ep->bsock.pollin_sockctx.uring_sqe_inuse ||
+	    ep->mshot_cancel_sockctx.uring_sqe_inuse)
 		return -FI_EBUSY;
 
 	free(ep->cm_msg);
@@ -610,6 +651,18 @@ static int xnet_ep_bind(struct fid *fid, struct fid *bfid, uint64_t flags)
 	switch (bfid->fclass) {
 	case FI_CLASS_SRX_CTX:
 		srx = container_of(bfid, struct xnet_srx, rx_fid.fid);
+		/* Receives are matched by the srx under the domain progress
+		 * lock, so the endpoint cannot be driven by a shard.
+		 */
+		if (ep->progress != xnet_srx2_progress(srx)) {
+			if (ep->state != XNET_IDLE &&
+			    ep->state != XNET_ACCEPTING)
+				return -FI_EOPBADSTATE;
+
+			assert(slist_empty(&ep->rx_queue));
+			ep->progress = xnet_srx2_progress(srx);
+			ep->bsock.sockapi = &ep->progress->sockapi;
+		}
 		ep->srx = srx;
 		return FI_SUCCESS;
 	case FI_CLASS_EQ:
@@ -683,6 +736,7 @@ static struct fi_ops_ep xnet_ep_ops = {
 int xnet_endpoint(struct fid_domain *domain, struct fi_info *info,
 		  struct fid_ep **ep_fid, void *context)
 {
+	struct xnet_domain *xnet_domain;
 	struct xnet_ep *ep;
 	struct xnet_pep *pep;
 	struct xnet_conn_handle *conn;
@@ -697,9 +751,17 @@ int xnet_endpoint(struct fid_domain *domain, struct fi_info *info,
 	if (ret)
 		goto err1;
 
+	xnet_domain = container_of(domain, struct xnet_domain,
+				   util_domain.domain_fid);
+	if (info->ep_attr->rx_ctx_cnt == FI_SHARED_CONTEXT)
+		ep->progress = &xnet_domain->progress;
+	else
+		ep->progress = xnet_domain_next_progress(xnet_domain);
+
 	ofi_bsock_init(&ep->bsock, &xnet_ep2_progress(ep)->sockapi,
 		       xnet_staging_sbuf_size, xnet_prefetch_rbuf_size,
 		       &ep->util_ep.ep_fid);
+	ofi_sockctx_init(&ep->mshot_cancel_sockctx, &ep->util_ep.ep_fid);
 	if (info->handle) {
 		if (((fid_t) info->handle)->fclass == FI_CLASS_PEP) {
 			pep = container_of(info->handle, struct xnet_pep,
@@ -774,6 +836,8 @@ int xnet_endpoint(struct fid_domain *domain, struct fi_info *info,
 	slist_init(&ep->rma_read_queue);
 	slist_init(&ep->need_ack_queue);
 	slist_init(&ep->async_queue);
+	slist_init(&ep->mshot_bufs);
+	dlist_init(&ep->mshot_entry);
 
 	if (info->ep_attr->rx_ctx_cnt != FI_SHARED_CONTEXT)
 		ep->rx_avail = (int) info->rx_attr->size;
@@ -58,6 +58,7 @@ struct xnet_port_range xnet_ports = {
 };
 
 int xnet_nodelay = -1;
+int xnet_busy_poll;
 
 int xnet_staging_sbuf_size = 9000;
 int xnet_prefetch_rbuf_size = 9000;
@@ -66,7 +67,10 @@ size_t xnet_default_rx_size = 256;
 size_t xnet_zerocopy_size = SIZE_MAX;
 int xnet_trace_msg;
 int xnet_disable_autoprog;
+int xnet_progress_threads;
 int xnet_io_uring;
+int xnet_io_uring_multishot;
+int xnet_io_uring_fixed;
 int xnet_max_saved = 64;
 size_t xnet_max_inject = XNET_DEF_INJECT;
 size_t xnet_buf_size = XNET_DEF_BUF_SIZE;
@@ -157,6 +161,18 @@ static void xnet_init_env(void)
 			"(default %d)", xnet_nodelay);
 	fi_param_get_bool(&xnet_prov, "nodelay", &xnet_nodelay);
 
+	fi_param_define(&xnet_prov, "busy_poll", FI_PARAM_INT,
+			"busy poll timeout in microseconds, set to 0 to "
+			"disable.  Sets SO_BUSY_POLL and SO_PREFER_BUSY_POLL "
+			"on sockets and the epoll busy poll parameters, and "
+			"lets the progress engine spin for up to this long "
+			"before blocking while events arrive at a higher "
+			"rate.  Timeouts above net.core.busy_read require "
+			"CAP_NET_ADMIN (default: %d)", xnet_busy_poll);
+	fi_param_get_int(&xnet_prov, "busy_poll", &xnet_busy_poll);
+	if (xnet_busy_poll < 0)
+		xnet_busy_poll = 0;
+
 	fi_param_define(&xnet_prov, "staging_sbuf_size", FI_PARAM_INT,
 			"size of buffer used to coalesce iovec's or "
 			"send requests before posting to the kernel, "
@@ -182,10 +198,30 @@ static void xnet_init_env(void)
 			"prevent auto-progress thread from starting");
 	fi_param_get_bool(&xnet_prov, "disable_auto_progress",
 			&xnet_disable_autoprog);
+	fi_param_define(&xnet_prov, "progress_threads", FI_PARAM_INT,
+			"number of additional progress threads per domain "
+			"that msg endpoints are spread across, set to 0 to "
+			"progress all endpoints of a domain together "
+			"(default: %d)", xnet_progress_threads);
+	fi_param_get_int(&xnet_prov, "progress_threads",
+			 &xnet_progress_threads);
+	if (xnet_progress_threads < 0)
+		xnet_progress_threads = 0;
 	fi_param_define(&xnet_prov, "io_uring", FI_PARAM_BOOL,
 			"Enable io_uring support if available (default: %d)", xnet_io_uring);
 	fi_param_get_bool(&xnet_prov, "io_uring",
 			 &xnet_io_uring);
+	fi_param_define(&xnet_prov, "io_uring_multishot", FI_PARAM_BOOL,
+			"Receive data using multishot receives and a ring of "
+			"kernel provided buffers when io_uring is enabled "
+			"(default: %d)", xnet_io_uring_multishot);
+	fi_param_get_bool(&xnet_prov, "io_uring_multishot",
+			 &xnet_io_uring_multishot);
+	fi_param_define(&xnet_prov, "io_uring_fixed", FI_PARAM_BOOL,
+			"Register connected sockets and their staging buffers "
+			"with io_uring as fixed files and buffers "
+			"(default: %d)", xnet_io_uring_fixed);
+	fi_param_get_bool(&xnet_prov, "io_uring_fixed", &xnet_io_uring_fixed);
 }
 
 static void xnet_fini(void)
@@ -38,6 +38,9 @@
 #include <poll.h>
 
 #include <sys/types.h>
+#ifdef EPIOCSPARAMS
+#include <sys/ioctl.h>
+#endif
 #include <ifaddrs.h>
 #include <net/if.h>
 #include <ofi_util.h>
@@ -140,6 +143,8 @@ xnet_get_save_rx(struct xnet_ep *ep, uint64_t tag)
 	}
 
 	slist_insert_tail(&rx_entry->entry, &ep->saved_msg->queue);
+	dlist_insert_tail(&rx_entry->match_entry,
+			  xnet_tag_bucket(&ep->srx->saved_hash, tag));
 	if (!ep->saved_msg->cnt++) {
 		assert(dlist_empty(&ep->saved_msg->entry));
 		dlist_insert_tail(&ep->saved_msg->entry,
@@ -277,6 +282,181 @@ int xnet_uring_pollin_add(struct xnet_progress *progress, int fd,
 	return 0;
 }
 
+static void xnet_uring_mshot_rearm(struct xnet_progress *progress)
+{
+	struct xnet_uring *uring = &progress->rx_uring;
+	struct xnet_ep *ep;
+
+	while (!dlist_empty(&uring->mshot_wait_list) &&
+	       uring->bufs_held < uring->buf_ring.count) {
+		dlist_pop_front(&uring->mshot_wait_list, struct xnet_ep,
+				ep, mshot_entry);
+		dlist_init(&ep->mshot_entry);
+		if (xnet_uring_pollin_ep(ep))
+			xnet_ep_disable(ep, 0, NULL, 0);
+	}
+	xnet_submit_uring(uring);
+}
+
+static void
+xnet_uring_buf_recycle(struct xnet_progress *progress,
+		       struct xnet_uring_buf *buf)
+{
+	struct xnet_uring *uring = &progress->rx_uring;
+
+	assert(uring->bufs_held);
+	ofi_uring_buf_ring_recycle(&uring->buf_ring,
+				   (unsigned int) (buf - uring->bufs));
+	uring->bufs_held--;
+}
+
+/* Copy data from held multishot buffers into the prefetch buffer,
+ * returning the buffers to the ring as they are drained.
+ */
+static size_t xnet_uring_mshot_fill(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+	struct xnet_uring *uring;
+	struct xnet_uring_buf *buf;
+	size_t len, copied = 0;
+	int cnt;
+
+	if (slist_empty(&ep->mshot_bufs))
+		return 0;
+
+	progress = xnet_ep2_progress(ep);
+	uring = &progress->rx_uring;
+	cnt = ep->mshot_cnt;
+	do {
+		buf = container_of(ep->mshot_bufs.head, struct xnet_uring_buf,
+				   entry);
+		len = ofi_bsock_prefetch_write(&ep->bsock,
+			(uint8_t *) ofi_uring_buf_ring_buf(&uring->buf_ring,
+				(unsigned int) (buf - uring->bufs)) + buf->offset,
+			buf->len - buf->offset);
+		copied += len;
+		buf->offset += (uint32_t) len;
+		if (buf->offset < buf->len)
+			break;
+
+		slist_remove_head(&ep->mshot_bufs);
+		ep->mshot_cnt--;
+		xnet_uring_buf_recycle(progress, buf);
+	} while (!slist_empty(&ep->mshot_bufs));
+
+	if (cnt == ep->mshot_cnt)
+		return copied;
+
+	if (!dlist_empty(&uring->mshot_wait_list))
+		xnet_uring_mshot_rearm(progress);
+
+	/* Our multishot receive was canceled because we held too many
+	 * buffers.  Restart it now that we're below the limit.
+	 */
+	if (cnt >= XNET_URING_MSHOT_MAX && ep->mshot_cnt < XNET_URING_MSHOT_MAX &&
+	    (ep->pollflags & POLLIN) && ep->state == XNET_CONNECTED &&
+	    !ep->bsock.pollin_sockctx.uring_sqe_inuse) {
+		if (xnet_uring_pollin_ep(ep))
+			xnet_ep_disable(ep, 0, NULL, 0);
+		else
+			xnet_submit_uring(uring);
+	}
+	return copied;
+}
+
+void xnet_uring_mshot_release(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+	struct xnet_uring_buf *buf;
+
+	if (!ep->bsock.multishot)
+		return;
+
+	progress = xnet_ep2_progress(ep);
+	assert(xnet_progress_locked(progress));
+	dlist_remove_init(&ep->mshot_entry);
+	while (!slist_empty(&ep->mshot_bufs)) {
+		buf = container_of(slist_remove_head(&ep->mshot_bufs),
+				   struct xnet_uring_buf, entry);
+		xnet_uring_buf_recycle(progress, buf);
+	}
+	ep->mshot_cnt = 0;
+
+	if (!dlist_empty(&progress->rx_uring.mshot_wait_list))
+		xnet_uring_mshot_rearm(progress);
+}
+
+void xnet_uring_register_ep(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+	int ret;
+
+	progress = xnet_ep2_progress(ep);
+	if (!progress->sockapi.tx_uring.fixed_cnt)
+		return;
+
+	ret = ofi_sockapi_uring_register(&progress->sockapi.tx_uring,
+					 ep->bsock.sock, ep->bsock.sq.data,
+					 sizeof(ep->bsock.sq.data));
+	if (!ret) {
+		ret = ofi_sockapi_uring_register(&progress->sockapi.rx_uring,
+						 ep->bsock.sock,
+						 ep->bsock.rq.data,
+						 sizeof(ep->bsock.rq.data));
+	}
+	if (ret) {
+		FI_INFO(&xnet_prov, FI_LOG_EP_CTRL,
+			"unable to register socket with io_uring\n");
+	}
+}
+
+void xnet_uring_unregister_ep(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+
+	progress = xnet_ep2_progress(ep);
+	ofi_sockapi_uring_unregister(&progress->sockapi.tx_uring,
+				     ep->bsock.sock);
+	ofi_sockapi_uring_unregister(&progress->sockapi.rx_uring,
+				     ep->bsock.sock);
+}
+
+/* Arm the endpoint to be woken when data arrives.  If the rx_uring has
+ * a provided buffer ring, a multishot receive is posted, which delivers
+ * data directly.  Otherwise, a POLLIN request is posted.
+ */
+int xnet_uring_pollin_ep(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+	struct xnet_uring *uring;
+	int ret;
+
+	progress = xnet_ep2_progress(ep);
+	uring = &progress->rx_uring;
+	if (!uring->bufs) {
+		return xnet_uring_pollin_add(progress, ep->bsock.sock, false,
+					     &ep->bsock.pollin_sockctx);
+	}
+
+	assert(xnet_progress_locked(progress));
+	ep->bsock.multishot = true;
+	if (ep->bsock.pollin_sockctx.uring_sqe_inuse ||
+	    ep->mshot_cnt >= XNET_URING_MSHOT_MAX)
+		return 0;
+
+	if (uring->bufs_held == uring->buf_ring.count) {
+		if (dlist_empty(&ep->mshot_entry))
+			dlist_insert_tail(&ep->mshot_entry,
+					  &uring->mshot_wait_list);
+		return 0;
+	}
+
+	ret = ofi_sockctx_uring_recv_multishot(uring->sockapi, ep->bsock.sock,
+					       &uring->buf_ring,
+					       &ep->bsock.pollin_sockctx);
+	return ret == -OFI_EINPROGRESS_URING ? 0 : ret;
+}
+
 static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 {
 	struct xnet_progress *progress;
@@ -317,8 +497,7 @@ static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 			return 0;
 		}
 
-		ret = xnet_uring_pollin_add(progress, ep->bsock.sock,
-					    false, &ep->bsock.pollin_sockctx);
+		ret = xnet_uring_pollin_ep(ep);
 	} else {
 		ret = ofi_dynpoll_mod(&progress->epoll_fd, ep->bsock.sock,
 				      ep->pollflags, &ep->util_ep.ep_fid.fid);
@@ -650,7 +829,7 @@ static int xnet_handle_ack(struct xnet_ep *ep)
 	return FI_SUCCESS;
 }
 
-int xnet_start_recv(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entry)
+static int xnet_prep_recv(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entry)
 {
 	struct xnet_active_rx *msg = &ep->cur_rx;
 	size_t msg_len;
@@ -680,10 +859,9 @@ int xnet_start_recv(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entry)
 	}
 
 	(void) ofi_truncate_iov(rx_entry->iov, &rx_entry->iov_cnt, msg_len);
-
 	ep->cur_rx.entry = rx_entry;
 	ep->cur_rx.handler = xnet_recv_msg_data;
-	return xnet_recv_msg_data(ep);
+	return 0;
 
  poll_err:
 	xnet_cntr_incerr(rx_entry);
@@ -692,6 +870,17 @@ int xnet_start_recv(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entry)
 	return ret;
 }
 
+int xnet_start_recv(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entry)
+{
+	int ret;
+
+	ret = xnet_prep_recv(ep, rx_entry);
+	if (ret)
+		return ret;
+
+	return xnet_recv_msg_data(ep);
+}
+
 static int xnet_op_msg(struct xnet_ep *ep)
 {
 	struct xnet_xfer_entry *rx_entry;
@@ -905,11 +1094,131 @@ static int xnet_progress_hdr(struct xnet_ep *ep)
 	ep->cur_rx.data_left = ep->cur_rx.hdr.base_hdr.size -
 			       ep->cur_rx.hdr.base_hdr.hdr_size;
 	ep->cur_rx.handler = xnet_start_op[ep->cur_rx.hdr.base_hdr.op];
+	ep->cur_rx.predict = ep->cur_rx.hdr.base_hdr.op == ofi_op_msg &&
+			     ep->cur_rx.hdr.base_hdr.hdr_size ==
+			     sizeof(ep->cur_rx.hdr.base_hdr) &&
+			     !ep->cur_rx.hdr.base_hdr.op_data;
 	return FI_SUCCESS;
 }
 
+/* Data may be buffered in the prefetch buffer or held multishot buffers */
+static bool xnet_rx_pending(struct xnet_ep *ep)
+{
+	return ofi_bsock_readable(&ep->bsock) || !slist_empty(&ep->mshot_bufs);
+}
+
+/* Return the receive buffer a predicted message would land in */
+static struct xnet_xfer_entry *xnet_predict_rx_entry(struct xnet_ep *ep)
+{
+	struct xnet_xfer_entry *rx_entry;
+	struct slist *queue;
+
+	if (xnet_io_uring || ep->hdr_bswap != xnet_hdr_none ||
+	    !ep->bsock.rq.size || xnet_rx_pending(ep))
+		return NULL;
+
+	queue = ep->srx ? &ep->srx->rx_queue : &ep->rx_queue;
+	if (slist_empty(queue))
+		return NULL;
+
+	rx_entry = container_of(queue->head, struct xnet_xfer_entry, entry);
+	if (rx_entry->ctrl_flags & XNET_MULTI_RECV)
+		return NULL;
+
+	return rx_entry;
+}
+
+/* Return received bytes past the end of the current message to the
+ * prefetch buffer, ahead of the rq_len bytes already placed there.
+ */
+static void xnet_unread(struct xnet_ep *ep, struct iovec *iov, size_t cnt,
+			size_t offset, size_t len, size_t rq_len)
+{
+	struct ofi_byteq *rq = &ep->bsock.rq;
+
+	assert(len + rq_len <= rq->size);
+	memmove(&rq->data[len], rq->data, rq_len);
+	(void) ofi_copy_from_iov(rq->data, len, iov, cnt, offset);
+	ofi_byteq_discard(rq);
+	ofi_byteq_add(rq, len + rq_len);
+}
+
+/*
+ * Header prediction: a connection carrying plain messages will usually
+ * deliver another one next.  Receive the base header, the payload and any
+ * following data with a single recvmsg, scattering the payload directly
+ * into the posted buffer rather than copying it out of the prefetch
+ * buffer.  At most half the prefetch buffer is read into the posted
+ * buffer, so that whatever does not belong to a predicted message can be
+ * handed back to the prefetch buffer and the header processed normally.
+ * The posted buffer contents are undefined until its completion, so a
+ * misprediction may overwrite it.
+ */
+static int xnet_recv_predicted(struct xnet_ep *ep,
+			       struct xnet_xfer_entry *rx_entry)
+{
+	struct iovec iov[XNET_IOV_LIMIT + 3];
+	struct xnet_base_hdr *hdr = &ep->cur_rx.hdr.base_hdr;
+	size_t cnt, buf_len, len, rq_len, msg_len;
+	ssize_t ret;
+
+	cnt = rx_entry->iov_cnt;
+	buf_len = ofi_total_iov_len(rx_entry->iov, cnt);
+
+	iov[0].iov_base = hdr;
+	iov[0].iov_len = sizeof(*hdr);
+	memcpy(&iov[1], rx_entry->iov, cnt * sizeof(*rx_entry->iov));
+	len = MIN(buf_len, ep->bsock.rq.size >> 1);
+	(void) ofi_truncate_iov(&iov[1], &cnt, len);
+	ofi_byteq_discard(&ep->bsock.rq);
+	iov[cnt + 1].iov_base = ep->bsock.rq.data;
+	iov[cnt + 1].iov_len = ep->bsock.rq.size - len;
+
+	ret = ep->bsock.sockapi->recvv(ep->bsock.sockapi, ep->bsock.sock, iov,
+				       cnt + 2, MSG_NOSIGNAL,
+				       &ep->bsock.rx_sockctx);
+	if (ret < 0)
+		return (int) ret;
+
+	ep->cur_rx.hdr_done = MIN((size_t) ret, sizeof(*hdr));
+	rq_len = (size_t) ret - ep->cur_rx.hdr_done;
+	len = MIN(rq_len, len);
+	rq_len -= len;
+
+	if (ep->cur_rx.hdr_done < sizeof(*hdr) || hdr->op != ofi_op_msg ||
+	    hdr->hdr_size != sizeof(*hdr) || hdr->op_data ||
+	    hdr->size - sizeof(*hdr) > buf_len) {
+		xnet_unread(ep, &iov[1], cnt, 0, len, rq_len);
+		return 1;
+	}
+
+	msg_len = (size_t) hdr->size - sizeof(*hdr);
+	if (len > msg_len || rq_len) {
+		xnet_unread(ep, &iov[1], cnt, msg_len,
+			    len > msg_len ? len - msg_len : 0, rq_len);
+		len = MIN(len, msg_len);
+	}
+
+	ret = xnet_progress_hdr(ep);
+	assert(!ret);
+	if (xnet_get_rx_entry(ep) != rx_entry) {
+		assert(0);
+		return -FI_EIO;
+	}
+
+	ret = xnet_prep_recv(ep, rx_entry);
+	if (ret)
+		return (int) ret;
+
+	ep->cur_rx.data_left -= len;
+	if (ep->cur_rx.data_left)
+		ofi_consume_iov(rx_entry->iov, &rx_entry->iov_cnt, len);
+	return xnet_recv_msg_data(ep);
+}
+
 static int xnet_recv_hdr(struct xnet_ep *ep)
 {
+	struct xnet_xfer_entry *rx_entry;
 	size_t len;
 	void *buf;
 	int ret;
@@ -917,6 +1226,16 @@ static int xnet_recv_hdr(struct xnet_ep *ep)
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
 	assert(ep->cur_rx.hdr_done < ep->cur_rx.hdr_len);
 
+	if (!ep->cur_rx.hdr_done && ep->cur_rx.predict) {
+		rx_entry = xnet_predict_rx_entry(ep);
+		if (rx_entry) {
+			ret = xnet_recv_predicted(ep, rx_entry);
+			if (ret <= 0)
+				return ret;
+			goto progress_hdr;
+		}
+	}
+
 next_hdr:
 	buf = (uint8_t *) &ep->cur_rx.hdr + ep->cur_rx.hdr_done;
 	len = ep->cur_rx.hdr_len - ep->cur_rx.hdr_done;
@@ -929,6 +1248,7 @@ next_hdr:
 
 	ep->cur_rx.hdr_done += len;
 
+progress_hdr:
 	ret = xnet_progress_hdr(ep);
 	if (ret) {
 		if (ret == -FI_EAGAIN &&
@@ -985,6 +1305,9 @@ void xnet_progress_rx(struct xnet_ep *ep)
 	int ret;
 
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
+	if (ep->bsock.multishot)
+		xnet_uring_mshot_fill(ep);
+
 	do {
 		if (ep->cur_rx.hdr_done < ep->cur_rx.hdr_len) {
 			ret = xnet_recv_hdr(ep);
@@ -992,8 +1315,15 @@ void xnet_progress_rx(struct xnet_ep *ep)
 			ret = ep->cur_rx.handler(ep);
 		}
 
-		if (OFI_SOCK_TRY_SND_RCV_AGAIN(-ret) ||
-		    ret == -OFI_EINPROGRESS_URING)
+		if (OFI_SOCK_TRY_SND_RCV_AGAIN(-ret)) {
+			if (ep->bsock.multishot && xnet_uring_mshot_fill(ep)) {
+				ret = 0;
+				continue;
+			}
+			break;
+		}
+
+		if (ret == -OFI_EINPROGRESS_URING)
 			break;
 
 		if (ep->cur_rx.entry)
@@ -1001,7 +1331,7 @@ void xnet_progress_rx(struct xnet_ep *ep)
 		else if (ret)
 			xnet_ep_disable(ep, 0, NULL, 0);
 
-	} while (!ret && ofi_bsock_readable(&ep->bsock));
+	} while (!ret && xnet_rx_pending(ep));
 
 	if (xnet_io_uring) {
 		if (ret == -OFI_EINPROGRESS_URING)
@@ -1033,10 +1363,21 @@ void xnet_progress_async(struct xnet_ep *ep)
 	}
 }
 
-static void xnet_uring_tx_done(struct xnet_ep *ep, int res)
+static void xnet_uring_tx_done(struct xnet_ep *ep, int res, uint32_t flags)
 {
 	struct xnet_xfer_entry *tx_entry;
 
+	/* A zero copy send completes first with the number of bytes sent,
+	 * then with a notification once the kernel no longer references
+	 * the buffer.  The transfer is only completed after the latter.
+	 */
+	if (flags & IORING_CQE_F_MORE) {
+		ep->cur_tx.zc_res = res;
+		return;
+	}
+	if (flags & IORING_CQE_F_NOTIF)
+		res = ep->cur_tx.zc_res;
+
 	tx_entry = ep->cur_tx.entry;
 	assert(tx_entry);
 
@@ -1129,13 +1470,67 @@ disable:
 	xnet_ep_disable(ep, -ret, NULL, 0);
 }
 
+static void xnet_uring_mshot_done(struct xnet_ep *ep, int res, uint32_t flags)
+{
+	struct xnet_progress *progress;
+	struct xnet_uring *uring;
+	struct xnet_uring_buf *buf;
+	int ret;
+
+	progress = xnet_ep2_progress(ep);
+	uring = &progress->rx_uring;
+	if (flags & IORING_CQE_F_BUFFER) {
+		buf = &uring->bufs[flags >> IORING_CQE_BUFFER_SHIFT];
+		uring->bufs_held++;
+		if (res <= 0 || ep->state != XNET_CONNECTED) {
+			xnet_uring_buf_recycle(progress, buf);
+		} else {
+			buf->len = (uint32_t) res;
+			buf->offset = 0;
+			slist_insert_tail(&buf->entry, &ep->mshot_bufs);
+			ep->mshot_cnt++;
+		}
+	}
+
+	/* Must be a cancelation otherwise */
+	if (ep->state != XNET_CONNECTED)
+		return;
+
+	if (!(flags & IORING_CQE_F_MORE)) {
+		/* The receive was terminated because the buffer ring was
+		 * empty or we canceled it.  It will be restarted by
+		 * xnet_progress_rx() or when buffers are returned.
+		 */
+		if (!res || (res < 0 && res != -ENOBUFS &&
+			     res != -ECANCELED)) {
+			xnet_ep_disable(ep, 0, NULL, 0);
+			return;
+		}
+		ep->pollflags &= ~POLLIN;
+	} else if (ep->mshot_cnt >= XNET_URING_MSHOT_MAX) {
+		ret = ofi_sockctx_uring_cancel(uring->sockapi,
+					       &ep->bsock.pollin_sockctx,
+					       &ep->mshot_cancel_sockctx);
+		if (ret && ret != -OFI_EINPROGRESS_URING)
+			FI_DBG(&xnet_prov, FI_LOG_EP_DATA,
+			       "unable to cancel multishot receive\n");
+	}
+
+	xnet_progress_rx(ep);
+}
+
 static void xnet_uring_run_ep(struct xnet_ep *ep, struct ofi_sockctx *sockctx,
-			      int res)
+			      int res, uint32_t flags)
 {
+	if (ep->bsock.multishot && sockctx == &ep->bsock.pollin_sockctx) {
+		xnet_uring_mshot_done(ep, res, flags);
+		return;
+	}
+
 	switch (ep->state) {
 	case XNET_CONNECTED:
 		if (sockctx == &ep->bsock.tx_sockctx) {
-			xnet_uring_tx_done(ep, res);
+			xnet_uring_tx_done(ep, res, flags);
 		} else if (sockctx == &ep->bsock.rx_sockctx) {
 			xnet_uring_rx_done(ep, res);
 		} else if (sockctx == &ep->bsock.pollin_sockctx) {
@@ -1181,15 +1576,17 @@ static void xnet_progress_cqe(struct xnet_progress *progress,
 	sockctx = (struct ofi_sockctx *) cqe->user_data;
 	assert(sockctx);
 	assert(sockctx->uring_sqe_inuse);
-	if (!(cqe ->flags & IORING_CQE_F_MORE))
+	/* Multishot requests hold their SQE credit until terminated */
+	if (!(cqe->flags & IORING_CQE_F_MORE)) {
 		sockctx->uring_sqe_inuse = false;
-	uring->sockapi->credits++;
+		uring->sockapi->credits++;
+	}
 
 	fid = sockctx->context;
 	switch (fid->fclass) {
 	case FI_CLASS_EP:
 		ep = container_of(fid, struct xnet_ep, util_ep.ep_fid.fid);
-		xnet_uring_run_ep(ep, sockctx, cqe->res);
+		xnet_uring_run_ep(ep, sockctx, cqe->res, cqe->flags);
 		break;
 	case FI_CLASS_CONNREQ:
 		conn = container_of(fid, struct xnet_conn_handle, fid);
@@ -1390,11 +1787,23 @@ void xnet_progress_unexp(struct xnet_progress *progress,
 	}
 }
 
+/* Completions generated while handling events are batched, and written
+ * to the CQ once all events have been processed.  Shards instead write
+ * each completion to the CQ's lock-free staging ring, so that they do
+ * not contend on the CQ lock with each other or the reader.
+ */
 void xnet_run_progress(struct xnet_progress *progress, bool clear_signal)
 {
+	struct ofi_cq_batch cq_batch;
 	int nfds;
 
 	assert(ofi_genlock_held(progress->active_lock));
+	assert(!progress->cq_batch);
+	if (!progress->shard) {
+		ofi_cq_batch_init(&cq_batch);
+		progress->cq_batch = &cq_batch;
+	}
+
 	if (xnet_io_uring) {
 		xnet_progress_uring(progress, &progress->tx_uring);
 		xnet_progress_uring(progress, &progress->rx_uring);
@@ -1406,6 +1815,11 @@ void xnet_run_progress(struct xnet_progress *progress, bool clear_signal)
 					ARRAY_SIZE(progress->events), 0);
 		xnet_handle_events(progress, &progress->events[0], nfds, clear_signal);
 	}
+
+	if (progress->cq_batch) {
+		(void) ofi_cq_batch_flush(progress->cq_batch);
+		progress->cq_batch = NULL;
+	}
 }
 
 void xnet_progress(struct xnet_progress *progress, bool clear_signal)
@@ -1451,6 +1865,56 @@ int xnet_trywait(struct fid_fabric *fabric_fid, struct fid **fid, int count)
 	return 0;
 }
 
+/* Tracks a moving average of the time between events, weighting the
+ * latest gap by 1/8.
+ */
+static void xnet_busy_poll_event(struct xnet_progress *progress, uint64_t now)
+{
+	uint64_t gap;
+
+	gap = progress->busy_poll_last ? now - progress->busy_poll_last : 0;
+	progress->busy_poll_last = now;
+	progress->busy_poll_gap = progress->busy_poll_gap -
+				  (progress->busy_poll_gap >> 3) + (gap >> 3);
+}
+
+/* Spins for up to the busy poll timeout before the caller blocks, as long
+ * as events have recently been arriving within that time of each other.
+ * Once traffic slows down, waiting threads block right away, and resume
+ * spinning when the gaps between events shrink again.
+ */
+static int xnet_busy_wait(struct xnet_progress *progress,
+			  struct ofi_epollfds_event *event)
+{
+	uint64_t now, end, budget;
+	int nfds;
+
+	budget = (uint64_t) xnet_busy_poll * 1000;
+	if (progress->busy_poll_gap > budget)
+		return 0;
+
+	now = ofi_gettime_ns();
+	end = now + budget;
+	do {
+		nfds = ofi_dynpoll_wait(&progress->epoll_fd, event, 1, 0);
+		if (nfds) {
+			if (nfds > 0)
+				xnet_busy_poll_event(progress,
+						     ofi_gettime_ns());
+			return nfds;
+		}
+		now = ofi_gettime_ns();
+	} while (now < end);
+
+	/* Count an empty spin as a gap of twice the budget.  The average
+	 * only approaches the gap recorded, so a gap equal to the budget
+	 * would never stop the spinning on an idle endpoint.
+	 */
+	progress->busy_poll_gap = progress->busy_poll_gap -
+				  (progress->busy_poll_gap >> 3) + (budget >> 2);
+	return 0;
+}
+
 /* We can't hold the progress lock around waiting, or we
  * can hang another thread trying to obtain the lock.  But
  * the poll fds may change while we're waiting for an event.
@@ -1462,6 +1926,7 @@ int xnet_trywait(struct fid_fabric *fabric_fid, struct fid **fid, int count)
 int xnet_progress_wait(struct xnet_progress *progress, int timeout)
 {
 	struct ofi_epollfds_event event;
+	int nfds;
 
 	/* We cannot enter blocking if io_uring has entries
 	 * that need submission. */
@@ -1469,7 +1934,17 @@ int xnet_progress_wait(struct xnet_progress *progress, int timeout)
 		assert(ofi_uring_sq_ready(&progress->tx_uring.ring) == 0);
 		assert(ofi_uring_sq_ready(&progress->rx_uring.ring) == 0);
 	}
-	return ofi_dynpoll_wait(&progress->epoll_fd, &event, 1, timeout);
+
+	if (xnet_busy_poll && timeout) {
+		nfds = xnet_busy_wait(progress, &event);
+		if (nfds)
+			return nfds;
+	}
+
+	nfds = ofi_dynpoll_wait(&progress->epoll_fd, &event, 1, timeout);
+	if (xnet_busy_poll && nfds > 0)
+		xnet_busy_poll_event(progress, ofi_gettime_ns());
+	return nfds;
 }
 
 static void *xnet_auto_progress(void *arg)
@@ -1604,25 +2079,74 @@ static int xnet_init_uring(struct xnet_uring *uring, size_t entries,
 		return ret;
 
 	uring->fid.fclass = XNET_CLASS_URING;
+	uring->bufs = NULL;
+	uring->bufs_held = 0;
+	dlist_init(&uring->mshot_wait_list);
 	uring->sockapi = sockapi;
 	uring->sockapi->io_uring = &uring->ring;
 	uring->sockapi->credits = ofi_uring_sq_space_left(&uring->ring);
+	uring->sockapi->send_zc = ofi_uring_send_zc_supported(&uring->ring);
+
+	if (xnet_io_uring_fixed) {
+		ret = ofi_sockapi_uring_init_fixed(sockapi,
+						   XNET_URING_FIXED_CNT);
+		if (ret) {
+			FI_WARN(&xnet_prov, FI_LOG_EP_CTRL, "io_uring fixed "
+				"files unavailable (%s), disabling\n",
+				fi_strerror(-ret));
+		}
+	}
 
 	ret = ofi_dynpoll_add(dynpoll,
 			      ofi_uring_get_fd(&uring->ring),
 			      POLLIN, &uring->fid);
-	if (ret)
+	if (ret) {
+		ofi_sockapi_uring_cleanup_fixed(sockapi);
 		(void) ofi_uring_destroy(&uring->ring);
+	}
 
 	return ret;
 }
 
+static void xnet_init_uring_bufs(struct xnet_uring *uring)
+{
+	int ret;
+
+	if (xnet_prefetch_rbuf_size <= 0) {
+		FI_WARN(&xnet_prov, FI_LOG_EP_CTRL, "io_uring multishot "
+			"receives require a prefetch buffer, disabling\n");
+		return;
+	}
+
+	uring->bufs = calloc(XNET_URING_BUF_CNT, sizeof(*uring->bufs));
+	if (!uring->bufs)
+		return;
+
+	ret = ofi_uring_buf_ring_init(&uring->ring, &uring->buf_ring, 0,
+				      XNET_URING_BUF_CNT, XNET_URING_BUF_SIZE);
+	if (ret) {
+		FI_WARN(&xnet_prov, FI_LOG_EP_CTRL, "io_uring multishot "
+			"receives unavailable (%s), disabling\n",
+			fi_strerror(-ret));
+		free(uring->bufs);
+		uring->bufs = NULL;
+	}
+}
+
 static void xnet_destroy_uring(struct xnet_uring *uring,
 			       struct ofi_dynpoll *dynpoll)
 {
 	int ret;
 
 	assert(xnet_io_uring);
+	if (uring->bufs) {
+		assert(!uring->bufs_held);
+		assert(dlist_empty(&uring->mshot_wait_list));
+		ofi_uring_buf_ring_destroy(&uring->ring, &uring->buf_ring);
+		free(uring->bufs);
+		uring->bufs = NULL;
+	}
+	ofi_sockapi_uring_cleanup_fixed(uring->sockapi);
 	ofi_dynpoll_del(dynpoll, ofi_uring_get_fd(&uring->ring));
 	assert(ofi_uring_sq_ready(&uring->ring) == 0);
 	ret = ofi_uring_destroy(&uring->ring);
@@ -1632,12 +2156,47 @@ static void xnet_destroy_uring(struct xnet_uring *uring,
 	}
 }
 
+#ifdef EPIOCSPARAMS
+static void xnet_set_epoll_busy_poll(struct xnet_progress *progress)
+{
+	struct epoll_params params = {
+		.busy_poll_usecs = (uint32_t) xnet_busy_poll,
+		/* the kernel's default busy poll budget */
+		.busy_poll_budget = 8,
+		.prefer_busy_poll = 1,
+	};
+
+	assert(progress->epoll_fd.type == OFI_DYNPOLL_EPOLL);
+	if (ioctl(progress->epoll_fd.ep, EPIOCSPARAMS, &params)) {
+		FI_INFO(&xnet_prov, FI_LOG_DOMAIN,
+			"epoll busy poll unavailable (%s)\n",
+			strerror(errno));
+	}
+}
+#else
+static void xnet_set_epoll_busy_poll(struct xnet_progress *progress)
+{
+	OFI_UNUSED(progress);
+}
+#endif
+
 int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 {
+	struct ofi_bufpool_attr pool_attr = {
+		.size		= sizeof(struct xnet_xfer_entry) + xnet_buf_size,
+		.alignment	= 16,
+		.max_cnt	= 0,
+		.chunk_cnt	= 1024,
+		.context	= progress,
+	};
 	int ret;
 
 	progress->fid.fclass = XNET_CLASS_PROGRESS;
+	progress->shard = false;
 	progress->auto_progress = false;
+	progress->cq_batch = NULL;
+	progress->busy_poll_gap = 0;
+	progress->busy_poll_last = 0;
 	dlist_init(&progress->unexp_msg_list);
 	dlist_init(&progress->unexp_tag_list);
 	dlist_init(&progress->saved_tag_list);
@@ -1657,9 +2216,10 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 	if (ret)
 		goto err2;
 
-	ret = ofi_bufpool_create(&progress->xfer_pool,
-			sizeof(struct xnet_xfer_entry) + xnet_buf_size,
-			16, 0, 1024, 0);
+	if (xnet_busy_poll)
+		xnet_set_epoll_busy_poll(progress);
+
+	ret = ofi_bufpool_create_attr(&pool_attr, &progress->xfer_pool);
 	if (ret)
 		goto err3;
 
@@ -1690,6 +2250,9 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 				      &progress->epoll_fd);
 		if (ret)
 			goto err7;
+
+		if (xnet_io_uring_multishot)
+			xnet_init_uring_bufs(&progress->rx_uring);
 	} else {
 		progress->sockapi = xnet_sockapi_socket;
 	}
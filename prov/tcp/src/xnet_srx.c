@@ -246,6 +246,7 @@ xnet_match_saved(struct xnet_progress *progress, struct xnet_saved_msg *saved_ms
 				   rx_entry)) {
 			if (remove) {
 				slist_remove(&saved_msg->queue, item, prev);
+				dlist_remove(&saved_entry->match_entry);
 				if (!--saved_msg->cnt) {
 					assert(!dlist_empty(&saved_msg->entry));
 					dlist_remove_init(&saved_msg->entry);
@@ -278,25 +279,102 @@ xnet_search_saved(struct xnet_progress *progress,
 	return NULL;
 }
 
+static void
+xnet_remove_saved(struct xnet_srx *srx, struct xnet_xfer_entry *saved_entry)
+{
+	struct xnet_saved_msg *saved_msg;
+	struct slist_entry *item, *prev;
+
+	saved_msg = ofi_array_at(&srx->saved_msgs, saved_entry->src_addr);
+	assert(saved_msg && saved_msg->cnt);
+
+	/* The per peer queue is bounded by xnet_max_saved */
+	slist_foreach(&saved_msg->queue, item, prev) {
+		if (item == &saved_entry->entry) {
+			slist_remove(&saved_msg->queue, item, prev);
+			break;
+		}
+	}
+	dlist_remove(&saved_entry->match_entry);
+
+	if (!--saved_msg->cnt) {
+		assert(!dlist_empty(&saved_msg->entry));
+		dlist_remove_init(&saved_msg->entry);
+	}
+}
+
+static struct xnet_xfer_entry *
+xnet_match_saved_hash(struct xnet_srx *srx, struct xnet_xfer_entry *rx_entry,
+		      bool remove)
+{
+	struct xnet_xfer_entry *saved_entry;
+	struct dlist_entry *item;
+	bool directed;
+
+	assert(!rx_entry->ignore);
+	directed = (srx->match_tag_rx != xnet_match_tag) &&
+		   (rx_entry->src_addr != FI_ADDR_UNSPEC);
+
+	dlist_foreach(xnet_tag_bucket(&srx->saved_hash, rx_entry->tag), item) {
+		saved_entry = container_of(item, struct xnet_xfer_entry,
+					   match_entry);
+		if ((directed && saved_entry->src_addr != rx_entry->src_addr) ||
+		    !xnet_match_msg(saved_entry->context, &saved_entry->hdr,
+				    rx_entry))
+			continue;
+
+		if (remove)
+			xnet_remove_saved(srx, saved_entry);
+		return saved_entry;
+	}
+	return NULL;
+}
+
+static struct xnet_xfer_entry *
+xnet_find_saved(struct xnet_srx *srx, struct xnet_xfer_entry *rx_entry,
+		bool remove)
+{
+	struct xnet_progress *progress;
+	struct xnet_saved_msg *saved_msg;
+
+	progress = xnet_srx2_progress(srx);
+	assert(xnet_progress_locked(progress));
+
+	if (dlist_empty(&progress->saved_tag_list))
+		return NULL;
+
+	if (!rx_entry->ignore)
+		return xnet_match_saved_hash(srx, rx_entry, remove);
+
+	if ((srx->match_tag_rx == xnet_match_tag) ||
+	    (rx_entry->src_addr == FI_ADDR_UNSPEC))
+		return xnet_search_saved(progress, rx_entry, remove);
+
+	saved_msg = ofi_array_at(&srx->saved_msgs, rx_entry->src_addr);
+	if (!saved_msg || !saved_msg->cnt)
+		return NULL;
+
+	return xnet_match_saved(progress, saved_msg, rx_entry, remove);
+}
+
 static bool
 xnet_find_msg(struct xnet_srx *srx, struct xnet_xfer_entry *recv_entry,
 	      struct xnet_ep **ep, struct xnet_xfer_entry **saved_entry,
 	      bool remove)
 {
 	struct xnet_progress *progress;
-	struct xnet_saved_msg *saved_msg;
 	struct dlist_entry *entry;
 
 	progress = xnet_srx2_progress(srx);
 	assert(xnet_progress_locked(progress));
 
 	*ep = NULL;
+	*saved_entry = xnet_find_saved(srx, recv_entry, remove);
+	if (*saved_entry)
+		return true;
+
 	if ((srx->match_tag_rx == xnet_match_tag) ||
 	    (recv_entry->src_addr == FI_ADDR_UNSPEC)) {
-		*saved_entry = xnet_search_saved(progress, recv_entry, remove);
-		if (*saved_entry)
-			return true;
-
 		entry = dlist_find_first_match(&progress->unexp_tag_list,
 					       xnet_match_unexp, recv_entry);
 		if (!entry)
@@ -304,15 +382,6 @@ xnet_find_msg(struct xnet_srx *srx, struct xnet_xfer_entry *recv_entry,
 
 		*ep = container_of(entry, struct xnet_ep, unexp_entry);
 	} else {
-		*saved_entry = NULL;
-		saved_msg = ofi_array_at(&srx->saved_msgs, recv_entry->src_addr);
-		if (saved_msg && saved_msg->cnt) {
-			*saved_entry = xnet_match_saved(progress, saved_msg,
-							recv_entry, remove);
-			if (*saved_entry)
-				return true;
-		}
-
 		*ep = xnet_get_rx_ep(srx->rdm, recv_entry->src_addr);
 		if (!*ep)
 			return false;
@@ -440,7 +509,6 @@ static ssize_t
 xnet_srx_tag(struct xnet_srx *srx, struct xnet_xfer_entry *recv_entry)
 {
 	struct xnet_progress *progress;
-	struct xnet_saved_msg *saved_msg;
 	struct xnet_xfer_entry *saved_entry;
 	struct xnet_ep *ep;
 	struct slist *queue;
@@ -449,49 +517,43 @@ xnet_srx_tag(struct xnet_srx *srx, struct xnet_xfer_entry *recv_entry)
 	assert(xnet_progress_locked(progress));
 	assert(srx->rdm);
 
-	/* Always set and bump the tag_seq_no to help debugging */
+	/* The tag_seq_no orders hashed receives against the queued ones */
 	recv_entry->tag_seq_no = srx->tag_seq_no++;
 
+	saved_entry = xnet_find_saved(srx, recv_entry, true);
+	if (saved_entry) {
+		xnet_recv_saved(saved_entry, recv_entry);
+		return 0;
+	}
+
 	if ((srx->match_tag_rx == xnet_match_tag) ||
 	    (recv_entry->src_addr == FI_ADDR_UNSPEC)) {
-		saved_entry = xnet_search_saved(progress, recv_entry, true);
-		if (saved_entry) {
-			xnet_recv_saved(saved_entry, recv_entry);
-			return 0;
-		}
-
-		slist_insert_tail(&recv_entry->entry, &srx->tag_queue);
+		if (recv_entry->ignore)
+			slist_insert_tail(&recv_entry->entry, &srx->tag_queue);
+		else
+			dlist_insert_tail(&recv_entry->match_entry,
+				xnet_tag_bucket(&srx->tag_hash, recv_entry->tag));
 
 		/* The message could match any endpoint waiting. */
 		if (!dlist_empty(&progress->unexp_tag_list))
 			xnet_progress_unexp(progress, &progress->unexp_tag_list);
 	} else {
-		saved_msg = ofi_array_at(&srx->saved_msgs, recv_entry->src_addr);
-		if (saved_msg && saved_msg->cnt) {
-			saved_entry = xnet_match_saved(progress, saved_msg,
-						       recv_entry, true);
-			if (saved_entry) {
-				xnet_recv_saved(saved_entry, recv_entry);
-				return 0;
-			}
-		}
-
-		queue = ofi_array_at(&srx->src_tag_queues, recv_entry->src_addr);
-		if (!queue)
-			return -FI_EAGAIN;
+		if (recv_entry->ignore) {
+			queue = ofi_array_at(&srx->src_tag_queues,
+					     recv_entry->src_addr);
+			if (!queue)
+				return -FI_EAGAIN;
 
-		ep = xnet_get_rx_ep(srx->rdm, recv_entry->src_addr);
-		if (!ep) {
 			slist_insert_tail(&recv_entry->entry, queue);
-			return 0;
+		} else {
+			dlist_insert_tail(&recv_entry->match_entry,
+				xnet_tag_bucket(&srx->tag_hash, recv_entry->tag));
 		}
 
-		if (xnet_has_unexp(ep)) {
+		ep = xnet_get_rx_ep(srx->rdm, recv_entry->src_addr);
+		if (ep && xnet_has_unexp(ep)) {
 			assert(!dlist_empty(&ep->unexp_entry));
-			slist_insert_tail(&recv_entry->entry, queue);
 			xnet_progress_rx(ep);
-		} else {
-			slist_insert_tail(&recv_entry->entry, queue);
 		}
 	}
 
@@ -633,72 +695,109 @@ static struct fi_ops_tagged xnet_srx_tag_ops = {
 };
 
 static struct xnet_xfer_entry *
-xnet_match_tag(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
+xnet_match_tag_hash(struct xnet_srx *srx, fi_addr_t addr, uint64_t tag)
 {
 	struct xnet_xfer_entry *rx_entry;
-	struct slist_entry *item, *prev;
+	struct dlist_entry *item;
 
-	assert(xnet_progress_locked(xnet_srx2_progress(srx)));
-	slist_foreach(&srx->tag_queue, item, prev) {
-		rx_entry = container_of(item, struct xnet_xfer_entry, entry);
-		if (ofi_match_tag(rx_entry->tag, rx_entry->ignore, tag)) {
-			slist_remove(&srx->tag_queue, item, prev);
+	dlist_foreach(xnet_tag_bucket(&srx->tag_hash, tag), item) {
+		rx_entry = container_of(item, struct xnet_xfer_entry,
+					match_entry);
+		if (rx_entry->tag != tag)
+			continue;
+
+		if ((srx->match_tag_rx == xnet_match_tag) ||
+		    (rx_entry->src_addr == FI_ADDR_UNSPEC) ||
+		    (rx_entry->src_addr == addr))
 			return rx_entry;
-		}
 	}
 	return NULL;
 }
 
-/* A matching receive could be found on either the any source queue or the
- * source matched queue.  However, most apps going through this path will
- * use source matching, with the any source queue being empty.  We optimize
- * for this case.
+/* Find the first receive on the queue that matches the tag and was posted
+ * before the receive with sequence number seq.
+ */
+static struct slist_entry *
+xnet_find_tag(struct slist *queue, uint64_t tag, uint64_t seq,
+	      struct slist_entry **prev)
+{
+	struct xnet_xfer_entry *rx_entry;
+	struct slist_entry *item;
+
+	slist_foreach(queue, item, *prev) {
+		rx_entry = container_of(item, struct xnet_xfer_entry, entry);
+		if (rx_entry->tag_seq_no > seq)
+			break;
+
+		if (ofi_match_tag(rx_entry->tag, rx_entry->ignore, tag))
+			return item;
+	}
+	return NULL;
+}
+
+/* A matching receive could be found in the tag hash, the source matched
+ * queue, or the any source queue.  The hash is checked first, which
+ * bounds the walk of the queues, since those only hold receives with
+ * ignore bits.  The earliest posted match is selected.
  */
 static struct xnet_xfer_entry *
-xnet_match_tag_addr(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
+xnet_match_tag_queue(struct xnet_srx *srx, struct slist *queue,
+		     fi_addr_t addr, uint64_t tag)
 {
-	struct xnet_xfer_entry *rx_entry, *any_entry;
-	struct slist *queue;
+	struct xnet_xfer_entry *rx_entry;
+	struct slist_entry *item = NULL, *prev;
 	struct slist_entry *any_item, *any_prev;
-	struct slist_entry *item, *prev;
+	uint64_t seq;
 
 	assert(xnet_progress_locked(xnet_srx2_progress(srx)));
 
-	queue = (ep->peer && ep->peer->fi_addr != FI_ADDR_NOTAVAIL) ?
-		ofi_array_at(&srx->src_tag_queues, ep->peer->fi_addr) : NULL;
-	if (!queue)
-		return xnet_match_tag(srx, ep, tag);
+	rx_entry = xnet_match_tag_hash(srx, addr, tag);
+	seq = rx_entry ? rx_entry->tag_seq_no : UINT64_MAX;
 
-	slist_foreach(queue, item, prev) {
-		rx_entry = container_of(item, struct xnet_xfer_entry, entry);
-		if (ofi_match_tag(rx_entry->tag, rx_entry->ignore, tag))
-			goto found;
+	if (queue && !slist_empty(queue)) {
+		item = xnet_find_tag(queue, tag, seq, &prev);
+		if (item)
+			seq = container_of(item, struct xnet_xfer_entry,
+					   entry)->tag_seq_no;
 	}
 
-	return xnet_match_tag(srx, ep, tag);
-
-found:
-	/* We select from the any source queue if it matches and was posted
-	 * earlier than our source based match.
-	 */
-	slist_foreach(&srx->tag_queue, any_item, any_prev) {
-		any_entry = container_of(any_item, struct xnet_xfer_entry, entry);
-		if (any_entry->tag_seq_no > rx_entry->tag_seq_no)
-			break;
-
-		if (ofi_match_tag(any_entry->tag, any_entry->ignore, tag)) {
-			queue = &srx->tag_queue;
-			rx_entry = any_entry;
-			item = any_item;
-			prev = any_prev;
-			break;
+	if (!slist_empty(&srx->tag_queue)) {
+		any_item = xnet_find_tag(&srx->tag_queue, tag, seq, &any_prev);
+		if (any_item) {
+			slist_remove(&srx->tag_queue, any_item, any_prev);
+			return container_of(any_item, struct xnet_xfer_entry,
+					    entry);
 		}
 	}
 
-	slist_remove(queue, item, prev);
+	if (item) {
+		slist_remove(queue, item, prev);
+		return container_of(item, struct xnet_xfer_entry, entry);
+	}
+
+	if (rx_entry)
+		dlist_remove(&rx_entry->match_entry);
 	return rx_entry;
 }
 
+static struct xnet_xfer_entry *
+xnet_match_tag(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
+{
+	return xnet_match_tag_queue(srx, NULL, FI_ADDR_UNSPEC, tag);
+}
+
+static struct xnet_xfer_entry *
+xnet_match_tag_addr(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
+{
+	struct slist *queue;
+
+	if (!ep->peer || ep->peer->fi_addr == FI_ADDR_NOTAVAIL)
+		return xnet_match_tag_queue(srx, NULL, FI_ADDR_NOTAVAIL, tag);
+
+	queue = ofi_array_at(&srx->src_tag_queues, ep->peer->fi_addr);
+	return xnet_match_tag_queue(srx, queue, ep->peer->fi_addr, tag);
+}
+
 static bool
 xnet_srx_cancel_rx(struct xnet_srx *srx, struct slist *queue, void *context)
 {
@@ -719,6 +818,31 @@ xnet_srx_cancel_rx(struct xnet_srx *srx, struct slist *queue, void *context)
 	return false;
 }
 
+static bool
+xnet_srx_cancel_hash(struct xnet_srx *srx, void *context)
+{
+	struct xnet_xfer_entry *xfer_entry;
+	struct dlist_entry *item;
+	int i;
+
+	assert(xnet_progress_locked(xnet_srx2_progress(srx)));
+	for (i = 0; i < XNET_TAG_HASH_SIZE; i++) {
+		dlist_foreach(&srx->tag_hash.bucket[i], item) {
+			xfer_entry = container_of(item, struct xnet_xfer_entry,
+						  match_entry);
+			if (xfer_entry->context == context) {
+				dlist_remove(item);
+				xnet_report_error(xfer_entry, FI_ECANCELED);
+				xnet_free_xfer(xnet_srx2_progress(srx),
+					       xfer_entry);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 static int
 xnet_srx_cancel_src(struct ofi_dyn_arr *arr, void *list, void *context)
 {
@@ -736,6 +860,9 @@ static ssize_t xnet_srx_cancel(fid_t fid, void *context)
 	srx = container_of(fid, struct xnet_srx, rx_fid.fid);
 
 	ofi_genlock_lock(xnet_srx2_progress(srx)->active_lock);
+	if (xnet_srx_cancel_hash(srx, context))
+		goto unlock;
+
 	if (xnet_srx_cancel_rx(srx, &srx->tag_queue, context))
 		goto unlock;
 
@@ -808,6 +935,24 @@ static void xnet_srx_cleanup(struct xnet_srx *srx, struct slist *queue)
 	}
 }
 
+static void xnet_srx_cleanup_hash(struct xnet_srx *srx)
+{
+	struct xnet_xfer_entry *xfer_entry;
+	int i;
+
+	assert(xnet_progress_locked(xnet_srx2_progress(srx)));
+	for (i = 0; i < XNET_TAG_HASH_SIZE; i++) {
+		while (!dlist_empty(&srx->tag_hash.bucket[i])) {
+			dlist_pop_front(&srx->tag_hash.bucket[i],
+					struct xnet_xfer_entry, xfer_entry,
+					match_entry);
+			if (xfer_entry->cq)
+				xnet_report_error(xfer_entry, FI_ECANCELED);
+			xnet_free_xfer(xnet_srx2_progress(srx), xfer_entry);
+		}
+	}
+}
+
 static int
 xnet_srx_cleanup_queues(struct ofi_dyn_arr *arr, void *list, void *context)
 {
@@ -824,6 +969,13 @@ xnet_srx_cleanup_saved(struct ofi_dyn_arr *arr, void *item, void *context)
 {
 	struct xnet_srx *srx = context;
 	struct xnet_saved_msg *saved_msg = item;
+	struct xnet_xfer_entry *xfer_entry;
+	struct slist_entry *entry;
+
+	for (entry = saved_msg->queue.head; entry; entry = entry->next) {
+		xfer_entry = container_of(entry, struct xnet_xfer_entry, entry);
+		dlist_remove(&xfer_entry->match_entry);
+	}
 
 	dlist_remove_init(&saved_msg->entry);
 	xnet_srx_cleanup(srx, &saved_msg->queue);
@@ -841,6 +993,14 @@ xnet_init_saved_msg(struct ofi_dyn_arr *arr, void *item)
 	saved_msg->cnt = 0;
 }
 
+static void xnet_init_tag_hash(struct xnet_tag_hash *hash)
+{
+	int i;
+
+	for (i = 0; i < XNET_TAG_HASH_SIZE; i++)
+		dlist_init(&hash->bucket[i]);
+}
+
 static int xnet_srx_close(struct fid *fid)
 {
 	struct xnet_srx *srx;
@@ -850,6 +1010,7 @@ static int xnet_srx_close(struct fid *fid)
 	ofi_genlock_lock(xnet_srx2_progress(srx)->active_lock);
 	xnet_srx_cleanup(srx, &srx->rx_queue);
 	xnet_srx_cleanup(srx, &srx->tag_queue);
+	xnet_srx_cleanup_hash(srx);
 	ofi_array_iter(&srx->src_tag_queues, srx, xnet_srx_cleanup_queues);
 	ofi_array_iter(&srx->saved_msgs, srx, xnet_srx_cleanup_saved);
 	ofi_genlock_unlock(xnet_srx2_progress(srx)->active_lock);
@@ -892,6 +1053,8 @@ int xnet_srx_context(struct fid_domain *domain, struct fi_rx_attr *attr,
 	srx->rx_fid.tagged = &xnet_srx_tag_ops;
 	slist_init(&srx->rx_queue);
 	slist_init(&srx->tag_queue);
+	xnet_init_tag_hash(&srx->tag_hash);
+	xnet_init_tag_hash(&srx->saved_hash);
 	ofi_array_init(&srx->src_tag_queues, sizeof(struct slist), NULL);
 	ofi_array_init(&srx->saved_msgs, sizeof(struct xnet_saved_msg),
 		       xnet_init_saved_msg);
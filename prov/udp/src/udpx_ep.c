@@ -217,15 +217,8 @@ static struct fi_ops_ep udpx_ep_ops = {
 
 static void udpx_tx_comp(struct udpx_ep *ep, void *context)
 {
-	struct fi_cq_tagged_entry *comp;
-
-	comp = ofi_cirque_next(ep->util_ep.tx_cq->cirq);
-	comp->op_context = context;
-	comp->flags = FI_SEND;
-	comp->len = 0;
-	comp->buf = NULL;
-	comp->data = 0;
-	ofi_cirque_commit(ep->util_ep.tx_cq->cirq);
+	(void) ofi_cq_write_locked(ep->util_ep.tx_cq, context, FI_SEND, 0,
+				   NULL, 0, 0, FI_ADDR_NOTAVAIL);
 }
 
 static void udpx_tx_comp_signal(struct udpx_ep *ep, void *context)
@@ -237,23 +230,16 @@ static void udpx_tx_comp_signal(struct udpx_ep *ep, void *context)
 static void udpx_rx_comp(struct udpx_ep *ep, void *context, uint64_t flags,
 			 size_t len, void *buf, void *addr)
 {
-	struct fi_cq_tagged_entry *comp;
-
-	comp = ofi_cirque_next(ep->util_ep.rx_cq->cirq);
-	comp->op_context = context;
-	comp->flags = FI_RECV | flags;
-	comp->len = len;
-	comp->buf = buf;
-	comp->data = 0;
-	ofi_cirque_commit(ep->util_ep.rx_cq->cirq);
+	(void) ofi_cq_write_locked(ep->util_ep.rx_cq, context, FI_RECV | flags,
+				   len, buf, 0, 0, FI_ADDR_NOTAVAIL);
 }
 
 static void udpx_rx_src_comp(struct udpx_ep *ep, void *context, uint64_t flags,
 			     size_t len, void *buf, void *addr)
 {
-	ep->util_ep.rx_cq->src[ofi_cirque_windex(ep->util_ep.rx_cq->cirq)] =
-			ofi_ip_av_get_fi_addr(ep->util_ep.av, addr);
-	udpx_rx_comp(ep, context, flags, len, buf, addr);
+	(void) ofi_cq_write_locked(ep->util_ep.rx_cq, context, FI_RECV | flags,
+				   len, buf, 0, 0,
+				   ofi_ip_av_get_fi_addr(ep->util_ep.av, addr));
 }
 
 static void udpx_rx_comp_signal(struct udpx_ep *ep, void *context,
@@ -270,38 +256,209 @@ static void udpx_rx_src_comp_signal(struct udpx_ep *ep, void *context,
 	ep->util_ep.rx_cq->wait->signal(ep->util_ep.rx_cq->wait);
 }
 
-static void udpx_ep_progress(struct util_ep *util_ep)
+static struct udpx_ep_entry *udpx_rx_entry(struct udpx_ep *ep, size_t i)
+{
+	return &ep->rxq->buf[(ep->rxq->rcnt + i) & ep->rxq->size_mask];
+}
+
+#ifdef MSG_WAITFORONE
+static ssize_t udpx_recv_batch(struct udpx_ep *ep, size_t cnt,
+			       union ofi_sock_ip *addr, size_t *len)
+{
+	struct mmsghdr msgs[UDPX_BATCH_MAX];
+	struct udpx_ep_entry *entry;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < cnt; i++) {
+		entry = udpx_rx_entry(ep, i);
+		msgs[i].msg_hdr.msg_name = &addr[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addr[i]);
+		msgs[i].msg_hdr.msg_iov = entry->iov;
+		msgs[i].msg_hdr.msg_iovlen = entry->iov_count;
+		msgs[i].msg_hdr.msg_control = NULL;
+		msgs[i].msg_hdr.msg_controllen = 0;
+		msgs[i].msg_hdr.msg_flags = 0;
+	}
+
+	ret = recvmmsg(ep->sock, msgs, (unsigned int) cnt, 0, NULL);
+	for (i = 0; ret > 0 && i < (size_t) ret; i++)
+		len[i] = msgs[i].msg_len;
+	return ret;
+}
+#else
+static ssize_t udpx_recv_batch(struct udpx_ep *ep, size_t cnt,
+			       union ofi_sock_ip *addr, size_t *len)
 {
-	struct udpx_ep *ep;
 	struct udpx_ep_entry *entry;
 	struct msghdr hdr;
-	struct sockaddr_in6 addr;
-	ssize_t ret;
+	ssize_t ret = 0;
+	size_t i;
 
-	ep = container_of(util_ep, struct udpx_ep, util_ep);
-	hdr.msg_name = &addr;
-	hdr.msg_namelen = sizeof(addr);
 	hdr.msg_control = NULL;
 	hdr.msg_controllen = 0;
 	hdr.msg_flags = 0;
 
+	for (i = 0; i < cnt; i++) {
+		entry = udpx_rx_entry(ep, i);
+		hdr.msg_name = &addr[i];
+		hdr.msg_namelen = sizeof(addr[i]);
+		hdr.msg_iov = entry->iov;
+		hdr.msg_iovlen = entry->iov_count;
+
+		ret = ofi_recvmsg_udp(ep->sock, &hdr, 0);
+		if (ret < 0)
+			break;
+		len[i] = ret;
+	}
+	return i ? i : ret;
+}
+#endif
+
+static void udpx_ep_progress_rx(struct udpx_ep *ep)
+{
+	union ofi_sock_ip addr[UDPX_BATCH_MAX];
+	size_t len[UDPX_BATCH_MAX];
+	struct udpx_ep_entry *entry;
+	size_t cnt, i;
+	ssize_t ret;
+
 	ofi_genlock_lock(&ep->util_ep.rx_cq->cq_lock);
-	if (ofi_cirque_isempty(ep->rxq))
+	cnt = ofi_cq_freecnt(ep->util_ep.rx_cq);
+	/* leave room for the completions of queued sends */
+	if (ep->util_ep.rx_cq == ep->util_ep.tx_cq)
+		cnt = cnt > ep->txq_cnt ? cnt - ep->txq_cnt : 0;
+	cnt = MIN(cnt, ofi_cirque_usedcnt(ep->rxq));
+	cnt = MIN(cnt, (size_t) udpx_rx_batch);
+	if (!cnt)
 		goto out;
 
-	entry = ofi_cirque_head(ep->rxq);
-	hdr.msg_iov = entry->iov;
-	hdr.msg_iovlen = entry->iov_count;
-
-	ret = ofi_recvmsg_udp(ep->sock, &hdr, 0);
-	if (ret >= 0) {
-		ep->rx_comp(ep, entry->context, 0, ret, NULL, &addr);
+	ret = udpx_recv_batch(ep, cnt, addr, len);
+	for (i = 0; ret > 0 && i < (size_t) ret; i++) {
+		entry = ofi_cirque_head(ep->rxq);
+		ep->rx_comp(ep, entry->context, 0, len[i], NULL, &addr[i]);
 		ofi_cirque_discard(ep->rxq);
 	}
 out:
 	ofi_genlock_unlock(&ep->util_ep.rx_cq->cq_lock);
 }
 
+static void udpx_tx_err(struct udpx_ep *ep, void *context, int err)
+{
+	struct fi_cq_err_entry err_entry;
+
+	memset(&err_entry, 0, sizeof(err_entry));
+	err_entry.op_context = context;
+	err_entry.flags = FI_SEND;
+	err_entry.err = err;
+	err_entry.prov_errno = err;
+	if (ofi_cq_write_error(ep->util_ep.tx_cq, &err_entry))
+		FI_WARN(&udpx_prov, FI_LOG_EP_DATA,
+			"unable to report send error\n");
+}
+
+#ifdef MSG_WAITFORONE
+static ssize_t udpx_send_batch(struct udpx_ep *ep, size_t cnt)
+{
+	struct mmsghdr msgs[UDPX_BATCH_MAX];
+	size_t i;
+
+	for (i = 0; i < cnt; i++) {
+		msgs[i].msg_hdr.msg_name = &ep->txq[i].addr;
+		msgs[i].msg_hdr.msg_namelen = ep->txq[i].addrlen;
+		msgs[i].msg_hdr.msg_iov = ep->txq[i].iov;
+		msgs[i].msg_hdr.msg_iovlen = ep->txq[i].iov_count;
+		msgs[i].msg_hdr.msg_control = NULL;
+		msgs[i].msg_hdr.msg_controllen = 0;
+		msgs[i].msg_hdr.msg_flags = 0;
+	}
+
+	return sendmmsg(ep->sock, msgs, (unsigned int) cnt, 0);
+}
+#else
+static ssize_t udpx_send_batch(struct udpx_ep *ep, size_t cnt)
+{
+	struct msghdr hdr;
+	ssize_t ret = 0;
+	size_t i;
+
+	hdr.msg_control = NULL;
+	hdr.msg_controllen = 0;
+	hdr.msg_flags = 0;
+
+	for (i = 0; i < cnt; i++) {
+		hdr.msg_name = &ep->txq[i].addr;
+		hdr.msg_namelen = ep->txq[i].addrlen;
+		hdr.msg_iov = ep->txq[i].iov;
+		hdr.msg_iovlen = ep->txq[i].iov_count;
+
+		ret = ofi_sendmsg_udp(ep->sock, &hdr, 0);
+		if (ret < 0)
+			break;
+	}
+	return i ? i : ret;
+}
+#endif
+
+/*
+ * Push queued sends to the socket.  Sends that could not be written because
+ * the socket buffer or the CQ is full stay queued; any other failure is
+ * reported to the CQ for the first unsent entry.  Caller holds the tx_cq
+ * lock, which is dropped while reporting an error.
+ */
+static void udpx_ep_flush(struct udpx_ep *ep)
+{
+	struct util_cq *cq = ep->util_ep.tx_cq;
+	void *context;
+	ssize_t ret;
+	size_t cnt, i;
+	int err;
+
+	while (ep->txq_cnt) {
+		cnt = MIN(ep->txq_cnt, ofi_cq_freecnt(cq));
+		if (!cnt)
+			return;
+
+		ret = udpx_send_batch(ep, cnt);
+		if (ret > 0) {
+			cnt = (size_t) ret;
+		} else if (OFI_SOCK_TRY_SND_RCV_AGAIN(ofi_sockerr())) {
+			return;
+		} else {
+			err = ofi_sockerr();
+			context = ep->txq[0].context;
+			ep->txq_cnt--;
+			memmove(&ep->txq[0], &ep->txq[1],
+				ep->txq_cnt * sizeof(ep->txq[0]));
+			ofi_genlock_unlock(&cq->cq_lock);
+			udpx_tx_err(ep, context, err);
+			ofi_genlock_lock(&cq->cq_lock);
+			continue;
+		}
+
+		for (i = 0; i < cnt; i++)
+			ep->tx_comp(ep, ep->txq[i].context);
+		ep->txq_cnt -= cnt;
+		memmove(&ep->txq[0], &ep->txq[cnt],
+			ep->txq_cnt * sizeof(ep->txq[0]));
+	}
+}
+
+static void udpx_ep_progress(struct util_ep *util_ep)
+{
+	struct udpx_ep *ep;
+
+	ep = container_of(util_ep, struct udpx_ep, util_ep);
+	if (ep->util_ep.rx_cq)
+		udpx_ep_progress_rx(ep);
+
+	if (ep->util_ep.tx_cq) {
+		ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
+		udpx_ep_flush(ep);
+		ofi_genlock_unlock(&ep->util_ep.tx_cq->cq_lock);
+	}
+}
+
 static ssize_t udpx_recvmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 			    uint64_t flags)
 {
@@ -393,11 +550,19 @@ static ssize_t udpx_sendto(struct udpx_ep *ep, const void *buf, size_t len,
 	ssize_t ret;
 
 	ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
-	if (ofi_cirque_isfull(ep->util_ep.tx_cq->cirq)) {
+	if (ofi_cq_isfull(ep->util_ep.tx_cq)) {
 		ret = -FI_EAGAIN;
 		goto out;
 	}
 
+	if (ep->txq_cnt) {
+		udpx_ep_flush(ep);
+		if (ep->txq_cnt) {
+			ret = -FI_EAGAIN;
+			goto out;
+		}
+	}
+
 	ret = ofi_sendto_socket(ep->sock, buf, len, 0,
 				addr, (socklen_t)addrlen);
 	if (ret == (ssize_t)len) {
@@ -432,6 +597,33 @@ static ssize_t udpx_send_mc(struct fid_ep *ep_fid, const void *buf, size_t len,
 			   context);
 }
 
+static ssize_t udpx_queue_send(struct udpx_ep *ep, const struct fi_msg *msg,
+			       const void *addr, size_t addrlen, uint64_t flags)
+{
+	struct udpx_tx_entry *entry;
+
+	if (msg->iov_count > UDPX_IOV_LIMIT ||
+	    addrlen > sizeof(entry->addr))
+		return -FI_EINVAL;
+
+	if (ep->txq_cnt == UDPX_BATCH_MAX) {
+		udpx_ep_flush(ep);
+		if (ep->txq_cnt == UDPX_BATCH_MAX)
+			return -FI_EAGAIN;
+	}
+
+	entry = &ep->txq[ep->txq_cnt++];
+	entry->context = msg->context;
+	entry->iov_count = msg->iov_count;
+	memcpy(entry->iov, msg->msg_iov, msg->iov_count * sizeof(*msg->msg_iov));
+	memcpy(&entry->addr, addr, addrlen);
+	entry->addrlen = (socklen_t) addrlen;
+
+	if (!(flags & FI_MORE) || ep->txq_cnt == UDPX_BATCH_MAX)
+		udpx_ep_flush(ep);
+	return 0;
+}
+
 static ssize_t udpx_sendmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 			    uint64_t flags)
 {
@@ -449,11 +641,26 @@ static ssize_t udpx_sendmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 	hdr.msg_flags = 0;
 
 	ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
-	if (ofi_cirque_isfull(ep->util_ep.tx_cq->cirq)) {
+	if (ofi_cq_freecnt(ep->util_ep.tx_cq) <= ep->txq_cnt) {
 		ret = -FI_EAGAIN;
 		goto out;
 	}
 
+	/* Injected data may be reused on return, so it is never queued */
+	if (flags & FI_INJECT) {
+		if (ep->txq_cnt)
+			udpx_ep_flush(ep);
+		if (ep->txq_cnt ||
+		    !ofi_cq_freecnt(ep->util_ep.tx_cq)) {
+			ret = -FI_EAGAIN;
+			goto out;
+		}
+	} else if ((flags & FI_MORE) || ep->txq_cnt) {
+		ret = udpx_queue_send(ep, msg, hdr.msg_name, hdr.msg_namelen,
+				      flags);
+		goto out;
+	}
+
 	ret = ofi_sendmsg_udp(ep->sock, &hdr, 0);
 	if (ret >= 0) {
 		ep->tx_comp(ep, msg->context);
@@ -550,6 +757,7 @@ static int udpx_ep_close(struct fid *fid)
 {
 	struct udpx_ep *ep;
 	struct util_wait_fd *wait;
+	size_t i;
 
 	ep = container_of(fid, struct udpx_ep, util_ep.ep_fid.fid);
 	if (ofi_atomic_get32(&ep->ref)) {
@@ -568,6 +776,17 @@ static int udpx_ep_close(struct fid *fid)
 				&ep->util_ep.ep_fid.fid);
 	}
 
+	if (ep->util_ep.tx_cq) {
+		ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
+		udpx_ep_flush(ep);
+		ofi_genlock_unlock(&ep->util_ep.tx_cq->cq_lock);
+
+		/* Sends the socket did not accept can no longer complete */
+		for (i = 0; i < ep->txq_cnt; i++)
+			udpx_tx_err(ep, ep->txq[i].context, FI_ECANCELED);
+		ep->txq_cnt = 0;
+	}
+
 	udpx_rx_cirq_free(ep->rxq);
 	ofi_close_socket(ep->sock);
 	ofi_endpoint_close(&ep->util_ep);
@@ -590,6 +809,12 @@ static int udpx_ep_bind_cq(struct udpx_ep *ep, struct util_cq *cq,
 		ofi_atomic_inc32(&cq->ref);
 		ep->tx_comp = cq->wait ? udpx_tx_comp_signal :
 					 udpx_tx_comp;
+
+		/* progress the tx cq to flush sends queued with FI_MORE */
+		ret = fid_list_insert(&cq->ep_list, &cq->ep_list_lock,
+				      &ep->util_ep.ep_fid.fid);
+		if (ret)
+			return ret;
 	}
 
 	if (flags & FI_RECV) {
@@ -38,6 +38,8 @@
 #include <sys/types.h>
 
 
+int udpx_rx_batch = 16;
+
 static int udpx_getinfo(uint32_t version, const char *node, const char *service,
 			uint64_t flags, const struct fi_info *hints,
 			struct fi_info **info)
@@ -64,6 +66,17 @@ UDP_INI
 {
 	fi_param_define(&udpx_prov, "iface", FI_PARAM_STRING,
 			"Specify interface name");
+	fi_param_define(&udpx_prov, "rx_batch", FI_PARAM_INT,
+			"Maximum number of posted receives completed by a "
+			"single progress call.  Datagrams are read using "
+			"recvmmsg where available (default: %d, max: %d)",
+			udpx_rx_batch, UDPX_BATCH_MAX);
+
+	fi_param_get_int(&udpx_prov, "rx_batch", &udpx_rx_batch);
+	if (udpx_rx_batch < 1)
+		udpx_rx_batch = 1;
+	else if (udpx_rx_batch > UDPX_BATCH_MAX)
+		udpx_rx_batch = UDPX_BATCH_MAX;
 
 	return &udpx_prov;
 }
@@ -1085,6 +1085,153 @@ static void ofi_log_atomic_info(const struct fi_provider *prov)
 
 #endif /* HAVE_BUILTIN_MM_ATOMICS */
 
+/*****************************
+ * Vectorized reduction kernels
+ *****************************/
+
+/*
+ * Non-atomic versions of the arithmetic and bitwise write handlers for
+ * buffers that no other thread updates, such as collective reduction
+ * buffers.  They are written with compiler vector extensions, built once
+ * per ISA and selected by ofi_atomic_init().  Each element is combined the
+ * same way the scalar handlers do it, so results are bit-identical,
+ * including NaN and signed zero handling for MIN and MAX.
+ */
+#define OFI_VEC_SELECT(mask, a, b)					\
+	((__typeof__(a)) (((__typeof__(mask)) (a) & (mask)) |		\
+			  ((__typeof__(mask)) (b) & ~(mask))))
+
+#define OFI_VEC_MIN(d, s)	OFI_VEC_SELECT((s) < (d), s, d)
+#define OFI_VEC_MAX(d, s)	OFI_VEC_SELECT((s) > (d), s, d)
+#define OFI_VEC_SUM(d, s)	((d) + (s))
+#define OFI_VEC_PROD(d, s)	((d) * (s))
+#define OFI_VEC_BOR(d, s)	((d) | (s))
+#define OFI_VEC_BAND(d, s)	((d) & (s))
+#define OFI_VEC_BXOR(d, s)	((d) ^ (s))
+
+#define OFI_SCALAR_MIN(d, s)	((s) < (d) ? (s) : (d))
+#define OFI_SCALAR_MAX(d, s)	((s) > (d) ? (s) : (d))
+#define OFI_SCALAR_SUM		OFI_VEC_SUM
+#define OFI_SCALAR_PROD		OFI_VEC_PROD
+#define OFI_SCALAR_BOR		OFI_VEC_BOR
+#define OFI_SCALAR_BAND		OFI_VEC_BAND
+#define OFI_SCALAR_BXOR		OFI_VEC_BXOR
+
+#define OFI_VEC_FUNC_NAME(isa, op, type) ofi_vec_## isa ##_## op ##_## type
+
+#define OFI_DEF_VEC_FUNC(isa, op, type)					\
+	static OFI_VEC_ATTR_## isa void					\
+	OFI_VEC_FUNC_NAME(isa, op, type)(void *dst, const void *src,	\
+					 size_t cnt)			\
+	{								\
+		typedef type vec_t					\
+			__attribute__((vector_size(OFI_VEC_LEN_## isa)));\
+		type *d = dst;						\
+		const type *s = src;					\
+		vec_t vd, vs;						\
+		size_t i, n = sizeof(vec_t) / sizeof(type);		\
+									\
+		for (i = 0; i + n <= cnt; i += n) {			\
+			memcpy(&vd, &d[i], sizeof(vd));			\
+			memcpy(&vs, &s[i], sizeof(vs));			\
+			vd = OFI_VEC_## op(vd, vs);			\
+			memcpy(&d[i], &vd, sizeof(vd));			\
+		}							\
+		for (; i < cnt; i++)					\
+			d[i] = OFI_SCALAR_## op(d[i], s[i]);		\
+	}
+
+#define OFI_DEF_VEC_INT_FUNCS(isa, op)					\
+	OFI_DEF_VEC_FUNC(isa, op, int8_t)				\
+	OFI_DEF_VEC_FUNC(isa, op, uint8_t)				\
+	OFI_DEF_VEC_FUNC(isa, op, int16_t)				\
+	OFI_DEF_VEC_FUNC(isa, op, uint16_t)				\
+	OFI_DEF_VEC_FUNC(isa, op, int32_t)				\
+	OFI_DEF_VEC_FUNC(isa, op, uint32_t)				\
+	OFI_DEF_VEC_FUNC(isa, op, int64_t)				\
+	OFI_DEF_VEC_FUNC(isa, op, uint64_t)
+
+#define OFI_DEF_VEC_ALL_FUNCS(isa, op)					\
+	OFI_DEF_VEC_INT_FUNCS(isa, op)					\
+	OFI_DEF_VEC_FUNC(isa, op, float)				\
+	OFI_DEF_VEC_FUNC(isa, op, double)
+
+#define OFI_VEC_INT_NAMES(isa, op)					\
+	[FI_INT8] = OFI_VEC_FUNC_NAME(isa, op, int8_t),			\
+	[FI_UINT8] = OFI_VEC_FUNC_NAME(isa, op, uint8_t),		\
+	[FI_INT16] = OFI_VEC_FUNC_NAME(isa, op, int16_t),		\
+	[FI_UINT16] = OFI_VEC_FUNC_NAME(isa, op, uint16_t),		\
+	[FI_INT32] = OFI_VEC_FUNC_NAME(isa, op, int32_t),		\
+	[FI_UINT32] = OFI_VEC_FUNC_NAME(isa, op, uint32_t),		\
+	[FI_INT64] = OFI_VEC_FUNC_NAME(isa, op, int64_t),		\
+	[FI_UINT64] = OFI_VEC_FUNC_NAME(isa, op, uint64_t),
+
+#define OFI_VEC_ALL_NAMES(isa, op)					\
+	OFI_VEC_INT_NAMES(isa, op)					\
+	[FI_FLOAT] = OFI_VEC_FUNC_NAME(isa, op, float),			\
+	[FI_DOUBLE] = OFI_VEC_FUNC_NAME(isa, op, double),
+
+#define OFI_DEF_VEC_HANDLERS(isa)					\
+	OFI_DEF_VEC_ALL_FUNCS(isa, MIN)					\
+	OFI_DEF_VEC_ALL_FUNCS(isa, MAX)					\
+	OFI_DEF_VEC_ALL_FUNCS(isa, SUM)					\
+	OFI_DEF_VEC_ALL_FUNCS(isa, PROD)				\
+	OFI_DEF_VEC_INT_FUNCS(isa, BOR)					\
+	OFI_DEF_VEC_INT_FUNCS(isa, BAND)				\
+	OFI_DEF_VEC_INT_FUNCS(isa, BXOR)				\
+									\
+	static void (*ofi_vec_## isa ##_handlers			\
+		[OFI_WRITE_OP_CNT][OFI_DATATYPE_CNT])			\
+		(void *dst, const void *src, size_t cnt) =		\
+	{								\
+		[FI_MIN] = { OFI_VEC_ALL_NAMES(isa, MIN) },		\
+		[FI_MAX] = { OFI_VEC_ALL_NAMES(isa, MAX) },		\
+		[FI_SUM] = { OFI_VEC_ALL_NAMES(isa, SUM) },		\
+		[FI_PROD] = { OFI_VEC_ALL_NAMES(isa, PROD) },		\
+		[FI_BOR] = { OFI_VEC_INT_NAMES(isa, BOR) },		\
+		[FI_BAND] = { OFI_VEC_INT_NAMES(isa, BAND) },		\
+		[FI_BXOR] = { OFI_VEC_INT_NAMES(isa, BXOR) },		\
+	};
+
+/* 16 bytes is SSE2 on x86_64 and NEON on aarch64 */
+#define OFI_VEC_ATTR_base
+#define OFI_VEC_LEN_base	16
+OFI_DEF_VEC_HANDLERS(base)
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define OFI_VEC_ATTR_avx2	__attribute__((target("avx2")))
+#define OFI_VEC_LEN_avx2	32
+OFI_DEF_VEC_HANDLERS(avx2)
+
+#define OFI_VEC_ATTR_avx512	__attribute__((target("avx512f")))
+#define OFI_VEC_LEN_avx512	64
+OFI_DEF_VEC_HANDLERS(avx512)
+#endif
+
+void (*ofi_atomic_reduce_handlers[OFI_WRITE_OP_CNT][OFI_DATATYPE_CNT])
+	(void *dst, const void *src, size_t cnt);
+
+void ofi_atomic_init(void)
+{
+	void (*(*vec)[OFI_DATATYPE_CNT])(void *, const void *, size_t);
+	int op, dt;
+
+	vec = ofi_vec_base_handlers;
+#if defined(__x86_64__) && defined(__GNUC__)
+	if (ofi_cpu_has_avx512())
+		vec = ofi_vec_avx512_handlers;
+	else if (ofi_cpu_has_avx2())
+		vec = ofi_vec_avx2_handlers;
+#endif
+
+	for (op = 0; op < OFI_WRITE_OP_CNT; op++) {
+		for (dt = 0; dt < OFI_DATATYPE_CNT; dt++) {
+			ofi_atomic_reduce_handlers[op][dt] = vec[op][dt] ?
+				vec[op][dt] : ofi_atomic_write_handlers[op][dt];
+		}
+	}
+}
+
 int ofi_atomic_valid(const struct fi_provider *prov,
 		     enum fi_datatype datatype, enum fi_op op, uint64_t flags)
 {
@@ -81,6 +81,47 @@ int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
 	return 0;
 }
 
+/* Move completions staged by lock-free writers into the cirq.  Writers
+ * that have reserved a slot but not yet committed it are waited on, so
+ * that every completion written before the caller acquired the CQ lock
+ * is ordered ahead of anything the caller writes.
+ */
+void ofi_cq_drain_mpsc(struct util_cq *cq)
+{
+	struct util_cq_mpsc_entry *entry;
+	int64_t pos, end;
+	int ret;
+
+	assert(ofi_genlock_held(&cq->cq_lock));
+	end = ofi_atomic_load_explicit64(&cq->mpscq->write_pos,
+					 memory_order_acquire);
+	while (ofi_atomic_load_explicit64(&cq->mpscq->read_pos,
+					  memory_order_relaxed) < end) {
+		if (util_cq_mpscq_head(cq->mpscq, &entry, &pos))
+			continue;
+
+		if (ofi_cirque_freecnt(cq->cirq) > 1) {
+			if (cq->src)
+				cq->src[ofi_cirque_windex(cq->cirq)] =
+					entry->src;
+			*ofi_cirque_next(cq->cirq) = entry->comp;
+			ofi_cirque_commit(cq->cirq);
+		} else {
+			ret = ofi_cq_write_overflow(cq, entry->comp.op_context,
+						    entry->comp.flags,
+						    entry->comp.len,
+						    entry->comp.buf,
+						    entry->comp.data,
+						    entry->comp.tag, entry->src);
+			if (ret) {
+				FI_WARN(cq->domain->prov, FI_LOG_CQ,
+					"unable to queue completion, dropped\n");
+			}
+		}
+		util_cq_mpscq_release(cq->mpscq, entry, pos);
+	}
+}
+
 static int util_cq_insert_error(struct util_cq *cq,
 				const struct fi_cq_err_entry *err_entry)
 {
@@ -88,6 +129,7 @@ static int util_cq_insert_error(struct util_cq *cq,
 
 	assert(ofi_genlock_held(&cq->cq_lock));
 	assert(err_entry->err);
+	ofi_cq_drain(cq);
 	entry = calloc(1, sizeof(*entry));
 	if (!entry)
 		return -FI_ENOMEM;
@@ -173,6 +215,41 @@ int ofi_peer_cq_write_error_trunc(struct util_cq *cq, void *context,
 }
 
 
+ssize_t ofi_cq_write_batch(struct util_cq *cq,
+			   const struct fi_cq_tagged_entry *comp,
+			   const fi_addr_t *src, size_t count)
+{
+	fi_addr_t addr;
+	size_t i;
+	int ret = 0;
+
+	ofi_genlock_lock(&cq->cq_lock);
+	ofi_cq_drain(cq);
+	for (i = 0; i < count; i++) {
+		addr = src ? src[i] : FI_ADDR_NOTAVAIL;
+		if (ofi_cirque_freecnt(cq->cirq) > 1) {
+			if (cq->src)
+				cq->src[ofi_cirque_windex(cq->cirq)] = addr;
+			ofi_cq_write_entry(cq, comp[i].op_context,
+					   comp[i].flags, comp[i].len,
+					   comp[i].buf, comp[i].data,
+					   comp[i].tag);
+		} else {
+			ret = ofi_cq_write_overflow(cq, comp[i].op_context,
+						    comp[i].flags, comp[i].len,
+						    comp[i].buf, comp[i].data,
+						    comp[i].tag, addr);
+			if (ret)
+				break;
+		}
+	}
+	ofi_genlock_unlock(&cq->cq_lock);
+
+	if (cq->wait)
+		cq->wait->signal(cq->wait);
+	return ret;
+}
+
 int ofi_check_cq_attr(const struct fi_provider *prov,
 		      const struct fi_cq_attr *attr)
 {
@@ -278,6 +355,7 @@ ssize_t ofi_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 	api_version = cq->domain->fabric->fabric_fid.api_version;
 
 	ofi_genlock_lock(&cq->cq_lock);
+	ofi_cq_drain(cq);
 	if (ofi_cirque_isempty(cq->cirq) ||
 	    !(ofi_cirque_head(cq->cirq)->flags & UTIL_FLAG_AUX)) {
 		ret = -FI_EAGAIN;
@@ -401,6 +479,8 @@ static void util_peer_cq_cleanup(struct util_cq *cq)
 	}
 
 	util_comp_cirq_free(cq->cirq);
+	if (cq->mpscq)
+		util_cq_mpscq_free(cq->mpscq);
 	free(cq->src);
 	fi_close(&cq->peer_cq->fid);
 }
@@ -510,7 +590,15 @@ static ssize_t util_peer_cq_write(struct fid_peer_cq *cq, void *context,
 
 	util_cq = cq->fid.context;
 
+	if (util_cq->mpscq &&
+	    !ofi_cq_write_mpsc(util_cq, context, flags, len, buf, data, tag,
+			       FI_ADDR_NOTAVAIL)) {
+		ret = 0;
+		goto signal;
+	}
+
 	ofi_genlock_lock(&util_cq->cq_lock);
+	ofi_cq_drain(util_cq);
 	if (ofi_cirque_freecnt(util_cq->cirq) > 1) {
 		ofi_cq_write_entry(util_cq, context, flags, len, buf, data,
 				     tag);
@@ -521,6 +609,7 @@ static ssize_t util_peer_cq_write(struct fid_peer_cq *cq, void *context,
 	}
 	ofi_genlock_unlock(&util_cq->cq_lock);
 
+signal:
 	if (util_cq->wait)
 		util_cq->wait->signal(util_cq->wait);
 
@@ -534,7 +623,15 @@ static ssize_t util_peer_cq_write_src(struct fid_peer_cq *cq, void *context,
 	struct util_cq *util_cq = cq->fid.context;
 	int ret;
 
+	if (util_cq->mpscq &&
+	    !ofi_cq_write_mpsc(util_cq, context, flags, len, buf, data, tag,
+			       src)) {
+		ret = 0;
+		goto signal;
+	}
+
 	ofi_genlock_lock(&util_cq->cq_lock);
+	ofi_cq_drain(util_cq);
 	if (ofi_cirque_freecnt(util_cq->cirq) > 1) {
 		ofi_cq_write_src_entry(util_cq, context, flags, len, buf, data,
 				       tag, src);
@@ -545,6 +642,7 @@ static ssize_t util_peer_cq_write_src(struct fid_peer_cq *cq, void *context,
 	}
 	ofi_genlock_unlock(&util_cq->cq_lock);
 
+signal:
 	if (util_cq->wait)
 		util_cq->wait->signal(util_cq->wait);
 
@@ -567,16 +665,25 @@ static ssize_t util_peer_cq_writeerr(struct fid_peer_cq *cq,
 	return ret;
 }
 
+static ssize_t util_peer_cq_writebatch(struct fid_peer_cq *cq,
+				       const struct fi_cq_tagged_entry *comp,
+				       const fi_addr_t *src, size_t count)
+{
+	return ofi_cq_write_batch(cq->fid.context, comp, src, count);
+}
+
 static struct fi_ops_cq_owner util_peer_cq_owner_ops = {
 	.size = sizeof(struct fi_ops_cq_owner),
 	.write = &util_peer_cq_write,
 	.writeerr = &util_peer_cq_writeerr,
+	.writebatch = &util_peer_cq_writebatch,
 };
 
 static struct fi_ops_cq_owner util_peer_cq_src_owner_ops = {
 	.size = sizeof(struct fi_ops_cq_owner),
 	.write = &util_peer_cq_write_src,
 	.writeerr = &util_peer_cq_writeerr,
+	.writebatch = &util_peer_cq_writebatch,
 };
 
 /* For peer cq, just do progress */
@@ -652,9 +759,20 @@ static int util_init_peer_cq(struct util_cq *cq, struct fi_cq_attr *attr)
 		goto free;
 	}
 
+	if (cq->domain->threading == FI_THREAD_SAFE) {
+		cq->mpscq = util_cq_mpscq_create(cq->cirq->size);
+		if (!cq->mpscq) {
+			util_comp_cirq_free(cq->cirq);
+			ret = -FI_ENOMEM;
+			goto free;
+		}
+	}
+
 	if (cq->domain->info_domain_caps & FI_SOURCE) {
 		cq->src = calloc(cq->cirq->size, sizeof(*cq->src));
 		if (!cq->src) {
+			if (cq->mpscq)
+				util_cq_mpscq_free(cq->mpscq);
 			util_comp_cirq_free(cq->cirq);
 			ret = -FI_ENOMEM;
 			goto free;
@@ -691,6 +809,7 @@ int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
 	cq->cq_fid.fid.ops = &util_cq_fi_ops;
 	cq->cq_fid.ops = &util_cq_ops;
 	cq->progress = progress;
+	cq->mpscq = NULL;
 
 	cq->domain = container_of(domain, struct util_domain, domain_fid);
 	ofi_atomic_initialize32(&cq->ref, 0);
@@ -190,6 +190,24 @@ void ofi_monitors_init(void)
 			" reduce the number of registered regions, regardless"
 			" of their size, stored in the cache.  Setting this"
 			" to zero will disable MR caching.  (default: 1024)");
+	fi_param_define(NULL, "mr_cache_shards", FI_PARAM_SIZE_T,
+			"Number of independently locked partitions of each"
+			" MR cache.  Regions are assigned to a partition by"
+			" address, allowing threads registering different"
+			" buffers to search the cache concurrently.  The cache"
+			" size limits are divided evenly between partitions."
+			" (default: 1, max: 64)");
+	fi_param_define(NULL, "mr_cache_reclaim", FI_PARAM_BOOL,
+			"Use a background thread per MR cache to deregister"
+			" unused regions and to evict least recently used"
+			" regions once the cache grows past the reclaim"
+			" watermark.  When enabled, registration misses do"
+			" not evict regions inline.  Providers must support"
+			" deregistration from any thread.  (default: false)");
+	fi_param_define(NULL, "mr_cache_reclaim_watermark", FI_PARAM_INT,
+			"Percentage of the MR cache size limits that the"
+			" reclaim thread trims the cache down to.  Only used"
+			" if mr_cache_reclaim is enabled.  (default: 90)");
 	fi_param_define(NULL, "mr_cache_monitor", FI_PARAM_STRING,
 			"Define a default memory registration monitor."
 			" The monitor checks for virtual to physical memory"
@@ -211,6 +229,12 @@ void ofi_monitors_init(void)
 
 	fi_param_get_size_t(NULL, "mr_cache_max_size", &cache_params.max_size);
 	fi_param_get_size_t(NULL, "mr_cache_max_count", &cache_params.max_cnt);
+	fi_param_get_size_t(NULL, "mr_cache_shards", &cache_params.shard_cnt);
+	fi_param_get_bool(NULL, "mr_cache_reclaim", &cache_params.reclaim);
+	fi_param_get_int(NULL, "mr_cache_reclaim_watermark",
+			 &cache_params.reclaim_watermark);
+	cache_params.reclaim_watermark =
+		MIN(MAX(cache_params.reclaim_watermark, 0), 100);
 	fi_param_get_str(NULL, "mr_cache_monitor", &cache_params.monitor);
 	fi_param_get_bool(NULL, "mr_cuda_cache_monitor_enabled",
 			  &cache_params.cuda_monitor_enabled);
@@ -46,11 +46,18 @@
 
 struct ofi_mr_cache_params cache_params = {
 	.max_cnt = 1024,
+	.shard_cnt = 1,
+	.reclaim_watermark = 90,
 	.cuda_monitor_enabled = true,
 	.rocr_monitor_enabled = true,
 	.ze_monitor_enabled = true,
 };
 
+/* All initialized caches, for reporting through the mr_cache fid */
+static DEFINE_LIST(mr_cache_list);
+static pthread_mutex_t mr_cache_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ofi_mr_cache_stats mr_cache_closed_stats;
+
 static int util_mr_find_within(struct ofi_rbmap *map, void *key, void *data)
 {
 	struct ofi_mr_entry *entry = data;
@@ -122,7 +129,8 @@ static void util_mr_free_entry(struct ofi_mr_cache *cache,
 	util_mr_entry_free(cache, entry);
 }
 
-static void util_mr_uncache_entry_storage(struct ofi_mr_cache *cache,
+/* Caller must hold the shard lock */
+static void util_mr_uncache_entry_storage(struct ofi_mr_cache_shard *shard,
 					  struct ofi_mr_entry *entry)
 {
 	/* Without subscription context, we might unsubscribe from
@@ -131,24 +139,25 @@ static void util_mr_uncache_entry_storage(struct ofi_mr_cache *cache,
 	 * notification events, but is harmless to correct operation.
 	 */
 
-	ofi_rbmap_delete(&cache->tree, entry->node);
+	ofi_rbmap_delete(&shard->tree, entry->node);
 	entry->node = NULL;
 
-	cache->cached_cnt--;
-	cache->cached_size -= entry->info.iov.iov_len;
+	shard->cached_cnt--;
+	shard->cached_size -= entry->info.iov.iov_len;
 }
 
-static void util_mr_uncache_entry(struct ofi_mr_cache *cache,
+/* Caller must hold the shard lock */
+static void util_mr_uncache_entry(struct ofi_mr_cache_shard *shard,
 				  struct ofi_mr_entry *entry)
 {
-	util_mr_uncache_entry_storage(cache, entry);
+	util_mr_uncache_entry_storage(shard, entry);
 
 	if (entry->use_cnt == 0) {
 		dlist_remove(&entry->list_entry);
-		dlist_insert_tail(&entry->list_entry, &cache->dead_region_list);
+		dlist_insert_tail(&entry->list_entry, &shard->dead_region_list);
 	} else {
-		cache->uncached_cnt++;
-		cache->uncached_size += entry->info.iov.iov_len;
+		shard->uncached_cnt++;
+		shard->uncached_size += entry->info.iov.iov_len;
 	}
 }
 
@@ -164,65 +173,105 @@ static struct ofi_mr_entry *ofi_mr_rbt_find(struct ofi_rbmap *tree,
 	return node->data;
 }
 
-static struct ofi_mr_entry *ofi_mr_rbt_overlap(struct ofi_rbmap *tree,
-					       const struct iovec *key)
+/* Regions within a tree never contain one another, since a new region
+ * is only inserted after purging any cached region that it is within or
+ * that is within it.  Ordered by start address, the end addresses are
+ * therefore also increasing, and all regions overlapping a given range
+ * form a single run of the tree.  Locate the first and walk forward,
+ * rather than repeating the search from the root for each region.
+ */
+static void util_mr_uncache_overlap(struct ofi_mr_cache_shard *shard,
+				    const struct iovec *iov)
 {
-	struct ofi_rbnode *node;
+	struct ofi_rbnode *node, *next;
 	struct ofi_mr_info info = {0};
 
-	info.iov = *key;
+	info.iov = *iov;
 
-	node = ofi_rbmap_search(tree, (void *) &info,
-				util_mr_find_overlap);
-	if (!node)
-		return NULL;
+	node = ofi_rbmap_search_first(&shard->tree, (void *) &info,
+				      util_mr_find_overlap);
+	while (node) {
+		next = ofi_rbmap_next(&shard->tree, node);
+		util_mr_uncache_entry(shard, node->data);
 
-	return node->data;
+		if (next && util_mr_find_overlap(&shard->tree, (void *) &info,
+						 next->data))
+			break;
+		node = next;
+	}
+}
+
+static void util_mr_cache_wake_reclaim(struct ofi_mr_cache *cache)
+{
+	if (ofi_atomic_get32(&cache->reclaim_pending) ||
+	    !ofi_atomic_cas_bool32(&cache->reclaim_pending, 0, 1))
+		return;
+
+	pthread_mutex_lock(&cache->reclaim_lock);
+	pthread_cond_signal(&cache->reclaim_cond);
+	pthread_mutex_unlock(&cache->reclaim_lock);
 }
 
 /* Caller must hold ofi_mem_monitor lock as well as unsubscribe from the region */
 void ofi_mr_cache_notify(struct ofi_mr_cache *cache, const void *addr, size_t len)
 {
-	struct ofi_mr_entry *entry;
+	struct ofi_mr_cache_shard *shard;
 	struct iovec iov;
+	bool dead = false;
+	size_t i;
 
 	cache->notify_cnt++;
 	iov.iov_base = (void *) addr;
 	iov.iov_len = len;
 
-	for (entry = ofi_mr_rbt_overlap(&cache->tree, &iov); entry;
-	     entry = ofi_mr_rbt_overlap(&cache->tree, &iov))
-		util_mr_uncache_entry(cache, entry);
+	/* A region may start in any shard and extend into the range */
+	for (i = 0; i < cache->shard_cnt; i++) {
+		shard = &cache->shards[i];
+		pthread_mutex_lock(&shard->lock);
+		util_mr_uncache_overlap(shard, &iov);
+		if (!dlist_empty(&shard->dead_region_list))
+			dead = true;
+		pthread_mutex_unlock(&shard->lock);
+	}
+
+	if (dead && cache->reclaim)
+		util_mr_cache_wake_reclaim(cache);
 }
 
-/* Function to remove dead regions and prune MR cache size.
- * Returns true if any entries were flushed from the cache.
+/* When called by the reclaim thread, the LRU is trimmed to the low
+ * watermark rather than until the shard is no longer full.  Returns the
+ * number of regions freed.
  */
-bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru)
+static size_t util_mr_cache_flush_shard(struct ofi_mr_cache *cache,
+					struct ofi_mr_cache_shard *shard,
+					bool flush_lru, bool reclaim)
 {
 	struct dlist_entry free_list;
 	struct ofi_mr_entry *entry;
-	bool entries_freed;
+	size_t freed = 0;
 
 	dlist_init(&free_list);
 
-	pthread_mutex_lock(&mm_lock);
+	pthread_mutex_lock(&shard->lock);
 
-	dlist_splice_tail(&free_list, &cache->dead_region_list);
+	dlist_splice_tail(&free_list, &shard->dead_region_list);
 
-	while (flush_lru && !dlist_empty(&cache->lru_list)) {
-		dlist_pop_front(&cache->lru_list, struct ofi_mr_entry,
+	if (reclaim)
+		flush_lru = ofi_mr_cache_above_low(cache, shard);
+
+	while (flush_lru && !dlist_empty(&shard->lru_list)) {
+		dlist_pop_front(&shard->lru_list, struct ofi_mr_entry,
 				entry, list_entry);
 		dlist_init(&entry->list_entry);
-		util_mr_uncache_entry_storage(cache, entry);
+		util_mr_uncache_entry_storage(shard, entry);
 		dlist_insert_tail(&entry->list_entry, &free_list);
+		shard->evict_cnt++;
 
-		flush_lru = ofi_mr_cache_full(cache);
+		flush_lru = reclaim ? ofi_mr_cache_above_low(cache, shard) :
+			    ofi_mr_cache_full(cache, shard);
 	}
 
-	pthread_mutex_unlock(&mm_lock);
-
-	entries_freed = !dlist_empty(&free_list);
+	pthread_mutex_unlock(&shard->lock);
 
 	while(!dlist_empty(&free_list)) {
 		dlist_pop_front(&free_list, struct ofi_mr_entry,
@@ -230,6 +279,52 @@ bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru)
 		FI_DBG(cache->domain->prov, FI_LOG_MR, "flush %p (len: %zu)\n",
 			entry->info.iov.iov_base, entry->info.iov.iov_len);
 		util_mr_free_entry(cache, entry);
+		freed++;
+	}
+
+	return freed;
+}
+
+static void *util_mr_cache_reclaim_thread(void *arg)
+{
+	struct ofi_mr_cache *cache = arg;
+	size_t i, freed;
+
+	pthread_mutex_lock(&cache->reclaim_lock);
+	while (!cache->reclaim_stop) {
+		if (!ofi_atomic_get32(&cache->reclaim_pending)) {
+			pthread_cond_wait(&cache->reclaim_cond,
+					  &cache->reclaim_lock);
+			continue;
+		}
+
+		ofi_atomic_set32(&cache->reclaim_pending, 0);
+		pthread_mutex_unlock(&cache->reclaim_lock);
+
+		for (i = 0, freed = 0; i < cache->shard_cnt; i++) {
+			freed += util_mr_cache_flush_shard(cache,
+						&cache->shards[i], false, true);
+		}
+
+		pthread_mutex_lock(&cache->reclaim_lock);
+		cache->deferred_free_cnt += freed;
+	}
+	pthread_mutex_unlock(&cache->reclaim_lock);
+	return NULL;
+}
+
+/* Function to remove dead regions and prune MR cache size.
+ * Returns true if any entries were flushed from the cache.
+ */
+bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru)
+{
+	bool entries_freed = false;
+	size_t i;
+
+	for (i = 0; i < cache->shard_cnt; i++) {
+		if (util_mr_cache_flush_shard(cache, &cache->shards[i],
+					      flush_lru, false))
+			entries_freed = true;
 	}
 
 	return entries_freed;
@@ -237,23 +332,33 @@ bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru)
 
 void ofi_mr_cache_delete(struct ofi_mr_cache *cache, struct ofi_mr_entry *entry)
 {
+	struct ofi_mr_cache_shard *shard;
+
 	FI_DBG(cache->domain->prov, FI_LOG_MR, "delete %p (len: %zu)\n",
 	       entry->info.iov.iov_base, entry->info.iov.iov_len);
 
-	pthread_mutex_lock(&mm_lock);
-	cache->delete_cnt++;
+	shard = ofi_mr_cache_shard(cache, entry->info.iov.iov_base);
+	pthread_mutex_lock(&shard->lock);
+	shard->delete_cnt++;
 
 	if (--entry->use_cnt == 0) {
 		if (!entry->node) {
-			cache->uncached_cnt--;
-			cache->uncached_size -= entry->info.iov.iov_len;
-			pthread_mutex_unlock(&mm_lock);
+			shard->uncached_cnt--;
+			shard->uncached_size -= entry->info.iov.iov_len;
+			if (cache->reclaim) {
+				dlist_insert_tail(&entry->list_entry,
+						  &shard->dead_region_list);
+				pthread_mutex_unlock(&shard->lock);
+				util_mr_cache_wake_reclaim(cache);
+				return;
+			}
+			pthread_mutex_unlock(&shard->lock);
 			util_mr_free_entry(cache, entry);
 			return;
 		}
-		dlist_insert_tail(&entry->list_entry, &cache->lru_list);
+		dlist_insert_tail(&entry->list_entry, &shard->lru_list);
 	}
-	pthread_mutex_unlock(&mm_lock);
+	pthread_mutex_unlock(&shard->lock);
 }
 
 /*
@@ -267,7 +372,9 @@ void ofi_mr_cache_delete(struct ofi_mr_cache *cache, struct ofi_mr_entry *entry)
  * restart the entire operation.
  */
 static int
-util_mr_cache_create(struct ofi_mr_cache *cache, const struct ofi_mr_info *info,
+util_mr_cache_create(struct ofi_mr_cache *cache,
+		     struct ofi_mr_cache_shard *shard,
+		     const struct ofi_mr_info *info,
 		     struct ofi_mr_entry **entry)
 {
 	struct ofi_mr_entry *cur;
@@ -292,37 +399,40 @@ util_mr_cache_create(struct ofi_mr_cache *cache, const struct ofi_mr_info *info,
 		goto free;
 
 	pthread_mutex_lock(&mm_lock);
-	cur = ofi_mr_rbt_find(&cache->tree, info);
+	pthread_mutex_lock(&shard->lock);
+	cur = ofi_mr_rbt_find(&shard->tree, info);
 	if (cur) {
 		ret = -FI_EAGAIN;
 		goto unlock;
 	}
 
-	if (ofi_mr_cache_full(cache)) {
-		cache->uncached_cnt++;
-		cache->uncached_size += info->iov.iov_len;
+	if (ofi_mr_cache_full(cache, shard)) {
+		shard->uncached_cnt++;
+		shard->uncached_size += info->iov.iov_len;
 	} else {
-		if (ofi_rbmap_insert(&cache->tree, (void *) &(*entry)->info,
+		if (ofi_rbmap_insert(&shard->tree, (void *) &(*entry)->info,
 				     (void *) *entry, &(*entry)->node)) {
 			ret = -FI_ENOMEM;
 			goto unlock;
 		}
-		cache->cached_cnt++;
-		cache->cached_size += info->iov.iov_len;
+		shard->cached_cnt++;
+		shard->cached_size += info->iov.iov_len;
 
 		ret = ofi_monitor_subscribe(monitor, info->iov.iov_base,
 					    info->iov.iov_len,
 					    &(*entry)->hmem_info);
 		if (ret) {
-			util_mr_uncache_entry_storage(cache, *entry);
-			cache->uncached_cnt++;
-			cache->uncached_size += (*entry)->info.iov.iov_len;
+			util_mr_uncache_entry_storage(shard, *entry);
+			shard->uncached_cnt++;
+			shard->uncached_size += (*entry)->info.iov.iov_len;
 		}
 	}
+	pthread_mutex_unlock(&shard->lock);
 	pthread_mutex_unlock(&mm_lock);
 	return 0;
 
 unlock:
+	pthread_mutex_unlock(&shard->lock);
 	pthread_mutex_unlock(&mm_lock);
 free:
 	util_mr_free_entry(cache, *entry);
@@ -332,6 +442,7 @@ free:
 int ofi_mr_cache_search(struct ofi_mr_cache *cache, const struct ofi_mr_info *info,
 			struct ofi_mr_entry **entry)
 {
+	struct ofi_mr_cache_shard *shard;
 	struct ofi_mem_monitor *monitor;
 	bool flush_lru;
 	int ret;
@@ -347,17 +458,31 @@ int ofi_mr_cache_search(struct ofi_mr_cache *cache, const struct ofi_mr_info *in
 	FI_DBG(cache->domain->prov, FI_LOG_MR, "search %p (len: %zu)\n",
 	       info->iov.iov_base, info->iov.iov_len);
 
+	shard = ofi_mr_cache_shard(cache, info->iov.iov_base);
 	do {
-		pthread_mutex_lock(&mm_lock);
-		flush_lru = ofi_mr_cache_full(cache);
-		if (flush_lru || !dlist_empty(&cache->dead_region_list)) {
-			pthread_mutex_unlock(&mm_lock);
-			ofi_mr_cache_flush(cache, flush_lru);
-			pthread_mutex_lock(&mm_lock);
+		pthread_mutex_lock(&shard->lock);
+		if (cache->reclaim) {
+			/* Regions created while the shard is full are not
+			 * cached, so eviction never happens inline.  Only
+			 * wake the thread if it has something to free.
+			 */
+			if ((ofi_mr_cache_above_low(cache, shard) &&
+			     !dlist_empty(&shard->lru_list)) ||
+			    !dlist_empty(&shard->dead_region_list))
+				util_mr_cache_wake_reclaim(cache);
+		} else {
+			flush_lru = ofi_mr_cache_full(cache, shard);
+			if (flush_lru ||
+			    !dlist_empty(&shard->dead_region_list)) {
+				pthread_mutex_unlock(&shard->lock);
+				util_mr_cache_flush_shard(cache, shard,
+							  flush_lru, false);
+				pthread_mutex_lock(&shard->lock);
+			}
 		}
 
-		cache->search_cnt++;
-		*entry = ofi_mr_rbt_find(&cache->tree, info);
+		shard->search_cnt++;
+		*entry = ofi_mr_rbt_find(&shard->tree, info);
 
 		if (*entry &&
 		    ofi_iov_within(&info->iov, &(*entry)->info.iov) &&
@@ -366,12 +491,12 @@ int ofi_mr_cache_search(struct ofi_mr_cache *cache, const struct ofi_mr_info *in
 
 		/* Purge regions that overlap with new region */
 		while (*entry) {
-			util_mr_uncache_entry(cache, *entry);
-			*entry = ofi_mr_rbt_find(&cache->tree, info);
+			util_mr_uncache_entry(shard, *entry);
+			*entry = ofi_mr_rbt_find(&shard->tree, info);
 		}
-		pthread_mutex_unlock(&mm_lock);
+		pthread_mutex_unlock(&shard->lock);
 
-		ret = util_mr_cache_create(cache, info, entry);
+		ret = util_mr_cache_create(cache, shard, info, entry);
 		if (ret && ret != -FI_EAGAIN) {
 			if (ofi_mr_cache_flush(cache, true))
 				ret = -FI_EAGAIN;
@@ -381,16 +506,17 @@ int ofi_mr_cache_search(struct ofi_mr_cache *cache, const struct ofi_mr_info *in
 	return ret;
 
 hit:
-	cache->hit_cnt++;
+	shard->hit_cnt++;
 	if ((*entry)->use_cnt++ == 0)
 		dlist_remove_init(&(*entry)->list_entry);
-	pthread_mutex_unlock(&mm_lock);
+	pthread_mutex_unlock(&shard->lock);
 	return 0;
 }
 
 struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 				       const struct fi_mr_attr *attr)
 {
+	struct ofi_mr_cache_shard *shard;
 	struct ofi_mr_info info;
 	struct ofi_mr_entry *entry;
 
@@ -398,12 +524,13 @@ struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 	FI_DBG(cache->domain->prov, FI_LOG_MR, "find %p (len: %zu)\n",
 	       attr->mr_iov->iov_base, attr->mr_iov->iov_len);
 
-	pthread_mutex_lock(&mm_lock);
-	cache->search_cnt++;
+	shard = ofi_mr_cache_shard(cache, attr->mr_iov->iov_base);
+	pthread_mutex_lock(&shard->lock);
+	shard->search_cnt++;
 
 	info.peer_id = 0;
 	info.iov = *attr->mr_iov;
-	entry = ofi_mr_rbt_find(&cache->tree, &info);
+	entry = ofi_mr_rbt_find(&shard->tree, &info);
 	if (!entry) {
 		goto unlock;
 	}
@@ -413,18 +540,19 @@ struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 		goto unlock;
 	}
 
-	cache->hit_cnt++;
+	shard->hit_cnt++;
 	if ((entry)->use_cnt++ == 0)
 		dlist_remove_init(&(entry)->list_entry);
 
 unlock:
-	pthread_mutex_unlock(&mm_lock);
+	pthread_mutex_unlock(&shard->lock);
 	return entry;
 }
 
 int ofi_mr_cache_reg(struct ofi_mr_cache *cache, const struct fi_mr_attr *attr,
 		     struct ofi_mr_entry **entry)
 {
+	struct ofi_mr_cache_shard *shard;
 	int ret;
 
 	assert(attr->iov_count == 1);
@@ -435,10 +563,11 @@ int ofi_mr_cache_reg(struct ofi_mr_cache *cache, const struct fi_mr_attr *attr,
 	if (!*entry)
 		return -FI_ENOMEM;
 
-	pthread_mutex_lock(&mm_lock);
-	cache->uncached_cnt++;
-	cache->uncached_size += attr->mr_iov->iov_len;
-	pthread_mutex_unlock(&mm_lock);
+	shard = ofi_mr_cache_shard(cache, attr->mr_iov->iov_base);
+	pthread_mutex_lock(&shard->lock);
+	shard->uncached_cnt++;
+	shard->uncached_size += attr->mr_iov->iov_len;
+	pthread_mutex_unlock(&shard->lock);
 
 	(*entry)->info.iov = *attr->mr_iov;
 	(*entry)->use_cnt = 1;
@@ -452,36 +581,188 @@ int ofi_mr_cache_reg(struct ofi_mr_cache *cache, const struct fi_mr_attr *attr,
 
 buf_free:
 	util_mr_entry_free(cache, *entry);
+	pthread_mutex_lock(&shard->lock);
+	shard->uncached_cnt--;
+	shard->uncached_size -= attr->mr_iov->iov_len;
+	pthread_mutex_unlock(&shard->lock);
+	return ret;
+}
+
+void ofi_mr_cache_get_stats(struct ofi_mr_cache *cache,
+			    struct ofi_mr_cache_stats *stats)
+{
+	struct ofi_mr_cache_shard *shard;
+	size_t i;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < cache->shard_cnt; i++) {
+		shard = &cache->shards[i];
+		pthread_mutex_lock(&shard->lock);
+		stats->cached_cnt += shard->cached_cnt;
+		stats->cached_size += shard->cached_size;
+		stats->uncached_cnt += shard->uncached_cnt;
+		stats->uncached_size += shard->uncached_size;
+		stats->search_cnt += shard->search_cnt;
+		stats->delete_cnt += shard->delete_cnt;
+		stats->hit_cnt += shard->hit_cnt;
+		stats->evict_cnt += shard->evict_cnt;
+		pthread_mutex_unlock(&shard->lock);
+	}
+
 	pthread_mutex_lock(&mm_lock);
-	cache->uncached_cnt--;
-	cache->uncached_size -= attr->mr_iov->iov_len;
+	stats->notify_cnt = cache->notify_cnt;
 	pthread_mutex_unlock(&mm_lock);
-	return ret;
+
+	if (cache->reclaim) {
+		pthread_mutex_lock(&cache->reclaim_lock);
+		stats->deferred_free_cnt = cache->deferred_free_cnt;
+		pthread_mutex_unlock(&cache->reclaim_lock);
+	} else {
+		stats->deferred_free_cnt = cache->deferred_free_cnt;
+	}
+}
+
+static void util_mr_cache_add_stats(struct ofi_mr_cache_stats *total,
+				    const struct ofi_mr_cache_stats *stats)
+{
+	total->cached_cnt += stats->cached_cnt;
+	total->cached_size += stats->cached_size;
+	total->uncached_cnt += stats->uncached_cnt;
+	total->uncached_size += stats->uncached_size;
+	total->search_cnt += stats->search_cnt;
+	total->delete_cnt += stats->delete_cnt;
+	total->hit_cnt += stats->hit_cnt;
+	total->notify_cnt += stats->notify_cnt;
+	total->evict_cnt += stats->evict_cnt;
+	total->deferred_free_cnt += stats->deferred_free_cnt;
+}
+
+static int util_mr_cache_start_reclaim(struct ofi_mr_cache *cache)
+{
+	int ret;
+
+	cache->reclaim = true;
+	cache->reclaim_stop = false;
+	ofi_atomic_initialize32(&cache->reclaim_pending, 0);
+	pthread_mutex_init(&cache->reclaim_lock, NULL);
+	pthread_cond_init(&cache->reclaim_cond, NULL);
+
+	ret = pthread_create(&cache->reclaim_thread, NULL,
+			     util_mr_cache_reclaim_thread, cache);
+	if (ret) {
+		FI_WARN(&core_prov, FI_LOG_MR,
+			"failed to create reclaim thread %s\n", strerror(ret));
+		pthread_cond_destroy(&cache->reclaim_cond);
+		pthread_mutex_destroy(&cache->reclaim_lock);
+		cache->reclaim = false;
+		return -ret;
+	}
+	return 0;
+}
+
+static void util_mr_cache_stop_reclaim(struct ofi_mr_cache *cache)
+{
+	if (!cache->reclaim)
+		return;
+
+	pthread_mutex_lock(&cache->reclaim_lock);
+	cache->reclaim_stop = true;
+	pthread_cond_signal(&cache->reclaim_cond);
+	pthread_mutex_unlock(&cache->reclaim_lock);
+	pthread_join(cache->reclaim_thread, NULL);
+
+	pthread_cond_destroy(&cache->reclaim_cond);
+	pthread_mutex_destroy(&cache->reclaim_lock);
+	cache->reclaim = false;
+}
+
+static void util_mr_cache_cleanup_shards(struct ofi_mr_cache *cache)
+{
+	size_t i;
+
+	for (i = 0; i < cache->shard_cnt; i++) {
+		ofi_rbmap_cleanup(&cache->shards[i].tree);
+		pthread_mutex_destroy(&cache->shards[i].lock);
+	}
+	ofi_freealign(cache->shards);
+	cache->shards = NULL;
 }
 
 void ofi_mr_cache_cleanup(struct ofi_mr_cache *cache)
 {
+	struct ofi_mr_cache_stats stats;
+
 	/* If we don't have a domain, initialization failed */
 	if (!cache->domain)
 		return;
 
+	pthread_mutex_lock(&mr_cache_list_lock);
+	dlist_remove(&cache->list_entry);
+	pthread_mutex_unlock(&mr_cache_list_lock);
+
+	util_mr_cache_stop_reclaim(cache);
+
+	ofi_mr_cache_get_stats(cache, &stats);
 	FI_INFO(cache->domain->prov, FI_LOG_MR, "MR cache stats: "
-		"searches %zu, deletes %zu, hits %zu notify %zu\n",
-		cache->search_cnt, cache->delete_cnt, cache->hit_cnt,
-		cache->notify_cnt);
+		"searches %zu, deletes %zu, hits %zu notify %zu "
+		"evictions %zu deferred frees %zu\n",
+		stats.search_cnt, stats.delete_cnt, stats.hit_cnt,
+		stats.notify_cnt, stats.evict_cnt, stats.deferred_free_cnt);
 
 	while (ofi_mr_cache_flush(cache, true))
 		;
 
 	pthread_mutex_destroy(&cache->lock);
 	ofi_monitors_del_cache(cache);
-	ofi_rbmap_cleanup(&cache->tree);
+	ofi_mr_cache_get_stats(cache, &stats);
+
+	pthread_mutex_lock(&mr_cache_list_lock);
+	util_mr_cache_add_stats(&mr_cache_closed_stats, &stats);
+	pthread_mutex_unlock(&mr_cache_list_lock);
+
+	util_mr_cache_cleanup_shards(cache);
 	ofi_atomic_dec32(&cache->domain->ref);
 	ofi_bufpool_destroy(cache->entry_pool);
-	assert(cache->cached_cnt == 0);
-	assert(cache->cached_size == 0);
-	assert(cache->uncached_cnt == 0);
-	assert(cache->uncached_size == 0);
+	assert(stats.cached_cnt == 0);
+	assert(stats.cached_size == 0);
+	assert(stats.uncached_cnt == 0);
+	assert(stats.uncached_size == 0);
+}
+
+static int util_mr_cache_init_shards(struct ofi_mr_cache *cache)
+{
+	struct ofi_mr_cache_shard *shard;
+	size_t i;
+	int ret;
+
+	cache->shard_cnt = MIN(MAX(cache_params.shard_cnt, 1),
+			       OFI_MR_CACHE_MAX_SHARDS);
+	cache->shard_max_cnt = MAX(cache_params.max_cnt / cache->shard_cnt, 1);
+	cache->shard_max_size = MAX(cache_params.max_size / cache->shard_cnt,
+				    1);
+	cache->shard_low_cnt = cache->shard_max_cnt / 100 *
+			       cache_params.reclaim_watermark +
+			       cache->shard_max_cnt % 100 *
+			       cache_params.reclaim_watermark / 100;
+	cache->shard_low_size = cache->shard_max_size / 100 *
+				cache_params.reclaim_watermark +
+				cache->shard_max_size % 100 *
+				cache_params.reclaim_watermark / 100;
+
+	ret = ofi_memalign((void **) &cache->shards, 64,
+			   sizeof(*cache->shards) * cache->shard_cnt);
+	if (ret)
+		return -FI_ENOMEM;
+
+	memset(cache->shards, 0, sizeof(*cache->shards) * cache->shard_cnt);
+	for (i = 0; i < cache->shard_cnt; i++) {
+		shard = &cache->shards[i];
+		ofi_rbmap_init(&shard->tree, util_mr_find_within);
+		dlist_init(&shard->lru_list);
+		dlist_init(&shard->dead_region_list);
+		pthread_mutex_init(&shard->lock, NULL);
+	}
+	return 0;
 }
 
 /* Monitors array must be of size OFI_HMEM_MAX. */
@@ -495,24 +776,27 @@ int ofi_mr_cache_init(struct util_domain *domain,
 	if (!cache_params.max_cnt || !cache_params.max_size)
 		return -FI_ENOSPC;
 
+	ret = util_mr_cache_init_shards(cache);
+	if (ret)
+		return ret;
+
 	pthread_mutex_init(&cache->lock, NULL);
-	dlist_init(&cache->lru_list);
-	dlist_init(&cache->dead_region_list);
-	cache->cached_cnt = 0;
-	cache->cached_size = 0;
-	cache->uncached_cnt = 0;
-	cache->uncached_size = 0;
-	cache->search_cnt = 0;
-	cache->delete_cnt = 0;
-	cache->hit_cnt = 0;
 	cache->notify_cnt = 0;
 	cache->domain = domain;
 	ofi_atomic_inc32(&domain->ref);
 
-	ofi_rbmap_init(&cache->tree, util_mr_find_within);
+	/* Notifications may arrive as soon as the cache is monitored */
+	cache->reclaim = false;
+	cache->deferred_free_cnt = 0;
+	if (cache_params.reclaim) {
+		ret = util_mr_cache_start_reclaim(cache);
+		if (ret)
+			goto destroy;
+	}
+
 	ret = ofi_monitors_add_cache(monitors, cache);
 	if (ret)
-		goto destroy;
+		goto stop;
 
 	ret = ofi_bufpool_create(&cache->entry_pool,
 				 sizeof(struct ofi_mr_entry) +
@@ -521,11 +805,16 @@ int ofi_mr_cache_init(struct util_domain *domain,
 	if (ret)
 		goto del;
 
+	pthread_mutex_lock(&mr_cache_list_lock);
+	dlist_insert_tail(&cache->list_entry, &mr_cache_list);
+	pthread_mutex_unlock(&mr_cache_list_lock);
 	return 0;
 del:
 	ofi_monitors_del_cache(cache);
+stop:
+	util_mr_cache_stop_reclaim(cache);
 destroy:
-	ofi_rbmap_cleanup(&cache->tree);
+	util_mr_cache_cleanup_shards(cache);
 	ofi_atomic_dec32(&cache->domain->ref);
 	pthread_mutex_destroy(&cache->lock);
 	cache->domain = NULL;
@@ -549,11 +838,49 @@ static int ofi_bind_cache_fid(struct fid *fid, struct fid *bfid,
 	return ofi_monitor_import(bfid);
 }
 
+static void ofi_mr_cache_fid_stats(struct fi_mr_cache_stats *out)
+{
+	struct ofi_mr_cache_stats total, stats;
+	struct ofi_mr_cache *cache;
+
+	pthread_mutex_lock(&mr_cache_list_lock);
+	total = mr_cache_closed_stats;
+	dlist_foreach_container(&mr_cache_list, struct ofi_mr_cache,
+				cache, list_entry) {
+		ofi_mr_cache_get_stats(cache, &stats);
+		util_mr_cache_add_stats(&total, &stats);
+	}
+	pthread_mutex_unlock(&mr_cache_list_lock);
+
+	out->searches = total.search_cnt;
+	out->hits = total.hit_cnt;
+	out->misses = total.search_cnt - total.hit_cnt;
+	out->evictions = total.evict_cnt;
+	out->deferred_frees = total.deferred_free_cnt;
+	out->notifications = total.notify_cnt;
+	out->cached_cnt = total.cached_cnt;
+	out->cached_size = total.cached_size;
+}
+
+static int ofi_control_cache_fid(struct fid *fid, int command, void *arg)
+{
+	struct fi_fid_var *var = arg;
+
+	if (command != FI_GET_VAL)
+		return -FI_ENOSYS;
+
+	if (!var || var->name != FI_MR_CACHE_STATS || !var->val)
+		return -FI_EINVAL;
+
+	ofi_mr_cache_fid_stats(var->val);
+	return 0;
+}
+
 static struct fi_ops ofi_mr_cache_ops = {
 	.size = sizeof(struct fi_ops),
 	.close = ofi_close_cache_fid,
 	.bind = ofi_bind_cache_fid,
-	.control = fi_no_control,
+	.control = ofi_control_cache_fid,
 	.ops_open = fi_no_ops_open,
 	.tostr = fi_no_tostr,
 	.ops_set = fi_no_ops_set,
@@ -42,6 +42,7 @@
 #include <stdio.h>
 
 #include <ofi_shm.h>
+#include <ofi_mb.h>
 
 struct dlist_entry ep_name_list;
 DEFINE_LIST(ep_name_list);
@@ -115,7 +116,7 @@ size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
 	sar_pool_offset = inject_pool_offset +
 		freestack_size(sizeof(struct smr_inject_buf), rx_size);
 	peer_data_offset = sar_pool_offset +
-		freestack_size(sizeof(struct smr_sar_buf), SMR_MAX_PEERS);
+		freestack_size(sizeof(struct smr_sar_buf), SMR_SAR_BUF_CNT);
 	ep_name_offset = peer_data_offset + sizeof(struct smr_peer_data) *
 		SMR_MAX_PEERS;
 
@@ -301,10 +302,10 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	smr_resp_queue_init(smr_resp_queue(*smr), tx_size);
 	smr_freestack_init(smr_inject_pool(*smr), rx_size,
 			sizeof(struct smr_inject_buf));
-	smr_freestack_init(smr_sar_pool(*smr), SMR_MAX_PEERS,
+	smr_freestack_init(smr_sar_pool(*smr), SMR_SAR_BUF_CNT,
 			sizeof(struct smr_sar_buf));
 	for (i = 0; i < SMR_MAX_PEERS; i++) {
-		smr_peer_addr_init(&smr_peer_data(*smr)[i].addr);
+		smr_peer_data(*smr)[i].id = -1;
 		smr_peer_data(*smr)[i].sar_status = 0;
 		smr_peer_data(*smr)[i].name_sent = 0;
 	}
@@ -339,25 +340,19 @@ static int smr_name_compare(struct ofi_rbmap *map, void *key, void *data)
 
 	smr_map = container_of(map, struct smr_map, rbmap);
 
-	return strncmp(smr_map->peers[(uintptr_t) data].peer.name,
+	return strncmp(smr_map_peer(smr_map, (uintptr_t) data)->peer.name,
 		       (char *) key, SMR_NAME_MAX);
 }
 
-int smr_map_create(const struct fi_provider *prov, int peer_count,
-		   uint16_t flags, struct smr_map **map)
+int smr_map_create(const struct fi_provider *prov, uint16_t flags,
+		   struct smr_map **map)
 {
-	int i;
-
 	(*map) = calloc(1, sizeof(struct smr_map));
 	if (!*map) {
 		FI_WARN(prov, FI_LOG_DOMAIN, "failed to create SHM region group\n");
 		return -FI_ENOMEM;
 	}
 
-	for (i = 0; i < peer_count; i++) {
-		smr_peer_addr_init(&(*map)->peers[i].peer);
-		(*map)->peers[i].fiaddr = FI_ADDR_NOTAVAIL;
-	}
 	(*map)->flags = flags;
 
 	ofi_rbmap_init(&(*map)->rbmap, smr_name_compare);
@@ -375,7 +370,7 @@ static int smr_match_name(struct dlist_entry *item, const void *args)
 int smr_map_to_region(const struct fi_provider *prov, struct smr_map *map,
 		      int64_t id)
 {
-	struct smr_peer *peer_buf = &map->peers[id];
+	struct smr_peer *peer_buf = smr_map_peer(map, id);
 	struct smr_region *peer;
 	size_t size;
 	int fd, ret = 0;
@@ -451,17 +446,10 @@ out:
 void smr_map_to_endpoint(struct smr_region *region, int64_t id)
 {
 	struct smr_region *peer_smr;
-	struct smr_peer_data *local_peers;
 
-	if (region->map->peers[id].peer.id < 0)
+	if (smr_map_peer(region->map, id)->peer.id < 0)
 		return;
 
-	local_peers = smr_peer_data(region);
-
-	strncpy(local_peers[id].addr.name,
-		region->map->peers[id].peer.name, SMR_NAME_MAX - 1);
-	local_peers[id].addr.name[SMR_NAME_MAX - 1] = '\0';
-
 	peer_smr = smr_peer_region(region, id);
 
 	if ((region != peer_smr && region->cma_cap_peer == SMR_CMA_CAP_NA) ||
@@ -472,34 +460,64 @@ void smr_map_to_endpoint(struct smr_region *region, int64_t id)
 void smr_unmap_from_endpoint(struct smr_region *region, int64_t id)
 {
 	struct smr_region *peer_smr;
-	struct smr_peer_data *local_peers, *peer_peers;
+	struct smr_peer_data *peer_peers;
 	int64_t peer_id;
 
-	local_peers = smr_peer_data(region);
-
-	memset(local_peers[id].addr.name, 0, SMR_NAME_MAX);
-	peer_id = region->map->peers[id].peer.id;
+	peer_id = smr_map_peer(region->map, id)->peer.id;
 	if (peer_id < 0)
 		return;
 
 	peer_smr = smr_peer_region(region, id);
 	peer_peers = smr_peer_data(peer_smr);
 
-	peer_peers[peer_id].addr.id = -1;
+	peer_peers[peer_id].id = -1;
 	peer_peers[peer_id].name_sent = 0;
 }
 
 void smr_exchange_all_peers(struct smr_region *region)
 {
 	int64_t i;
-	for (i = 0; i < SMR_MAX_PEERS; i++)
+
+	for (i = 0; i < SMR_MAX_PEERS; i++) {
+		if (!region->map->peers[i >> SMR_PEER_CHUNK_SHIFT]) {
+			i |= SMR_PEER_CHUNK_SIZE - 1;
+			continue;
+		}
 		smr_map_to_endpoint(region, i);
+	}
+}
+
+static int smr_map_alloc_chunk(struct smr_map *map, int64_t id)
+{
+	struct smr_peer *chunk;
+	int i;
+
+	chunk = calloc(SMR_PEER_CHUNK_SIZE, sizeof(*chunk));
+	if (!chunk)
+		return -FI_ENOMEM;
+
+	for (i = 0; i < SMR_PEER_CHUNK_SIZE; i++) {
+		smr_peer_addr_init(&chunk[i].peer);
+		chunk[i].fiaddr = FI_ADDR_NOTAVAIL;
+	}
+	/* lookups outside the map lock must see an initialized chunk */
+	ofi_wmb();
+	map->peers[id >> SMR_PEER_CHUNK_SHIFT] = chunk;
+	return 0;
+}
+
+/* Peers are only used once their chunk exists; a missing chunk is all free */
+static bool smr_map_id_used(struct smr_map *map, int64_t id)
+{
+	return map->peers[id >> SMR_PEER_CHUNK_SHIFT] &&
+	       smr_map_peer(map, id)->peer.id != -1;
 }
 
 int smr_map_add(const struct fi_provider *prov, struct smr_map *map,
 		const char *name, int64_t *id)
 {
 	struct ofi_rbnode *node;
+	struct smr_peer *peer;
 	int tries = 0, ret = 0;
 
 	ofi_spin_lock(&map->lock);
@@ -512,8 +530,7 @@ int smr_map_add(const struct fi_provider *prov, struct smr_map *map,
 		return 0;
 	}
 
-	while (map->peers[map->cur_id].peer.id != -1 &&
-	       tries < SMR_MAX_PEERS) {
+	while (smr_map_id_used(map, map->cur_id) && tries < SMR_MAX_PEERS) {
 		if (++map->cur_id == SMR_MAX_PEERS)
 			map->cur_id = 0;
 		tries++;
@@ -521,14 +538,24 @@ int smr_map_add(const struct fi_provider *prov, struct smr_map *map,
 
 	assert(map->cur_id < SMR_MAX_PEERS && tries < SMR_MAX_PEERS);
 	*id = map->cur_id;
+	if (!map->peers[*id >> SMR_PEER_CHUNK_SHIFT]) {
+		ret = smr_map_alloc_chunk(map, *id);
+		if (ret) {
+			ofi_rbmap_delete(&map->rbmap, node);
+			ofi_spin_unlock(&map->lock);
+			return ret;
+		}
+	}
+
+	peer = smr_map_peer(map, *id);
 	node->data = (void *) (intptr_t) *id;
-	strncpy(map->peers[*id].peer.name, name, SMR_NAME_MAX);
-	map->peers[*id].peer.name[SMR_NAME_MAX - 1] = '\0';
-	map->peers[*id].region = NULL;
+	strncpy(peer->peer.name, name, SMR_NAME_MAX);
+	peer->peer.name[SMR_NAME_MAX - 1] = '\0';
+	peer->region = NULL;
 
 	ret = smr_map_to_region(prov, map, *id);
 	if (!ret)
-		map->peers[*id].peer.id = *id;
+		peer->peer.id = *id;
 
 	map->num_peers++;
 	ofi_spin_unlock(&map->lock);
@@ -538,27 +565,28 @@ int smr_map_add(const struct fi_provider *prov, struct smr_map *map,
 void smr_map_del(struct smr_map *map, int64_t id)
 {
 	struct dlist_entry *entry;
+	struct smr_peer *peer;
 
-	if (id >= SMR_MAX_PEERS || id < 0 || map->peers[id].peer.id < 0)
+	if (id >= SMR_MAX_PEERS || id < 0 || !smr_map_id_used(map, id))
 		return;
 
+	peer = smr_map_peer(map, id);
 	pthread_mutex_lock(&ep_list_lock);
 	entry = dlist_find_first_match(&ep_name_list, smr_match_name,
-				       smr_no_prefix(map->peers[id].peer.name));
+				       smr_no_prefix(peer->peer.name));
 	pthread_mutex_unlock(&ep_list_lock);
 
 	ofi_spin_lock(&map->lock);
 	if (!entry) {
 		if (map->flags & SMR_FLAG_HMEM_ENABLED)
-			(void) ofi_hmem_host_unregister(map->peers[id].region);
-		munmap(map->peers[id].region, map->peers[id].region->total_size);
+			(void) ofi_hmem_host_unregister(peer->region);
+		munmap(peer->region, peer->region->total_size);
 	}
 
-	(void) ofi_rbmap_find_delete(&map->rbmap,
-				     (void *) map->peers[id].peer.name);
+	(void) ofi_rbmap_find_delete(&map->rbmap, (void *) peer->peer.name);
 
-	map->peers[id].fiaddr = FI_ADDR_NOTAVAIL;
-	map->peers[id].peer.id = -1;
+	peer->fiaddr = FI_ADDR_NOTAVAIL;
+	peer->peer.id = -1;
 	map->num_peers--;
 
 	ofi_spin_unlock(&map->lock);
@@ -571,14 +599,18 @@ void smr_map_free(struct smr_map *map)
 	for (i = 0; i < SMR_MAX_PEERS; i++)
 		smr_map_del(map, i);
 
+	for (i = 0; i < SMR_PEER_CHUNK_CNT; i++)
+		free(map->peers[i]);
+
 	ofi_rbmap_cleanup(&map->rbmap);
 	free(map);
 }
 
 struct smr_region *smr_map_get(struct smr_map *map, int64_t id)
 {
-	if (id < 0 || id >= SMR_MAX_PEERS)
+	if (id < 0 || id >= SMR_MAX_PEERS ||
+	    !map->peers[id >> SMR_PEER_CHUNK_SHIFT])
 		return NULL;
 
-	return map->peers[id].region;
+	return smr_map_peer(map, id)->region;
 }
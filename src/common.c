@@ -1217,7 +1217,8 @@ int ofi_bsock_send(struct ofi_bsock *bsock, const void *buf, size_t *len)
 			*len = ret;
 			return -OFI_EINPROGRESS_ASYNC;
 		}
-	} else {
+	}
+	if (*len <= bsock->zerocopy_size || ret == -FI_ENOBUFS) {
 		ret = bsock->sockapi->send(bsock->sockapi, bsock->sock, buf, *len,
 					   MSG_NOSIGNAL, &bsock->tx_sockctx);
 	}
@@ -1277,7 +1278,11 @@ int ofi_bsock_sendv(struct ofi_bsock *bsock, const struct iovec *iov,
 			*len = ret;
 			return -OFI_EINPROGRESS_ASYNC;
 		}
-	} else {
+	}
+	/* ENOBUFS indicates that the socket has too many zero copy sends
+	 * outstanding.  Fall back to copying the data.
+	 */
+	if (*len <= bsock->zerocopy_size || ret == -FI_ENOBUFS) {
 		ret = bsock->sockapi->sendv(bsock->sockapi, bsock->sock, iov, cnt,
 					    MSG_NOSIGNAL, &bsock->tx_sockctx);
 	}
@@ -1313,6 +1318,11 @@ int ofi_bsock_recv(struct ofi_bsock *bsock, void *buf, size_t *len)
 		*len -= bytes;
 	}
 
+	if (bsock->multishot) {
+		*len = bytes;
+		return bytes ? 0 : -FI_EAGAIN;
+	}
+
 	assert(!ofi_bsock_readable(bsock));
 	if (*len < (bsock->rq.size >> 1)) {
 		avail = ofi_byteq_writeable(&bsock->rq);
@@ -1372,6 +1382,11 @@ int ofi_bsock_recvv(struct ofi_bsock *bsock, struct iovec *iov, size_t cnt,
 		bytes = 0;
 	}
 
+	if (bsock->multishot) {
+		*len = bytes;
+		return bytes ? 0 : -FI_EAGAIN;
+	}
+
 	assert(!ofi_bsock_readable(bsock));
 	if (*len < (bsock->rq.size >> 1)) {
 		avail = ofi_byteq_writeable(&bsock->rq);
@@ -1427,49 +1442,79 @@ void ofi_bsock_prefetch_done(struct ofi_bsock *bsock, size_t len)
 }
 
 #ifdef MSG_ZEROCOPY
+static void ofi_bsock_disable_zerocopy(const struct fi_provider *prov,
+				       struct ofi_bsock *bsock)
+{
+	if (bsock->zerocopy_size != SIZE_MAX) {
+		FI_WARN(prov, FI_LOG_EP_DATA, "disabling zerocopy\n");
+		bsock->zerocopy_size = SIZE_MAX;
+	}
+}
+
+/* Each zero copy send is assigned the next index by the kernel.  A
+ * notification reports the range [ee_info, ee_data] of sends that the
+ * kernel has released.  Ranges are coalesced and normally delivered in
+ * order, but only advance done_index so that a late notification for an
+ * older range cannot move it backwards.  The error queue is drained so
+ * that a single POLLERR event reaps all pending notifications.
+ */
 uint32_t ofi_bsock_async_done(const struct fi_provider *prov,
 			      struct ofi_bsock *bsock)
 {
-	struct msghdr msg = {};
+	struct msghdr msg;
 	struct sock_extended_err *serr;
 	struct cmsghdr *cmsg;
 	/* x2 is arbitrary but avoids truncation */
 	uint8_t ctrl[CMSG_SPACE(sizeof(*serr) * 2)];
 	int ret;
 
-	msg.msg_control = &ctrl;
-	msg.msg_controllen = sizeof(ctrl);
-	ret = recvmsg(bsock->sock, &msg, MSG_ERRQUEUE);
-	if (ret < 0) {
-		FI_WARN(prov, FI_LOG_EP_DATA,
-			"Error reading MSG_ERRQUEUE (%s)\n", strerror(errno));
-		goto disable;
-	}
-
-	assert(!(msg.msg_flags & MSG_CTRUNC));
-	cmsg = CMSG_FIRSTHDR(&msg);
-	if ((cmsg->cmsg_level != SOL_IP && cmsg->cmsg_type != IP_RECVERR) &&
-	    (cmsg->cmsg_level != SOL_IPV6 && cmsg->cmsg_type != IPV6_RECVERR)) {
-		FI_WARN(prov, FI_LOG_EP_DATA,
-			"Unexpected cmsg level (!IP) or type (!RECVERR)\n");
-		goto disable;
-	}
-
-	serr = (void *) CMSG_DATA(cmsg);
-	if ((serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) || serr->ee_errno) {
-		FI_WARN(prov, FI_LOG_EP_DATA,
-			"Unexpected sock err origin or errno\n");
-		goto disable;
-	}
-
-	bsock->done_index = serr->ee_data;
-	if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
-		FI_WARN(prov, FI_LOG_EP_DATA,
-			"Zerocopy data was copied\n");
-disable:
-		if (bsock->zerocopy_size != SIZE_MAX) {
-			FI_WARN(prov, FI_LOG_EP_DATA, "disabling zerocopy\n");
-			bsock->zerocopy_size = SIZE_MAX;
+	for (;;) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = &ctrl;
+		msg.msg_controllen = sizeof(ctrl);
+		ret = recvmsg(bsock->sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+		if (ret < 0) {
+			if (OFI_SOCK_TRY_SND_RCV_AGAIN(ofi_sockerr()))
+				break;
+			FI_WARN(prov, FI_LOG_EP_DATA,
+				"Error reading MSG_ERRQUEUE (%s)\n",
+				strerror(errno));
+			ofi_bsock_disable_zerocopy(prov, bsock);
+			break;
+		}
+
+		assert(!(msg.msg_flags & MSG_CTRUNC));
+		cmsg = CMSG_FIRSTHDR(&msg);
+		if (!cmsg ||
+		    !((cmsg->cmsg_level == SOL_IP &&
+		       cmsg->cmsg_type == IP_RECVERR) ||
+		      (cmsg->cmsg_level == SOL_IPV6 &&
+		       cmsg->cmsg_type == IPV6_RECVERR))) {
+			FI_WARN(prov, FI_LOG_EP_DATA,
+				"Unexpected cmsg level (!IP) or type (!RECVERR)\n");
+			ofi_bsock_disable_zerocopy(prov, bsock);
+			continue;
+		}
+
+		serr = (void *) CMSG_DATA(cmsg);
+		if ((serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) ||
+		    serr->ee_errno) {
+			FI_WARN(prov, FI_LOG_EP_DATA,
+				"Unexpected sock err origin or errno\n");
+			ofi_bsock_disable_zerocopy(prov, bsock);
+			continue;
+		}
+
+		if (ofi_val32_gt(serr->ee_data, bsock->done_index))
+			bsock->done_index = serr->ee_data;
+
+		/* The kernel copied the data, e.g. over loopback, so
+		 * zero copy only adds the cost of the notification.
+		 */
+		if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+			FI_WARN(prov, FI_LOG_EP_DATA,
+				"Zerocopy data was copied\n");
+			ofi_bsock_disable_zerocopy(prov, bsock);
 		}
 	}
 	return bsock->done_index;
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2024 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include <ofi.h>
+#include <ofi_copy.h>
+#include <rdma/fi_errno.h>
+
+#define OFI_COPY_THRESHOLD_MIN	(64 * 1024)
+#define OFI_COPY_THRESHOLD_DEF	(1024 * 1024)
+
+size_t ofi_copy_threshold = SIZE_MAX;
+ofi_copy_fn ofi_copy_kernel = memcpy;
+const char *ofi_copy_kernel_name = "memcpy";
+
+struct ofi_copy_desc {
+	const char	*name;
+	ofi_copy_fn	copy;
+	bool		(*supported)(void);
+};
+
+static bool copy_always(void)
+{
+	return true;
+}
+
+#if defined(HAVE_CPUID) && (defined(__x86_64__) || defined(__amd64__)) && \
+    defined(__GNUC__)
+
+#include <immintrin.h>
+
+/* cpuid register index and bit */
+enum {
+	COPY_OSXSAVE_REG	= 2,
+	COPY_OSXSAVE_BIT	= (1 << 27),
+	COPY_ERMS_REG		= 1,
+	COPY_ERMS_BIT		= (1 << 9),
+	COPY_AVX2_REG		= 1,
+	COPY_AVX2_BIT		= (1 << 5),
+	COPY_AVX512F_REG	= 1,
+	COPY_AVX512F_BIT	= (1 << 16),
+};
+
+/* XCR0 state that the OS must save for each vector width */
+#define COPY_XCR0_AVX		0x06
+#define COPY_XCR0_AVX512	0xe6
+
+static bool copy_cpu_supports(unsigned func, unsigned reg, unsigned bit)
+{
+	unsigned cpuinfo[4] = { 0 };
+
+	ofi_cpuid(0, 0, cpuinfo);
+	if (cpuinfo[0] < func)
+		return false;
+
+	ofi_cpuid(func, 0, cpuinfo);
+	return cpuinfo[reg] & bit;
+}
+
+static bool copy_os_supports(uint32_t xcr0_mask)
+{
+	uint32_t eax, edx;
+
+	if (!copy_cpu_supports(0x1, COPY_OSXSAVE_REG, COPY_OSXSAVE_BIT))
+		return false;
+
+	asm volatile("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return (eax & xcr0_mask) == xcr0_mask;
+}
+
+static bool copy_has_erms(void)
+{
+	return copy_cpu_supports(0x7, COPY_ERMS_REG, COPY_ERMS_BIT);
+}
+
+bool ofi_cpu_has_avx2(void)
+{
+	return copy_cpu_supports(0x7, COPY_AVX2_REG, COPY_AVX2_BIT) &&
+	       copy_os_supports(COPY_XCR0_AVX);
+}
+
+bool ofi_cpu_has_avx512(void)
+{
+	return copy_cpu_supports(0x7, COPY_AVX512F_REG, COPY_AVX512F_BIT) &&
+	       copy_os_supports(COPY_XCR0_AVX512);
+}
+
+static void *copy_movsb(void *dest, const void *src, size_t len)
+{
+	void *ret = dest;
+
+	asm volatile("rep movsb"
+		     : "+D" (dest), "+S" (src), "+c" (len) : : "memory");
+	return ret;
+}
+
+/*
+ * Streaming stores must be aligned to the vector width, so the head of
+ * the destination up to the first aligned address and the tail after the
+ * last full block are copied with memcpy.
+ */
+static size_t copy_head(char **dest, const char **src, size_t len,
+			size_t align)
+{
+	size_t head;
+
+	head = (align - ((uintptr_t) *dest & (align - 1))) & (align - 1);
+	if (head > len)
+		head = len;
+	memcpy(*dest, *src, head);
+	*dest += head;
+	*src += head;
+	return len - head;
+}
+
+static void *copy_nt_sse2(void *dest, const void *src, size_t len)
+{
+	char *d = dest;
+	const char *s = src;
+	__m128i v0, v1, v2, v3;
+
+	len = copy_head(&d, &s, len, 16);
+	for (; len >= 64; len -= 64, d += 64, s += 64) {
+		v0 = _mm_loadu_si128((const __m128i *) s);
+		v1 = _mm_loadu_si128((const __m128i *) (s + 16));
+		v2 = _mm_loadu_si128((const __m128i *) (s + 32));
+		v3 = _mm_loadu_si128((const __m128i *) (s + 48));
+		_mm_stream_si128((__m128i *) d, v0);
+		_mm_stream_si128((__m128i *) (d + 16), v1);
+		_mm_stream_si128((__m128i *) (d + 32), v2);
+		_mm_stream_si128((__m128i *) (d + 48), v3);
+	}
+	_mm_sfence();
+	memcpy(d, s, len);
+	return dest;
+}
+
+__attribute__((target("avx2")))
+static void *copy_nt_avx2(void *dest, const void *src, size_t len)
+{
+	char *d = dest;
+	const char *s = src;
+	__m256i v0, v1, v2, v3;
+
+	len = copy_head(&d, &s, len, 32);
+	for (; len >= 128; len -= 128, d += 128, s += 128) {
+		v0 = _mm256_loadu_si256((const __m256i *) s);
+		v1 = _mm256_loadu_si256((const __m256i *) (s + 32));
+		v2 = _mm256_loadu_si256((const __m256i *) (s + 64));
+		v3 = _mm256_loadu_si256((const __m256i *) (s + 96));
+		_mm256_stream_si256((__m256i *) d, v0);
+		_mm256_stream_si256((__m256i *) (d + 32), v1);
+		_mm256_stream_si256((__m256i *) (d + 64), v2);
+		_mm256_stream_si256((__m256i *) (d + 96), v3);
+	}
+	_mm_sfence();
+	memcpy(d, s, len);
+	return dest;
+}
+
+__attribute__((target("avx512f")))
+static void *copy_nt_avx512(void *dest, const void *src, size_t len)
+{
+	char *d = dest;
+	const char *s = src;
+	__m512i v0, v1, v2, v3;
+
+	len = copy_head(&d, &s, len, 64);
+	for (; len >= 256; len -= 256, d += 256, s += 256) {
+		v0 = _mm512_loadu_si512((const void *) s);
+		v1 = _mm512_loadu_si512((const void *) (s + 64));
+		v2 = _mm512_loadu_si512((const void *) (s + 128));
+		v3 = _mm512_loadu_si512((const void *) (s + 192));
+		_mm512_stream_si512((void *) d, v0);
+		_mm512_stream_si512((void *) (d + 64), v1);
+		_mm512_stream_si512((void *) (d + 128), v2);
+		_mm512_stream_si512((void *) (d + 192), v3);
+	}
+	_mm_sfence();
+	memcpy(d, s, len);
+	return dest;
+}
+
+/* In order of preference for "auto" */
+static struct ofi_copy_desc copy_kernels[] = {
+	{ "avx512", copy_nt_avx512, ofi_cpu_has_avx512 },
+	{ "avx2", copy_nt_avx2, ofi_cpu_has_avx2 },
+	{ "sse2", copy_nt_sse2, copy_always },
+	{ "movsb", copy_movsb, copy_has_erms },
+	{ "memcpy", memcpy, copy_always },
+};
+
+#else
+
+bool ofi_cpu_has_avx2(void)
+{
+	return false;
+}
+
+bool ofi_cpu_has_avx512(void)
+{
+	return false;
+}
+
+static struct ofi_copy_desc copy_kernels[] = {
+	{ "memcpy", memcpy, copy_always },
+};
+
+#endif
+
+static size_t copy_default_threshold(void)
+{
+	long llc = -1;
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+	llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+	if (llc <= 0)
+		return OFI_COPY_THRESHOLD_DEF;
+
+	/* a copy this large would displace half of the shared cache */
+	return MAX((size_t) llc / 2, OFI_COPY_THRESHOLD_MIN);
+}
+
+int ofi_copy_init(const char *kernel, size_t threshold)
+{
+	struct ofi_copy_desc *desc = NULL;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(copy_kernels); i++) {
+		if (kernel && *kernel && strcasecmp(kernel, "auto") &&
+		    strcasecmp(kernel, copy_kernels[i].name))
+			continue;
+		if (copy_kernels[i].supported()) {
+			desc = &copy_kernels[i];
+			break;
+		}
+	}
+
+	if (!desc)
+		return -FI_ENOSYS;
+
+	ofi_copy_kernel = desc->copy;
+	ofi_copy_kernel_name = desc->name;
+	if (ofi_copy_kernel == (ofi_copy_fn) memcpy)
+		ofi_copy_threshold = SIZE_MAX;
+	else
+		ofi_copy_threshold = threshold ? threshold :
+				     copy_default_threshold();
+	return 0;
+}
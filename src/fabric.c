@@ -50,6 +50,7 @@
 #include "ofi_prov.h"
 #include "ofi_perf.h"
 #include "ofi_hmem.h"
+#include "ofi_atomic.h"
 #include <rdma/fi_ext.h>
 
 #ifdef HAVE_LIBDL
@@ -785,6 +786,34 @@ static void ofi_hook_init(void)
 	hooks = ofi_split_and_alloc(param_val, ";", &hook_cnt);
 }
 
+static void ofi_copy_param_init(void)
+{
+	char *kernel = NULL;
+	size_t threshold = 0;
+
+	fi_param_define(NULL, "copy_kernel", FI_PARAM_STRING,
+			"Kernel used for large host memory copies, such as "
+			"shm SAR and inject copies.  Options: auto, avx512, "
+			"avx2, sse2 (non-temporal stores), movsb, memcpy "
+			"(default: auto)");
+	fi_param_define(NULL, "copy_threshold", FI_PARAM_SIZE_T,
+			"Copies of at least this many bytes use the copy "
+			"kernel, smaller ones use memcpy (default: half of "
+			"the last level cache)");
+	fi_param_get_str(NULL, "copy_kernel", &kernel);
+	fi_param_get_size_t(NULL, "copy_threshold", &threshold);
+
+	if (ofi_copy_init(kernel, threshold)) {
+		FI_WARN(&core_prov, FI_LOG_CORE,
+			"copy kernel %s not supported, using memcpy\n",
+			kernel);
+		return;
+	}
+	FI_INFO(&core_prov, FI_LOG_CORE,
+		"copy kernel %s, threshold %zu\n", ofi_copy_kernel_name,
+		ofi_copy_threshold);
+}
+
 static void ofi_hook_fini(void)
 {
 	if (hooks)
@@ -807,6 +836,8 @@ void fi_ini(void)
 	ofi_osd_init();
 	ofi_mem_init();
 	ofi_pmem_init();
+	ofi_copy_param_init();
+	ofi_atomic_init();
 	ofi_perf_init();
 	ofi_hook_init();
 	ofi_hmem_init();
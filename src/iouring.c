@@ -34,9 +34,45 @@
 #include "config.h"
 
 #include <liburing.h>
+#include <sys/resource.h>
 
 #include <ofi_net.h>
 
+static inline bool
+ofi_uring_fixed_file(struct ofi_sockapi_uring *uring, SOCKET sock)
+{
+	return (unsigned int) sock < uring->fixed_cnt &&
+	       uring->fixed_files[sock];
+}
+
+static inline void
+ofi_uring_set_fixed_file(struct ofi_sockapi_uring *uring,
+			 struct io_uring_sqe *sqe, SOCKET sock)
+{
+	if (ofi_uring_fixed_file(uring, sock))
+		sqe->flags |= IOSQE_FIXED_FILE;
+}
+
+/* Returns the fixed buffer index if buf is contained in the buffer
+ * registered with the socket, otherwise -1.
+ */
+static inline int
+ofi_uring_fixed_buf(struct ofi_sockapi_uring *uring, SOCKET sock,
+		    const void *buf, size_t len)
+{
+	struct iovec *iov;
+
+	if (!uring->fixed_bufs || !ofi_uring_fixed_file(uring, sock))
+		return -1;
+
+	iov = &uring->fixed_bufs[sock];
+	if (!iov->iov_base || (const char *) buf < (char *) iov->iov_base ||
+	    (const char *) buf + len > (char *) iov->iov_base + iov->iov_len)
+		return -1;
+
+	return (int) sock;
+}
+
 int ofi_sockapi_connect_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 			      const struct sockaddr *addr, socklen_t addrlen,
 			      struct ofi_sockctx *ctx)
@@ -87,19 +123,38 @@ ssize_t ofi_sockapi_send_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 {
 	struct io_uring_sqe *sqe;
 	struct ofi_sockapi_uring *uring;
+	bool zerocopy;
+	int idx;
 
 	uring = &sockapi->tx_uring;
 	if (ctx->uring_sqe_inuse || uring->credits == 0)
 		return -FI_EAGAIN;
 
 	/* MSG_NOSIGNAL would return ENOTSUP with io_uring */
-	flags &= ~MSG_NOSIGNAL;
+	zerocopy = (flags & OFI_ZEROCOPY) && uring->send_zc;
+	flags &= ~(MSG_NOSIGNAL | OFI_ZEROCOPY);
 
 	sqe = io_uring_get_sqe(uring->io_uring);
 	if (!sqe)
 		return -FI_EOVERFLOW;
 
-	io_uring_prep_send(sqe, sock, buf, len, flags);
+	idx = ofi_uring_fixed_buf(uring, sock, buf, len);
+#if HAVE_DECL_IO_URING_PREP_SENDMSG_ZC
+	if (zerocopy) {
+		if (idx >= 0)
+			io_uring_prep_send_zc_fixed(sqe, sock, buf, len, flags,
+						    0, idx);
+		else
+			io_uring_prep_send_zc(sqe, sock, buf, len, flags, 0);
+	} else
+#endif
+	if (idx >= 0) {
+		io_uring_prep_write_fixed(sqe, sock, buf, (unsigned int) len,
+					  0, idx);
+	} else {
+		io_uring_prep_send(sqe, sock, buf, len, flags);
+	}
+	ofi_uring_set_fixed_file(uring, sqe, sock);
 	io_uring_sqe_set_data(sqe, ctx);
 	ctx->uring_sqe_inuse = true;
 	uring->credits--;
@@ -112,19 +167,32 @@ ssize_t ofi_sockapi_sendv_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 {
 	struct io_uring_sqe *sqe;
 	struct ofi_sockapi_uring *uring;
+	bool zerocopy;
 
 	uring = &sockapi->tx_uring;
 	if (ctx->uring_sqe_inuse || uring->credits == 0)
 		return -FI_EAGAIN;
 
 	/* MSG_NOSIGNAL would return ENOTSUP with io_uring */
-	flags &= ~MSG_NOSIGNAL;
+	zerocopy = (flags & OFI_ZEROCOPY) && uring->send_zc;
+	flags &= ~(MSG_NOSIGNAL | OFI_ZEROCOPY);
 
 	sqe = io_uring_get_sqe(uring->io_uring);
 	if (!sqe)
 		return -FI_EOVERFLOW;
 
-	io_uring_prep_writev(sqe, sock, iov, cnt, flags);
+#if HAVE_DECL_IO_URING_PREP_SENDMSG_ZC
+	if (zerocopy) {
+		memset(&ctx->uring_msg, 0, sizeof(ctx->uring_msg));
+		ctx->uring_msg.msg_iov = (struct iovec *) iov;
+		ctx->uring_msg.msg_iovlen = cnt;
+		io_uring_prep_sendmsg_zc(sqe, sock, &ctx->uring_msg, flags);
+	} else
+#endif
+	{
+		io_uring_prep_writev(sqe, sock, iov, (unsigned int) cnt, flags);
+	}
+	ofi_uring_set_fixed_file(uring, sqe, sock);
 	io_uring_sqe_set_data(sqe, ctx);
 	ctx->uring_sqe_inuse = true;
 	uring->credits--;
@@ -137,6 +205,7 @@ ssize_t ofi_sockapi_recv_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 {
 	struct io_uring_sqe *sqe;
 	struct ofi_sockapi_uring *uring;
+	int idx;
 
 	uring = &sockapi->rx_uring;
 	if (ctx->uring_sqe_inuse || uring->credits == 0)
@@ -146,7 +215,13 @@ ssize_t ofi_sockapi_recv_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 	if (!sqe)
 		return -FI_EOVERFLOW;
 
-	io_uring_prep_recv(sqe, sock, buf, len, flags);
+	idx = ofi_uring_fixed_buf(uring, sock, buf, len);
+	if (idx >= 0)
+		io_uring_prep_read_fixed(sqe, sock, buf, (unsigned int) len,
+					 0, idx);
+	else
+		io_uring_prep_recv(sqe, sock, buf, len, flags);
+	ofi_uring_set_fixed_file(uring, sqe, sock);
 	io_uring_sqe_set_data(sqe, ctx);
 	ctx->uring_sqe_inuse = true;
 	uring->credits--;
@@ -169,6 +244,7 @@ ssize_t ofi_sockapi_recvv_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 		return -FI_EOVERFLOW;
 
 	io_uring_prep_readv(sqe, sock, iov, cnt, flags);
+	ofi_uring_set_fixed_file(uring, sqe, sock);
 	io_uring_sqe_set_data(sqe, ctx);
 	ctx->uring_sqe_inuse = true;
 	uring->credits--;
@@ -215,12 +291,123 @@ int ofi_sockctx_uring_poll_add(struct ofi_sockapi_uring *uring,
 		io_uring_prep_poll_multishot(sqe, fd, poll_mask);
 	else
 		io_uring_prep_poll_add(sqe, fd, poll_mask);
+	ofi_uring_set_fixed_file(uring, sqe, fd);
+	io_uring_sqe_set_data(sqe, ctx);
+	ctx->uring_sqe_inuse = true;
+	uring->credits--;
+	return -OFI_EINPROGRESS_URING;
+}
+
+#if HAVE_DECL_IO_URING_SETUP_BUF_RING && HAVE_DECL_IO_URING_PREP_RECV_MULTISHOT
+int ofi_sockctx_uring_recv_multishot(struct ofi_sockapi_uring *uring, int fd,
+				     struct ofi_uring_buf_ring *buf_ring,
+				     struct ofi_sockctx *ctx)
+{
+	struct io_uring_sqe *sqe;
+
+	if (ctx->uring_sqe_inuse || uring->credits == 0)
+		return -FI_EAGAIN;
+
+	sqe = io_uring_get_sqe(uring->io_uring);
+	if (!sqe)
+		return -FI_EOVERFLOW;
+
+	io_uring_prep_recv_multishot(sqe, fd, NULL, 0, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = buf_ring->bgid;
+	ofi_uring_set_fixed_file(uring, sqe, fd);
 	io_uring_sqe_set_data(sqe, ctx);
 	ctx->uring_sqe_inuse = true;
 	uring->credits--;
 	return -OFI_EINPROGRESS_URING;
 }
 
+int ofi_uring_buf_ring_init(ofi_io_uring_t *io_uring,
+			    struct ofi_uring_buf_ring *buf_ring, uint16_t bgid,
+			    unsigned int count, size_t buf_size)
+{
+	struct io_uring_buf_ring *br;
+	unsigned int i;
+	int ret;
+
+	/* The kernel requires a power of 2 number of ring entries */
+	if (!count || (count & (count - 1)) || count > 32768)
+		return -FI_EINVAL;
+
+	buf_ring->bufs = malloc(count * buf_size);
+	if (!buf_ring->bufs)
+		return -FI_ENOMEM;
+
+	br = io_uring_setup_buf_ring(io_uring, count, bgid, 0, &ret);
+	if (!br) {
+		free(buf_ring->bufs);
+		buf_ring->bufs = NULL;
+		return ret;
+	}
+
+	buf_ring->ring = br;
+	buf_ring->buf_size = buf_size;
+	buf_ring->count = count;
+	buf_ring->mask = io_uring_buf_ring_mask(count);
+	buf_ring->bgid = bgid;
+
+	for (i = 0; i < count; i++) {
+		io_uring_buf_ring_add(br, ofi_uring_buf_ring_buf(buf_ring, i),
+				      (unsigned int) buf_size, (unsigned short) i,
+				      buf_ring->mask, (int) i);
+	}
+	io_uring_buf_ring_advance(br, (int) count);
+	return 0;
+}
+
+void ofi_uring_buf_ring_destroy(ofi_io_uring_t *io_uring,
+				struct ofi_uring_buf_ring *buf_ring)
+{
+	if (!buf_ring->ring)
+		return;
+
+	io_uring_free_buf_ring(io_uring, buf_ring->ring, buf_ring->count,
+			       buf_ring->bgid);
+	free(buf_ring->bufs);
+	buf_ring->ring = NULL;
+	buf_ring->bufs = NULL;
+}
+
+void ofi_uring_buf_ring_recycle(struct ofi_uring_buf_ring *buf_ring,
+				unsigned int bid)
+{
+	io_uring_buf_ring_add(buf_ring->ring,
+			      ofi_uring_buf_ring_buf(buf_ring, bid),
+			      (unsigned int) buf_ring->buf_size,
+			      (unsigned short) bid, buf_ring->mask, 0);
+	io_uring_buf_ring_advance(buf_ring->ring, 1);
+}
+#else
+int ofi_sockctx_uring_recv_multishot(struct ofi_sockapi_uring *uring, int fd,
+				     struct ofi_uring_buf_ring *buf_ring,
+				     struct ofi_sockctx *ctx)
+{
+	return -FI_ENOSYS;
+}
+
+int ofi_uring_buf_ring_init(ofi_io_uring_t *io_uring,
+			    struct ofi_uring_buf_ring *buf_ring, uint16_t bgid,
+			    unsigned int count, size_t buf_size)
+{
+	return -FI_ENOSYS;
+}
+
+void ofi_uring_buf_ring_destroy(ofi_io_uring_t *io_uring,
+				struct ofi_uring_buf_ring *buf_ring)
+{
+}
+
+void ofi_uring_buf_ring_recycle(struct ofi_uring_buf_ring *buf_ring,
+				unsigned int bid)
+{
+}
+#endif
+
 int ofi_uring_init(ofi_io_uring_t *io_uring, size_t entries)
 {
 	struct io_uring_params params;
@@ -252,3 +439,145 @@ int ofi_uring_destroy(ofi_io_uring_t *io_uring)
 	return 0;
 }
 
+bool ofi_uring_send_zc_supported(ofi_io_uring_t *io_uring)
+{
+#if HAVE_DECL_IO_URING_PREP_SENDMSG_ZC
+	struct io_uring_probe *probe;
+	bool ret;
+
+	probe = io_uring_get_probe_ring(io_uring);
+	if (!probe)
+		return false;
+
+	ret = io_uring_opcode_supported(probe, IORING_OP_SEND_ZC) &&
+	      io_uring_opcode_supported(probe, IORING_OP_SENDMSG_ZC);
+	io_uring_free_probe(probe);
+	return ret;
+#else
+	return false;
+#endif
+}
+
+#if HAVE_DECL_IO_URING_REGISTER_FILES_SPARSE && \
+    HAVE_DECL_IO_URING_REGISTER_BUFFERS_SPARSE
+int ofi_sockapi_uring_init_fixed(struct ofi_sockapi_uring *uring,
+				 unsigned int count)
+{
+	struct rlimit rlim;
+	int ret;
+
+	/* The file table cannot exceed the open file limit */
+	if (!getrlimit(RLIMIT_NOFILE, &rlim) && rlim.rlim_cur < count)
+		count = (unsigned int) rlim.rlim_cur;
+
+	uring->fixed_files = calloc(count, sizeof(*uring->fixed_files));
+	if (!uring->fixed_files)
+		return -FI_ENOMEM;
+
+	ret = io_uring_register_files_sparse(uring->io_uring, count);
+	if (ret) {
+		free(uring->fixed_files);
+		uring->fixed_files = NULL;
+		return ret;
+	}
+
+	/* Fixed buffers are optional */
+	uring->fixed_bufs = calloc(count, sizeof(*uring->fixed_bufs));
+	if (uring->fixed_bufs &&
+	    io_uring_register_buffers_sparse(uring->io_uring, count)) {
+		free(uring->fixed_bufs);
+		uring->fixed_bufs = NULL;
+	}
+
+	uring->fixed_cnt = count;
+	return 0;
+}
+
+void ofi_sockapi_uring_cleanup_fixed(struct ofi_sockapi_uring *uring)
+{
+	if (!uring->fixed_cnt)
+		return;
+
+	if (uring->fixed_bufs) {
+		(void) io_uring_unregister_buffers(uring->io_uring);
+		free(uring->fixed_bufs);
+		uring->fixed_bufs = NULL;
+	}
+
+	(void) io_uring_unregister_files(uring->io_uring);
+	free(uring->fixed_files);
+	uring->fixed_files = NULL;
+	uring->fixed_cnt = 0;
+}
+
+int ofi_sockapi_uring_register(struct ofi_sockapi_uring *uring, SOCKET sock,
+			       void *buf, size_t len)
+{
+	struct iovec iov;
+	__u64 tag = 0;
+	int ret;
+
+	if ((unsigned int) sock >= uring->fixed_cnt)
+		return -FI_ENOSPC;
+
+	ret = io_uring_register_files_update(uring->io_uring, sock, &sock, 1);
+	if (ret < 0)
+		return ret;
+
+	uring->fixed_files[sock] = 1;
+	if (uring->fixed_bufs && buf) {
+		iov.iov_base = buf;
+		iov.iov_len = len;
+		ret = io_uring_register_buffers_update_tag(uring->io_uring, sock,
+							   &iov, &tag, 1);
+		if (ret >= 0)
+			uring->fixed_bufs[sock] = iov;
+	}
+	return 0;
+}
+
+/* The ring holds a reference on registered files, so a socket must be
+ * unregistered for the connection to be released when it is closed.
+ */
+void ofi_sockapi_uring_unregister(struct ofi_sockapi_uring *uring,
+				  SOCKET sock)
+{
+	struct iovec iov = {0};
+	__u64 tag = 0;
+	int fd = -1;
+
+	if (!ofi_uring_fixed_file(uring, sock))
+		return;
+
+	if (uring->fixed_bufs && uring->fixed_bufs[sock].iov_base) {
+		(void) io_uring_register_buffers_update_tag(uring->io_uring,
+							    sock, &iov, &tag, 1);
+		uring->fixed_bufs[sock] = iov;
+	}
+
+	(void) io_uring_register_files_update(uring->io_uring, sock, &fd, 1);
+	uring->fixed_files[sock] = 0;
+}
+#else
+int ofi_sockapi_uring_init_fixed(struct ofi_sockapi_uring *uring,
+				 unsigned int count)
+{
+	return -FI_ENOSYS;
+}
+
+void ofi_sockapi_uring_cleanup_fixed(struct ofi_sockapi_uring *uring)
+{
+}
+
+int ofi_sockapi_uring_register(struct ofi_sockapi_uring *uring, SOCKET sock,
+			       void *buf, size_t len)
+{
+	return -FI_ENOSYS;
+}
+
+void ofi_sockapi_uring_unregister(struct ofi_sockapi_uring *uring,
+				  SOCKET sock)
+{
+}
+#endif
+
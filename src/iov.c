@@ -36,6 +36,7 @@
 
 #include <ofi.h>
 #include <ofi_iov.h>
+#include <ofi_copy.h>
 
 uint64_t ofi_copy_iov_buf(const struct iovec *iov, size_t iov_count, uint64_t iov_offset,
 			  void *buf, uint64_t bufsize, int dir)
@@ -51,9 +52,9 @@ uint64_t ofi_copy_iov_buf(const struct iovec *iov, size_t iov_count, uint64_t io
 			continue;
 
 		if (dir == OFI_COPY_BUF_TO_IOV)
-			memcpy(iov_buf, (char *) buf + done, len);
+			ofi_copy(iov_buf, (char *) buf + done, len);
 		else if (dir == OFI_COPY_IOV_TO_BUF)
-			memcpy((char *) buf + done, iov_buf, len);
+			ofi_copy((char *) buf + done, iov_buf, len);
 
 		done += len;
 	}
@@ -195,6 +195,12 @@ int ofi_pmu_open(struct ofi_perf_ctx **ctx, enum ofi_perf_domain domain,
 	if (!*ctx)
 		return -FI_ENOMEM;
 
+	/* The time stamp counter is read directly and is not per thread */
+	if (domain == OFI_PMU_CPU && cntr_id == OFI_PMC_CPU_TSC) {
+		(*ctx)->tsc = true;
+		return 0;
+	}
+
 	switch(domain) {
 	case OFI_PMU_CPU:
 		attr.type = PERF_TYPE_HARDWARE;
@@ -221,11 +227,14 @@ int ofi_pmu_open(struct ofi_perf_ctx **ctx, enum ofi_perf_domain domain,
 
 inline uint64_t ofi_pmu_read(struct ofi_perf_ctx *ctx)
 {
+	if (ctx->tsc)
+		return __builtin_ia32_rdtsc();
 	return rdpmc_read(&ctx->ctx);
 }
 
 inline void ofi_pmu_close(struct ofi_perf_ctx *ctx)
 {
-	rdpmc_close(&ctx->ctx);
+	if (!ctx->tsc)
+		rdpmc_close(&ctx->ctx);
 	free(ctx);
 }
@@ -46,6 +46,8 @@
 enum ofi_perf_domain	perf_domain = OFI_PMU_CPU;
 uint32_t		perf_cntr = OFI_PMC_CPU_INSTR;
 uint32_t		perf_flags;
+enum ofi_perf_hist_mode	perf_hist = OFI_PERF_HIST_NONE;
+int			perf_dump_signal;
 
 
 void ofi_perf_init(void)
@@ -54,7 +56,30 @@ void ofi_perf_init(void)
 
 	fi_param_define(NULL, "perf_cntr", FI_PARAM_STRING,
 			"Performance counter to analyze (default: cpu_instr). "
-			"Options: cpu_instr, cpu_cycles.");
+			"Options: cpu_instr, cpu_cycles, tsc.");
+	fi_param_define(NULL, "perf_hist", FI_PARAM_STRING,
+			"Record a histogram of the performance counter for "
+			"each call, and report the median and tail "
+			"percentiles (default: none).  Options: none, op, "
+			"size.  'size' keeps separate histograms by transfer "
+			"size for data transfer calls.");
+	fi_param_define(NULL, "perf_dump_signal", FI_PARAM_INT,
+			"Signal number which causes the perf hook to log its "
+			"performance data on the next completion queue or "
+			"counter read, in addition to when the fabric is "
+			"closed (default: 0, disabled).");
+
+	fi_param_get_int(NULL, "perf_dump_signal", &perf_dump_signal);
+
+	fi_param_get_str(NULL, "perf_hist", &param_val);
+	if (param_val) {
+		if (!strcasecmp(param_val, "op"))
+			perf_hist = OFI_PERF_HIST_OP;
+		else if (!strcasecmp(param_val, "size"))
+			perf_hist = OFI_PERF_HIST_SIZE_BUCKET;
+		param_val = NULL;
+	}
+
 	fi_param_get_str(NULL, "perf_cntr", &param_val);
 	if (!param_val)
 		return;
@@ -62,9 +87,47 @@ void ofi_perf_init(void)
 	if (!strcasecmp(param_val, "cpu_cycles")) {
 		perf_domain = OFI_PMU_CPU;
 		perf_cntr = OFI_PMC_CPU_CYCLES;
+	} else if (!strcasecmp(param_val, "tsc")) {
+		perf_domain = OFI_PMU_CPU;
+		perf_cntr = OFI_PMC_CPU_TSC;
 	}
 }
 
+/* Upper bound of the values counted by a histogram bucket */
+static uint64_t ofi_perf_hist_value(size_t index)
+{
+	size_t sub = index & ((1 << OFI_PERF_HIST_SUB_BITS) - 1);
+	int shift;
+
+	if (index < (1 << OFI_PERF_HIST_SUB_BITS))
+		return index;
+
+	shift = (int) (index >> OFI_PERF_HIST_SUB_BITS) - 1;
+	return (((uint64_t) (1 << OFI_PERF_HIST_SUB_BITS) + sub + 1) <<
+		shift) - 1;
+}
+
+uint64_t ofi_perf_hist_percentile(const uint64_t *hist, uint64_t events,
+				  double pct)
+{
+	uint64_t target, cnt = 0;
+	size_t i;
+
+	if (!events)
+		return 0;
+
+	target = (uint64_t) (events * pct / 100);
+	if (target >= events)
+		target = events - 1;
+
+	for (i = 0; i < OFI_PERF_HIST_SIZE; i++) {
+		cnt += hist[i];
+		if (cnt > target)
+			return ofi_perf_hist_value(i);
+	}
+	return ofi_perf_hist_value(OFI_PERF_HIST_SIZE - 1);
+}
+
 int ofi_perfset_create(const struct fi_provider *prov,
 		       struct ofi_perfset *set, size_t size,
 		       enum ofi_perf_domain domain, uint32_t cntr_id,
@@ -85,6 +148,21 @@ int ofi_perfset_create(const struct fi_provider *prov,
 		return -FI_ENOMEM;
 	}
 
+	set->hist = NULL;
+	set->hist_slots = 0;
+	if (perf_hist != OFI_PERF_HIST_NONE) {
+		/* The last slot records operations without a size */
+		set->hist_slots = (perf_hist == OFI_PERF_HIST_SIZE_BUCKET) ?
+				  OFI_PERF_SIZE_MAX + 1 : 1;
+		set->hist = calloc(size * set->hist_slots * OFI_PERF_HIST_SIZE,
+				   sizeof(*set->hist));
+		if (!set->hist) {
+			free(set->data);
+			ofi_pmu_close(set->ctx);
+			return -FI_ENOMEM;
+		}
+	}
+
 	set->prov = prov;
 	set->size = size;
 	return 0;
@@ -93,6 +171,7 @@ int ofi_perfset_create(const struct fi_provider *prov,
 void ofi_perfset_close(struct ofi_perfset *set)
 {
 	ofi_pmu_close(set->ctx);
+	free(set->hist);
 	free(set->data);
 }
 
@@ -105,6 +184,8 @@ static const char *ofi_perf_name(void)
 			return "CPU cycles";
 		case OFI_PMC_CPU_INSTR:
 			return "CPU instr";
+		case OFI_PMC_CPU_TSC:
+			return "TSC";
 		}
 		break;
 	case OFI_PMU_CACHE:
@@ -131,10 +212,42 @@ static const char *ofi_perf_name(void)
 	return "unknown";
 }
 
-void ofi_perfset_log(struct ofi_perfset *set, const char *names[])
+static const char *ofi_perf_size_str[OFI_PERF_SIZE_MAX] = {
+	[OFI_PERF_SIZE_0_64]	 = "0-64",
+	[OFI_PERF_SIZE_64_512]	 = "64-512",
+	[OFI_PERF_SIZE_512_1K]	 = "512-1K",
+	[OFI_PERF_SIZE_1K_4K]	 = "1K-4K",
+	[OFI_PERF_SIZE_4K_64K]	 = "4K-64K",
+	[OFI_PERF_SIZE_64K_256K] = "64K-256K",
+	[OFI_PERF_SIZE_256K_1M]	 = "256K-1M",
+	[OFI_PERF_SIZE_1M_4M]	 = "1M-4M",
+	[OFI_PERF_SIZE_4M_UP]	 = "4M+",
+};
+
+static void ofi_perfset_log_hist(struct ofi_perfset *set, const char *name,
+				 const char *size, const uint64_t *hist)
 {
+	uint64_t events = 0;
 	size_t i;
 
+	for (i = 0; i < OFI_PERF_HIST_SIZE; i++)
+		events += hist[i];
+	if (!events)
+		return;
+
+	FI_TRACE(set->prov, FI_LOG_CORE, "\t%-20s%-10s%-10" PRIu64
+		 "%-10" PRIu64 "%-10" PRIu64 "%" PRIu64 "\n", name, size,
+		 ofi_perf_hist_percentile(hist, events, 50),
+		 ofi_perf_hist_percentile(hist, events, 99),
+		 ofi_perf_hist_percentile(hist, events, 99.9),
+		 events);
+}
+
+void ofi_perfset_log(struct ofi_perfset *set, const char *names[])
+{
+	const char *name;
+	size_t i, slot;
+
 	FI_TRACE(set->prov, FI_LOG_CORE, "\n");
 	FI_TRACE(set->prov, FI_LOG_CORE, "\tPERF: %s\n", ofi_perf_name());
 	FI_TRACE(set->prov, FI_LOG_CORE, "\t%-20s%-10s%s\n", "Name", "Avg", "Events");
@@ -148,4 +261,24 @@ void ofi_perfset_log(struct ofi_perfset *set, const char *names[])
 			(double) set->data[i].sum / set->data[i].events,
 			set->data[i].events);
 	}
+
+	if (!set->hist)
+		return;
+
+	FI_TRACE(set->prov, FI_LOG_CORE, "\n");
+	FI_TRACE(set->prov, FI_LOG_CORE, "\t%-20s%-10s%-10s%-10s%-10s%s\n",
+		 "Name", "Size", "p50", "p99", "p99.9", "Events");
+
+	for (i = 0; i < set->size; i++) {
+		if (!set->data[i].events)
+			continue;
+
+		name = names && names[i] ? names[i] : "unknown";
+		for (slot = 0; slot < set->hist_slots; slot++) {
+			ofi_perfset_log_hist(set, name,
+					     slot < set->hist_slots - 1 ?
+					     ofi_perf_size_str[slot] : "all",
+					     ofi_perfset_hist(set, i, slot));
+		}
+	}
 }
@@ -432,3 +432,40 @@ struct ofi_rbnode *ofi_rbmap_search(struct ofi_rbmap *map, void *key,
 	}
 	return NULL;
 }
+
+struct ofi_rbnode *ofi_rbmap_search_first(struct ofi_rbmap *map, void *key,
+		int (*compare)(struct ofi_rbmap *map, void *key, void *data))
+{
+	struct ofi_rbnode *node, *first = NULL;
+	int ret;
+
+	node = map->root;
+	while (node != &map->sentinel) {
+		ret = compare(map, key, node->data);
+		if (ret == 0)
+			first = node;
+
+		node = (ret <= 0) ? node->left : node->right;
+	}
+	return first;
+}
+
+struct ofi_rbnode *ofi_rbmap_next(struct ofi_rbmap *map,
+		struct ofi_rbnode *node)
+{
+	struct ofi_rbnode *parent;
+
+	if (node->right != &map->sentinel) {
+		node = node->right;
+		while (node->left != &map->sentinel)
+			node = node->left;
+		return node;
+	}
+
+	parent = node->parent;
+	while (parent && node == parent->right) {
+		node = parent;
+		parent = parent->parent;
+	}
+	return parent;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2024 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Microbenchmark for the host copy kernels in src/copy.c.
+ *
+ * For each kernel and size it reports the copy bandwidth and the time
+ * needed afterwards to re-read a cache resident working set, which shows
+ * how much of the caller's cache the copy displaced.
+ */
+
+#include "config.h"
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+
+#include <ofi_copy.h>
+
+static const char *kernels[] = {
+	"memcpy", "movsb", "sse2", "avx2", "avx512",
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t read_ws(const volatile uint64_t *ws, size_t len)
+{
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < len / sizeof(*ws); i += 8)
+		sum += ws[i];
+	return sum;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void usage(const char *argv0)
+{
+	printf("Usage: %s [-S max_size] [-w ws_size] [-i iterations] "
+	       "[-k kernel]\n", argv0);
+	printf("\t-S\tlargest copy size in bytes (default 64 MiB)\n");
+	printf("\t-w\tworking set re-read after each copy (default 1 MiB)\n");
+	printf("\t-i\titerations per size, the median is reported "
+	       "(default 21)\n");
+	printf("\t-k\tonly run the named kernel\n");
+}
+
+int main(int argc, char *argv[])
+{
+	size_t max_size = 64 << 20, ws_size = 1 << 20, size;
+	char *src, *dst, *ws;
+	const char *only = NULL;
+	uint64_t start, *copy_ns, *ws_ns, sum = 0;
+	int iters = 21, i, op;
+	size_t k;
+
+	while ((op = getopt(argc, argv, "S:w:i:k:h")) != -1) {
+		switch (op) {
+		case 'S':
+			max_size = strtoull(optarg, NULL, 0);
+			break;
+		case 'w':
+			ws_size = strtoull(optarg, NULL, 0);
+			break;
+		case 'i':
+			iters = MAX(atoi(optarg), 1);
+			break;
+		case 'k':
+			only = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return op == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	src = malloc(max_size);
+	dst = malloc(max_size);
+	ws = malloc(ws_size);
+	copy_ns = calloc(iters, sizeof(*copy_ns));
+	ws_ns = calloc(iters, sizeof(*ws_ns));
+	if (!src || !dst || !ws || !copy_ns || !ws_ns) {
+		fprintf(stderr, "unable to allocate buffers\n");
+		return EXIT_FAILURE;
+	}
+	memset(src, 0xa5, max_size);
+	memset(dst, 0, max_size);
+	memset(ws, 1, ws_size);
+
+	printf("%-8s %10s %12s %14s\n", "kernel", "bytes", "copy MB/s",
+	       "ws reread us");
+	for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+		if (only && strcmp(only, kernels[k]))
+			continue;
+		/* threshold 1 routes every copy through the kernel */
+		if (ofi_copy_init(kernels[k], 1)) {
+			printf("%-8s %10s\n", kernels[k], "unsupported");
+			continue;
+		}
+
+		for (size = 4096; size <= max_size; size <<= 2) {
+			for (i = 0; i < iters; i++) {
+				sum += read_ws((uint64_t *) ws, ws_size);
+
+				start = now_ns();
+				ofi_copy(dst, src, size);
+				copy_ns[i] = now_ns() - start;
+
+				start = now_ns();
+				sum += read_ws((uint64_t *) ws, ws_size);
+				ws_ns[i] = now_ns() - start;
+			}
+			qsort(copy_ns, iters, sizeof(*copy_ns), cmp_u64);
+			qsort(ws_ns, iters, sizeof(*ws_ns), cmp_u64);
+			printf("%-8s %10zu %12.1f %14.2f\n", kernels[k], size,
+			       (double) size * 1000 / copy_ns[iters / 2],
+			       (double) ws_ns[iters / 2] / 1000);
+		}
+	}
+
+	free(ws_ns);
+	free(copy_ns);
+	free(ws);
+	free(dst);
+	free(src);
+	return sum ? EXIT_SUCCESS : EXIT_FAILURE;
+}